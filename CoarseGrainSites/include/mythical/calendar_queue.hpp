@@ -0,0 +1,110 @@
+#ifndef MYTHICAL_CALENDAR_QUEUE_HPP
+#define MYTHICAL_CALENDAR_QUEUE_HPP
+
+#include "queue.hpp"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace mythical {
+
+/**
+ * \brief Bucketed event queue for walkers whose dwell times span many orders
+ * of magnitude
+ *
+ * Walkers are hashed into buckets by the window of time they hop in, much
+ * like days on a calendar, so adding and popping a walker takes constant
+ * time on average regardless of how many walkers are stored. Walkers that
+ * hop after the end of the current year of the calendar wait in a binary
+ * heap and are moved onto the calendar when it runs empty, at which point
+ * the width of the buckets is estimated again from the earliest walkers.
+ * This keeps the queue efficient when the dwell times drift over many
+ * orders of magnitude.
+ *
+ * Has the same interface as the sorted Queue, walker ids must be positive
+ * and a walker can only be stored once.
+ **/
+class CalendarQueue {
+ public:
+  CalendarQueue();
+
+  /**
+   * \brief Add a walker to the queue
+   **/
+  void sortedAdd(std::pair<int,double> walker);
+
+  /**
+   * \brief Remove the walker with the smallest time
+   **/
+  std::pair<int,double> pop();
+
+  /**
+   * \brief Same as pop, the calendar queue is always sorted
+   **/
+  std::pair<int,double> pop_current() { return pop(); }
+
+  /**
+   * \brief Walker with the smallest time
+   **/
+  const std::pair<int,double> & peek();
+
+  /**
+   * \brief Change the time of a walker already in the queue
+   **/
+  void update(std::pair<int,double> walker);
+
+  /**
+   * \brief Remove a walker from the queue
+   **/
+  void erase(const int walker_id);
+
+  /**
+   * \brief Determine if the walker is in the queue
+   **/
+  bool contains(const int walker_id) const noexcept;
+
+  std::size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0; }
+
+  std::size_t getNumberOfBuckets() const noexcept { return buckets_.size(); }
+  double getBucketWidth() const noexcept { return width_; }
+ private:
+  /// Walkers in each bucket, sorted by decreasing time so the earliest
+  /// walker of the bucket is at the back
+  std::vector<std::vector<std::pair<int,double>>> buckets_;
+
+  /// Time of each walker indexed by the walker id
+  std::vector<double> time_of_;
+  std::vector<bool> in_queue_;
+
+  /// Walkers hopping after the end of the current year
+  Queue later_walkers_;
+
+  std::size_t size_;
+  std::size_t calendar_size_;
+
+  /// Span of time covered by a single bucket
+  double width_;
+
+  /// Window of time the search for the next walker starts from, no walker
+  /// on the calendar hops in an earlier window
+  double current_window_;
+  std::size_t current_bucket_;
+
+  /// First window after the end of the current year
+  double year_end_;
+
+  double windowOf_(const double time) const;
+  std::size_t bucketOf_(const double window) const;
+  void insert_(const std::pair<int,double> & walker);
+  void remove_(const int walker_id);
+  void startYear_(const double window);
+  void estimateWidth_(std::vector<double> & times);
+  std::size_t findEarliestBucket_();
+  void refill_();
+  void resize_(const std::size_t number_of_buckets);
+  void checkId_(const int walker_id);
+};
+}
+#endif  // MYTHICAL_CALENDAR_QUEUE_HPP
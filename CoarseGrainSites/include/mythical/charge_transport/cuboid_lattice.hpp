@@ -3,6 +3,8 @@
 
 #include "boundarysettings.hpp"
 
+#include <cstddef>
+#include <functional>
 #include <random>
 #include <unordered_map>
 #include <vector>
@@ -10,6 +12,32 @@
 namespace mythical {
 
   namespace charge_transport {
+
+    /**
+     * \brief Neighbors of every site of a lattice stored in compressed rows
+     *
+     * The neighbors of site index are found between row_offsets[index] and
+     * row_offsets[index+1] in neighbor_indices, the distances to them are
+     * stored at the same positions in distances.
+     **/
+    struct NeighborList {
+      std::vector<size_t> row_offsets;
+      std::vector<int> neighbor_indices;
+      std::vector<double> distances;
+    };
+
+    class NeighborStencil;
+
+    /**
+     * \brief Called once for every site of the lattice with the indices of
+     * and distances to its neighbors
+     *
+     * The vectors are reused between sites and should be copied if they are
+     * needed after the call.
+     **/
+    typedef std::function<void(const int index,
+        const std::vector<int> & neighbor_indices,
+        const std::vector<double> & distances)> NeighborVisitor;
    
     /**
      * \brief Cuboid class is a support class meant to help with charge transport
@@ -101,6 +129,38 @@ namespace mythical {
          */
         std::unordered_map<int, std::unordered_map<int, double>> getNeighborDistances(const double cutoff) const;
 
+        /**
+         * @brief Stream the neighbors within cutoff of every site
+         *
+         * The neighbors are found with a NeighborStencil built once. The lattice is split
+         * into slabs along x, each visited by its own thread, so the visitor
+         * is called concurrently for different sites when thread_count is
+         * larger than 1. A neighbor reached through more than one periodic
+         * image is reported once with the smallest distance.
+         *
+         * @param cutoff
+         * @param visitor - called for every site
+         * @param thread_count - a value of 0 uses every hardware thread
+         */
+        void visitNeighborDistances(const double cutoff,
+            NeighborVisitor visitor,
+            int thread_count = 1) const;
+
+        /**
+         * @brief Get Neighbor Distances within cutoff for the whole lattice in
+         * compressed rows
+         *
+         * Takes a fraction of the memory of the map, the neighbors of a site
+         * are listed in both directions.
+         *
+         * @param cutoff
+         * @param thread_count - a value of 0 uses every hardware thread
+         *
+         * @return the neighbor list
+         */
+        NeighborList getNeighborList(const double cutoff,
+            int thread_count = 1) const;
+
         /**
          * @brief Get the distance between two sites
          *
@@ -147,6 +207,11 @@ namespace mythical {
 
         std::vector<std::pair<int,double>> getNeighborDistances_(const std::vector<int> lattice_pos, const double cutoff) const;
 
+        void visitSlab_(const NeighborStencil & stencil,
+            const int x_begin,
+            const int x_end,
+            const NeighborVisitor & visitor) const;
+
 
     };
   }
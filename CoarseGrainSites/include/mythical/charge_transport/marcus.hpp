@@ -1,6 +1,10 @@
 #ifndef MYTHICAL_CHARGE_TRANSPORT_MARCUS_HPP
 #define MYTHICAL_CHARGE_TRANSPORT_MARCUS_HPP
 
+#include "fast_exp.hpp"
+
+#include <cstddef>
+
 namespace mythical {
 
   namespace charge_transport {
@@ -36,6 +40,27 @@ namespace mythical {
          * @return the rate k [ 1/s ]
          */
         double getRate(const double E_i, const double E_j, const double H_AB) const noexcept;
+
+        /**
+         * @brief Get the Rates of many hops at once
+         *
+         * The loop has no branches or calls when the fast exponential is
+         * used, so the compiler can vectorize it. With the exact exponential
+         * the rates are the same as those of getRate.
+         *
+         * @param count - number of hops
+         * @param E_i - energies of the sites hopping from [ eV ]
+         * @param E_j - energies of the sites hopping to [ eV ]
+         * @param H_AB - electronic couplings
+         * @param rates - the rates k [ 1/s ] are written here
+         * @param precision - of the exponential
+         */
+        void getRates(const size_t count,
+            const double * E_i,
+            const double * E_j,
+            const double * H_AB,
+            double * rates,
+            const ExpPrecision precision = ExpPrecision::exact) const noexcept;
    
       private:
         // Reorganization energy
@@ -0,0 +1,84 @@
+#ifndef MYTHICAL_CHARGE_TRANSPORT_MILLER_ABRAHAMS_HPP
+#define MYTHICAL_CHARGE_TRANSPORT_MILLER_ABRAHAMS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace mythical {
+
+  namespace charge_transport {
+
+
+    /**
+     * @brief Miller-Abrahams rate equation
+     *
+     * All energies are in eV and distances in nm
+     */
+    class MillerAbrahams {
+      public:
+
+        /**
+         * @brief Constructor for the Miller-Abrahams Rate equation
+         *
+         * @param nu_0 - Attempt to hop frequency [ 1/s ]
+         * @param a - Localization length [ nm ]
+         * @param T - Temperature
+         *
+         * k = nu_0 * exp(-2*r/a) * exp(-(E_j-E_i)/(k_B*T)) if E_j > E_i
+         * k = nu_0 * exp(-2*r/a)                           otherwise
+         */
+        MillerAbrahams(const double nu_0, const double a, const double T);
+
+        /**
+         * @brief Get the Rate
+         *
+         * Defined in the header so batches built over a lattice can inline
+         * it.
+         *
+         * @param E_i - The energy of the site hopping from [ eV ]
+         * @param E_j - The energy of the site hopping to [ eV ]
+         * @param distance - between the sites [ nm ]
+         *
+         * @return the rate k [ 1/s ]
+         */
+        double getRate(const double E_i, const double E_j, const double distance) const noexcept {
+          return nu_0_ * std::exp(distance_factor_*distance -
+              std::max(E_j - E_i, 0.0)*inv_k_B_T_);
+        }
+
+        /**
+         * @brief Get the Rates of many hops off of the same site
+         *
+         * The rates are the same as those of getRate.
+         *
+         * @param count - number of hops
+         * @param E_i - The energy of the site hopping from [ eV ]
+         * @param E_j - energies of the sites hopping to [ eV ]
+         * @param distances - between the sites [ nm ]
+         * @param rates - the rates k [ 1/s ] are written here
+         */
+        void getRates(const size_t count,
+            const double E_i,
+            const double * E_j,
+            const double * distances,
+            double * rates) const noexcept {
+          for ( size_t hop = 0; hop < count; ++hop ) {
+            rates[hop] = getRate(E_i, E_j[hop], distances[hop]);
+          }
+        }
+
+      private:
+        // Attempt to hop frequency
+        const double nu_0_;
+
+        // -2/a
+        const double distance_factor_;
+
+        // 1/(k_B*T)
+        const double inv_k_B_T_;
+    };
+
+  }
+}
+#endif  // MYTHICAL_CHARGE_TRANSPORT_MILLER_ABRAHAMS_HPP
@@ -0,0 +1,147 @@
+#ifndef MYTHICAL_CHARGE_TRANSPORT_NEIGHBOR_STENCIL_HPP
+#define MYTHICAL_CHARGE_TRANSPORT_NEIGHBOR_STENCIL_HPP
+
+#include "cuboid_lattice.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace mythical {
+
+  namespace charge_transport {
+
+    /**
+     * \brief Offsets to all the neighbors within a cutoff on a Cuboid lattice
+     *
+     * The offsets, the distances to them and the change in index they cause
+     * are the same for every site of a regular lattice, so they are worked out
+     * once when the stencil is created. Sites far enough from the edges of the
+     * lattice find their neighbors by adding the index changes directly, the
+     * sites near an edge look their positions up in wrap tables. Neither path
+     * allocates or evaluates a square root.
+     *
+     * The stencil keeps a copy of the dimensions of the lattice, it stays
+     * valid after the lattice is destroyed.
+     **/
+    class NeighborStencil {
+
+      public:
+        NeighborStencil(const Cuboid & lattice, const double cutoff);
+
+        double getCutoff() const noexcept { return cutoff_; }
+
+        /// Largest offset along any axis in number of sites
+        int getReach() const noexcept { return reach_; }
+
+        /// Number of offsets, the most neighbors any site can have
+        size_t size() const noexcept { return distances_.size(); }
+
+        int getOffsetX(const size_t offset) const { return offset_x_[offset]; }
+        int getOffsetY(const size_t offset) const { return offset_y_[offset]; }
+        int getOffsetZ(const size_t offset) const { return offset_z_[offset]; }
+        int getIndexDelta(const size_t offset) const { return index_deltas_[offset]; }
+        double getDistance(const size_t offset) const { return distances_[offset]; }
+
+        /**
+         * \brief True if two offsets can land on the same site
+         *
+         * Happens when a periodic side of the lattice is shorter than the
+         * stencil, a neighbor is then visited once for every image of it.
+         **/
+        bool repeatsImages() const noexcept { return repeats_images_; }
+
+        /**
+         * \brief True if no neighbor of the site is across an edge of the
+         * lattice
+         **/
+        bool isInterior(const int index) const noexcept;
+
+        /**
+         * \brief Calls visit(neighbor_index, distance) for every neighbor of
+         * the site
+         *
+         * Neighbors are visited in the order of the offsets.
+         **/
+        template<typename Visit>
+        void visitNeighbors(const int index, Visit visit) const;
+
+        /**
+         * \brief Replaces the contents of the vectors with the neighbors of
+         * the site
+         *
+         * Does not allocate once the vectors have reached the size of the
+         * stencil.
+         *
+         * \return the number of neighbors
+         **/
+        size_t getNeighbors(const int index,
+            std::vector<int> & neighbor_indices,
+            std::vector<double> & distances) const;
+
+      private:
+        int length_;
+        int width_;
+        int height_;
+        int reach_;
+        double cutoff_;
+        bool repeats_images_;
+
+        std::vector<int> offset_x_;
+        std::vector<int> offset_y_;
+        std::vector<int> offset_z_;
+        std::vector<int> index_deltas_;
+        std::vector<double> distances_;
+
+        // Entry pos+reach_ holds the position pos is moved to by the
+        // boundary, -1 if it is outside a fixed boundary
+        std::vector<int> wrap_x_;
+        std::vector<int> wrap_y_;
+        std::vector<int> wrap_z_;
+
+        static std::vector<int> getWrapTable_(const int size,
+            const int reach,
+            const bool periodic);
+    };
+
+    inline bool NeighborStencil::isInterior(const int index) const noexcept {
+      const int plane = length_*width_;
+      const int z = index / plane;
+      const int y = (index - z*plane) / length_;
+      const int x = index - z*plane - y*length_;
+      return x >= reach_ && x < length_ - reach_ &&
+        y >= reach_ && y < width_ - reach_ &&
+        z >= reach_ && z < height_ - reach_;
+    }
+
+    template<typename Visit>
+    void NeighborStencil::visitNeighbors(const int index, Visit visit) const {
+      const int plane = length_*width_;
+      const int z = index / plane;
+      const int y = (index - z*plane) / length_;
+      const int x = index - z*plane - y*length_;
+      const size_t count = distances_.size();
+
+      if ( x >= reach_ && x < length_ - reach_ &&
+          y >= reach_ && y < width_ - reach_ &&
+          z >= reach_ && z < height_ - reach_ ) {
+        for ( size_t offset = 0; offset < count; ++offset ) {
+          visit(index + index_deltas_[offset], distances_[offset]);
+        }
+        return;
+      }
+
+      const int * wrap_x = wrap_x_.data() + x + reach_;
+      const int * wrap_y = wrap_y_.data() + y + reach_;
+      const int * wrap_z = wrap_z_.data() + z + reach_;
+      for ( size_t offset = 0; offset < count; ++offset ) {
+        const int x_lattice_pos = wrap_x[offset_x_[offset]];
+        const int y_lattice_pos = wrap_y[offset_y_[offset]];
+        const int z_lattice_pos = wrap_z[offset_z_[offset]];
+        if ( x_lattice_pos < 0 || y_lattice_pos < 0 || z_lattice_pos < 0 ) continue;
+        const int neigh_index = z_lattice_pos*plane + y_lattice_pos*length_ + x_lattice_pos;
+        if ( neigh_index != index ) visit(neigh_index, distances_[offset]);
+      }
+    }
+  }
+}
+#endif  // MYTHICAL_CHARGE_TRANSPORT_NEIGHBOR_STENCIL_HPP
@@ -0,0 +1,204 @@
+#ifndef MYTHICAL_CHARGE_TRANSPORT_RATE_MODEL_HPP
+#define MYTHICAL_CHARGE_TRANSPORT_RATE_MODEL_HPP
+
+#include "cuboid_lattice.hpp"
+#include "fast_exp.hpp"
+#include "marcus.hpp"
+#include "miller_abrahams.hpp"
+#include "../rate_network.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * A rate model is any type with the member functions
+ *
+ *   double getRate(const double E_i, const double E_j,
+ *       const double distance) const
+ *
+ *   void getRates(const size_t count, const double E_i, const double * E_j,
+ *       const double * distances, double * rates) const
+ *
+ * getRate returns the rate [ 1/s ] of hopping from a site of energy E_i [ eV ]
+ * to a site of energy E_j a distance [ nm ] away, getRates writes the rates of
+ * count hops off of the same site. buildRateTable calls getRates once for
+ * every site with the row of the table the rates go in, so a model can
+ * evaluate a whole row in a loop the compiler vectorizes. MillerAbrahams is a
+ * rate model as it is, Marcus is used through MarcusModel and any other
+ * function through FunctionModel. Models are template parameters of
+ * buildRateTable so the calls are resolved when it is compiled, and the models
+ * must be safe to call from several threads at once.
+ */
+
+namespace mythical {
+
+  namespace charge_transport {
+
+    /**
+     * @brief Marcus rates with a coupling that decays exponentially with the
+     * distance between the sites
+     *
+     * H_AB = H_0 * exp(-distance/decay_length)
+     *
+     * getRates passes the hops to Marcus::getRates in blocks. With the fast
+     * precision both exponentials are evaluated with fastExp, getRate always
+     * uses std::exp.
+     */
+    class MarcusModel {
+      public:
+        /**
+         * @param lambda - Reorganization energy [ eV ]
+         * @param T - Temperature
+         * @param H_0 - Electronic coupling of sites on top of each other
+         * @param decay_length - of the coupling [ nm ]
+         * @param precision - of the exponentials of getRates
+         */
+        MarcusModel(const double lambda, const double T,
+            const double H_0, const double decay_length,
+            const ExpPrecision precision = ExpPrecision::exact) :
+          marcus_(lambda, T), H_0_(H_0), inv_decay_length_(1.0/decay_length),
+          precision_(precision) {}
+
+        double getRate(const double E_i, const double E_j, const double distance) const noexcept {
+          return marcus_.getRate(E_i, E_j, H_0_*std::exp(-distance*inv_decay_length_));
+        }
+
+        void getRates(const size_t count,
+            const double E_i,
+            const double * E_j,
+            const double * distances,
+            double * rates) const noexcept {
+          // Marcus::getRates takes the energy of the site of each hop, the
+          // blocks stay on the stack so threads share nothing
+          const size_t block_size = 64;
+          double E_i_block[block_size];
+          double H_AB_block[block_size];
+          std::fill(E_i_block, E_i_block + block_size, E_i);
+          for ( size_t begin = 0; begin < count; begin += block_size ) {
+            const size_t size = std::min(block_size, count - begin);
+            if ( precision_ == ExpPrecision::fast ) {
+              for ( size_t hop = 0; hop < size; ++hop ) {
+                H_AB_block[hop] = H_0_*fastExp(-distances[begin+hop]*inv_decay_length_);
+              }
+            } else {
+              for ( size_t hop = 0; hop < size; ++hop ) {
+                H_AB_block[hop] = H_0_*std::exp(-distances[begin+hop]*inv_decay_length_);
+              }
+            }
+            marcus_.getRates(size, E_i_block, E_j + begin, H_AB_block,
+                rates + begin, precision_);
+          }
+        }
+
+        ExpPrecision getPrecision() const noexcept { return precision_; }
+
+      private:
+        Marcus marcus_;
+        double H_0_;
+        double inv_decay_length_;
+        ExpPrecision precision_;
+    };
+
+    /**
+     * @brief Rate model calling a user supplied function
+     *
+     * The function is called as function(E_i, E_j, distance).
+     */
+    template<typename Function>
+    class FunctionModel {
+      public:
+        explicit FunctionModel(Function function) : function_(std::move(function)) {}
+
+        double getRate(const double E_i, const double E_j, const double distance) const {
+          return function_(E_i, E_j, distance);
+        }
+
+        void getRates(const size_t count,
+            const double E_i,
+            const double * E_j,
+            const double * distances,
+            double * rates) const {
+          for ( size_t hop = 0; hop < count; ++hop ) {
+            rates[hop] = function_(E_i, E_j[hop], distances[hop]);
+          }
+        }
+
+      private:
+        Function function_;
+    };
+
+    template<typename Function>
+    FunctionModel<Function> makeFunctionModel(Function function) {
+      return FunctionModel<Function>(std::move(function));
+    }
+
+    /**
+     * @brief Rates between all the sites of a lattice within a cutoff
+     *
+     * The neighbors are found with Cuboid::visitNeighborDistances, so the
+     * lattice is split into slabs along x and each slab is filled by its own
+     * thread. The neighbors are counted first so that the rates are written
+     * straight into the arrays the RateNetwork takes over, the model
+     * evaluates the rates off of each site with a single call to getRates.
+     *
+     * @param lattice
+     * @param cutoff - largest distance a walker can hop [ nm ]
+     * @param energies - of every site, indexed by the lattice index [ eV ]
+     * @param model - rate model
+     * @param thread_count - a value of 0 uses every hardware thread
+     *
+     * @return the rates, the id of each site is its lattice index
+     */
+    template<typename Model>
+    RateTable buildRateTable(const Cuboid & lattice,
+        const double cutoff,
+        const std::vector<double> & energies,
+        const Model & model,
+        const int thread_count = 1) {
+
+      const int total = lattice.getLength()*lattice.getWidth()*lattice.getHeight();
+      if ( static_cast<int>(energies.size()) != total ) {
+        throw std::invalid_argument("Cannot build the rate table, there are " +
+            std::to_string(energies.size()) + " energies for " +
+            std::to_string(total) + " sites.");
+      }
+
+      RateTable rate_table;
+      rate_table.row_offsets.assign(total+1, 0);
+      lattice.visitNeighborDistances(cutoff,
+          [&](const int index, const std::vector<int> & neighbor_indices,
+            const std::vector<double> &) {
+            rate_table.row_offsets[index+1] = static_cast<int>(neighbor_indices.size());
+          }, thread_count);
+      std::partial_sum(rate_table.row_offsets.begin(),
+          rate_table.row_offsets.end(), rate_table.row_offsets.begin());
+
+      rate_table.neighbor_ids.resize(rate_table.row_offsets.back());
+      rate_table.rates.resize(rate_table.row_offsets.back());
+      lattice.visitNeighborDistances(cutoff,
+          [&](const int index, const std::vector<int> & neighbor_indices,
+            const std::vector<double> & distances) {
+            // The slabs are visited by different threads, each gathers the
+            // energies of the neighbors into its own buffer
+            thread_local std::vector<double> E_j;
+            const size_t count = neighbor_indices.size();
+            E_j.resize(count);
+            int * neighbor_ids = rate_table.neighbor_ids.data() + rate_table.row_offsets[index];
+            for ( size_t neigh = 0; neigh < count; ++neigh ) {
+              neighbor_ids[neigh] = neighbor_indices[neigh];
+              E_j[neigh] = energies[neighbor_indices[neigh]];
+            }
+            model.getRates(count, energies[index], E_j.data(), distances.data(),
+                rate_table.rates.data() + rate_table.row_offsets[index]);
+          }, thread_count);
+      return rate_table;
+    }
+  }
+}
+#endif  // MYTHICAL_CHARGE_TRANSPORT_RATE_MODEL_HPP
@@ -1,6 +1,7 @@
 #ifndef MYTHICAL_COARSEGRAINSYSTEM_HPP
 #define MYTHICAL_COARSEGRAINSYSTEM_HPP
 
+#include <functional>
 #include <map>
 #include <unordered_set>
 #include <unordered_map>
@@ -8,6 +9,11 @@
 #include <vector>
 
 #include "constants.hpp"
+#include "queue.hpp"
+#include "rate_network.hpp"
+#include "sampling_method.hpp"
+#include "walker.hpp"
+#include "walker_store.hpp"
 
 namespace ugly {
 template <typename... Ts>
@@ -16,16 +22,87 @@ class Graph;
 
 namespace mythical {
 
+class BackgroundCoarseGrainer;
+class BasinExplorer;
+class Cluster;
+class HotSiteSketch;
 class Site_Container;
 class Cluster_Container;
+class RateGraph;
+class ShortestPaths;
 class TopologyFeature;
+class FeatureSeeds;
+class WalkerRandomStreams;
+struct CoarseGrainPlan;
 
-class Walker;
+/**
+ * \brief Record of a single hop made by a walker owned by the system
+ *
+ * If the site the walker attempted to hop to was occupied the walker stays
+ * where it is and the from and to site ids are the same.
+ **/
+struct HopEvent {
+  int walker_id;
+  int from_site_id;
+  int to_site_id;
+  /// Global time at which the hop occurred
+  double time;
+};
+
+/**
+ * \brief Called by CoarseGrainSystem::run once per sampling interval
+ *
+ * Receives the time at the end of the sampling interval and all the hops
+ * that occurred within the interval in the order they occurred.
+ **/
+typedef std::function<void(const double sample_time,
+    const std::vector<HopEvent> & hops)> SampleObserver;
+
+/**
+ * \brief Record of a single attempt to coarse grain the basin around a site
+ **/
+struct CoarseGrainAttempt {
+  int site_id;
+  /// Sites explored while looking for the basin
+  int sites_explored;
+  /// Max exploration count the attempt was made with
+  int max_exploration_count;
+  /// The basin had more sites than the max exploration count so the attempt
+  /// was abandoned
+  bool limit_reached;
+  /// A cluster was created or grown
+  bool coarse_grained;
+  /// Wall time spent on the attempt in seconds
+  double seconds;
+};
+
+/**
+ * \brief Totals of the attempts to coarse grain made by a system
+ *
+ * Every attempt is counted once, as abandoned if the basin was larger than
+ * the max exploration count, as coarse grained if a cluster was created or
+ * grown and as rejected otherwise, e.g. the basin did not satisfy the
+ * equilibrium condition.
+ **/
+struct CoarseGrainStatistics {
+  long attempts;
+  long abandoned;
+  long rejected;
+  long coarse_grained;
+  double seconds_abandoned;
+  double seconds_rejected;
+  double seconds_coarse_grained;
+};
+
+/**
+ * \brief Called after every attempt to coarse grain
+ **/
+typedef std::function<void(const CoarseGrainAttempt & attempt)> AttemptObserver;
 
 /**
  * \brief Coarse Grain System allows abstraction of renormalization of sites
  *
- * This class simply uses pointers to the relevant hop rates. It will simulate a
+ * This class stores a copy of the relevant hop rates. It will simulate a
  * walker hopping through the system of sites. If a large number of compute
  * cycles are expended moving a walker between two low energy sites they will
  * be coarse grained, or renormalized so that the probabilities and time spent
@@ -49,12 +126,12 @@ class CoarseGrainSystem {
   /**
    * \brief This will correctly initialize the system
    *
-   * Essentially pointers to all the rates are stored in this class. Pointers
-   * are used in case any of the rates are changed, there will be no need to
-   * pass them back into the couse grain object. An updated function could
-   * simply be called. This function must be called before the walkers can
+   * The rates are copied into a single compressed sparse row graph that is
+   * shared by all the sites, changing the rates in the map afterwards has no
+   * effect on the system. This function must be called before the walkers can
    * be initialized `initializeWalkerss` and before a hopping event is called
-   * on a walker `hop`.
+   * on a walker `hop`. A system can only be initialized once, any of the
+   * initializeSystem functions throws if it already has been.
    *
    * \param[in] ratesOfAllSites this is a map of maps the first int is site i
    * the value of which is a second map of sites j which are all neighbors of
@@ -98,6 +175,40 @@ class CoarseGrainSystem {
    **/
   void initializeSystem(std::unordered_map<int, std::unordered_map<int, double>> &ratesOfAllSites);
 
+  /**
+   * \brief Initialize the system from rates shared with other systems
+   *
+   * Only the occupancy, visit frequencies, random numbers and clusters of
+   * the sites are stored by the system, the rates are read from the network.
+   * Systems sharing a network can run on separate threads. The sampling
+   * method of the network replaces the one set on the system.
+   **/
+  void initializeSystem(std::shared_ptr<const RateNetwork> rate_network);
+
+  /**
+   * \brief Initialize the system from rates in compressed rows
+   *
+   * The arrays of the table are moved into the rate network of the system
+   * rather than copied, so no map of the rates is ever built. Neighbors
+   * without a row of their own are treated as drains.
+   **/
+  void initializeSystem(RateTable rate_table);
+
+  /**
+   * \brief Initialize the system from rates passed one at a time
+   *
+   * The generator is called once and passes every rate to the sink, all the
+   * rates off of a site must be passed one after the other. The rates are
+   * written straight into the rows of the rate network of the system.
+   **/
+  void initializeSystem(const RateGenerator & generate);
+
+  /**
+   * \brief Network the system was initialized with, pass it to other systems
+   * to share the rates
+   **/
+  std::shared_ptr<const RateNetwork> getRateNetwork() const { return rate_network_; }
+
   /**
    * \brief Initialize walker dwell times and future hop site id
    *
@@ -106,6 +217,7 @@ class CoarseGrainSystem {
    * there are sites 1 2 and 3. Then the walkers must exist on at least one
    * of these sites before they are passed in. The function will then update
    * their dwell times as well as providing a potential future hopping site.
+   * The walker ids must lie between 0 and constants::max_walker_id.
    *
    * \param[in] walkers a vector of pointers to the walkers
    **/
@@ -121,6 +233,124 @@ class CoarseGrainSystem {
    **/
   void setRandomSeed(const unsigned long seed);
 
+  /**
+   * \brief Define how the site a walker hops to next is picked
+   *
+   * Applies to both the sites and the clusters. By default linear sampling
+   * is used. The different methods are described in sampling_method.hpp,
+   * like the seed the method must be set before initializeSystem is called.
+   *
+   * \param[in] sampling_method
+   **/
+  void setSamplingMethod(const SamplingMethod sampling_method);
+  SamplingMethod getSamplingMethod() const { return sampling_method_; }
+
+  /**
+   * \brief Where the random numbers used to hop the walkers come from
+   *
+   * per_feature
+   *
+   * Each site and cluster draws from its own Mersenne Twister, seeded in the
+   * order the features are created. A site only creates its engine, about
+   * 5 kB, once a walker hops off of it. This is the default.
+   *
+   * per_walker
+   *
+   * Each walker draws from its own counter based stream, keyed on the seed,
+   * the walker id, the number of times walkers with the id have been added
+   * and the number of draws the walker has made since it was added. A
+   * walker reusing the id of one that has left gets new numbers rather than
+   * repeating them. The numbers a walker gets no longer depend on which site
+   * or cluster it is on or on the order the walkers hop in, so splitting the
+   * walkers differently across threads gives the same numbers.
+   *
+   * Like the seed it must be set before initializeSystem is called.
+   **/
+  enum class RandomStreams {
+    per_feature,
+    per_walker
+  };
+
+  void setRandomStreams(const RandomStreams streams);
+  RandomStreams getRandomStreams() const { return random_streams_; }
+
+  /**
+   * \brief Methods used to find the time it takes a walker to cross a
+   * potential cluster
+   *
+   * native
+   *
+   * All-pairs shortest paths over the rate graph of the system, reusing its
+   * memory between coarse graining attempts. This is the default.
+   *
+   * graph_library
+   *
+   * Builds a graph with the UGLY library on every attempt. Gives the same
+   * times as native and is kept as a reference to compare against.
+   **/
+  enum class CrossingTimeMethod {
+    native,
+    graph_library
+  };
+
+  void setCrossingTimeMethod(const CrossingTimeMethod method) {
+    waitForBackgroundCoarseGraining_();
+    crossing_time_method_ = method;
+  }
+  CrossingTimeMethod getCrossingTimeMethod() const { return crossing_time_method_; }
+
+  /**
+   * \brief Which sites coarse graining is attempted around once the
+   * iteration threshold is crossed
+   *
+   * last_hop
+   *
+   * The site the last walker hopped to. This is the default.
+   *
+   * hot_spots
+   *
+   * The sites visited most often since the last attempt, found with a fixed
+   * size heavy hitter sketch fed with every visit to a site that is not yet
+   * part of a cluster. Traps are found sooner in large systems where the last
+   * hop is likely to land on a cold site. The hottest sites are tried in
+   * turn until one is coarse grained.
+   **/
+  enum class CoarseGrainTrigger {
+    last_hop,
+    hot_spots
+  };
+
+  void setCoarseGrainTrigger(const CoarseGrainTrigger trigger) {
+    coarse_grain_trigger_ = trigger;
+  }
+  CoarseGrainTrigger getCoarseGrainTrigger() const { return coarse_grain_trigger_; }
+
+  /**
+   * \brief Largest number of hot sites tried each time the iteration
+   * threshold is crossed, the default is 3
+   **/
+  void setHotSpotsPerAttempt(const int count);
+  int getHotSpotsPerAttempt() const { return hot_spots_per_attempt_; }
+
+  /**
+   * \brief Look for clusters on a helper thread while the walkers hop
+   *
+   * When the iteration threshold is crossed the sites picked by the coarse
+   * grain trigger are handed to a helper thread. It searches their basins,
+   * checks the equilibrium condition and builds and solves any new cluster
+   * while the walkers keep hopping. The result is put in place the next time
+   * the threshold is crossed, waiting for the helper if it has not finished,
+   * so it always happens after the same number of hops and runs with a seed
+   * set are reproducible. Basins that join existing clusters are merged on
+   * the calling thread, as walkers may be hopping on those clusters. Sites
+   * that are already part of a cluster are not handed to the helper.
+   *
+   * Turning it off puts any result that is still pending in place. Setters
+   * of parameters the helper reads wait for it to finish first.
+   **/
+  void setBackgroundCoarseGraining(const bool background);
+  bool getBackgroundCoarseGraining() const { return background_coarse_graining_; }
+
   /**
    * \brief Make the walker hop to a site in the system
    *
@@ -128,7 +358,9 @@ class CoarseGrainSystem {
    * located on a site in the system and it has a stored potential site it
    * will be hopping to. This function will be called on it. It will move the
    * walker if necessary and will coarse grain sites/renormalize sites if
-   * necessary.
+   * necessary. The walker id must lie between 0 and
+   * constants::max_walker_id, the tables of walkers on clusters are indexed
+   * by it.
    *
    * \param[in] walker
    **/
@@ -142,6 +374,82 @@ class CoarseGrainSystem {
   void removeWalkerFromSystem(std::pair<int,std::shared_ptr<Walker>>& walker);
   void removeWalkerFromSystem(const int walker_id,std::shared_ptr<Walker>& walker);
 
+  /**
+   * \brief Place a walker on a site, it is then moved by `run` and `step`
+   *
+   * The system owns the walker and the queue of the times at which each of
+   * its walkers hop next, the walker will first hop its dwell time after
+   * the current time of the system. Walker ids must lie between 0 and
+   * constants::max_walker_id and must not be used by walkers that are moved
+   * with `hop`. Walkers cannot be
+   * placed on a drain, a site without any rates off of it.
+   *
+   * \param[in] walker_id
+   * \param[in] siteId site the walker starts on
+   **/
+  void addWalker(const int walker_id, const int siteId);
+
+  /**
+   * \brief Remove a walker that was added with `addWalker`
+   *
+   * Can be called from within the observer passed to `run`.
+   **/
+  void removeWalker(const int walker_id);
+
+  /**
+   * \brief Hop the walkers added with `addWalker` until the time is reached
+   *
+   * Walkers hop in order of their global time, the observer is called each
+   * time the simulation passes the end of a sampling interval, the sampling
+   * interval is the time resolution. Intervals are counted from time 0 so
+   * calling run several times gives the same intervals as calling it once.
+   * Hops that occur after the last full interval are reported at the end of
+   * the interval on the next call to run.
+   *
+   * Walkers that hop onto a drain, a site without any rates off of it, are
+   * taken out of the system. The hop onto the drain is reported as usual and
+   * the walker is counted by `getNumberOfDrainedWalkers`.
+   *
+   * \param[in] until_time global time to stop at
+   * \param[in] observer can be empty if nothing needs to be recorded
+   **/
+  void run(const double until_time, SampleObserver observer);
+
+  /**
+   * \brief Make the walker added with `addWalker` that is next in time hop
+   *
+   * Hops made by step are not reported to the observer of `run`.
+   *
+   * \param[in] number_of_hops
+   **/
+  void step(const int number_of_hops);
+
+  /**
+   * \brief Global time of the system, the time of the last hop made by
+   * `step` or the time `run` stopped at
+   **/
+  double getTime() const noexcept { return time_; }
+
+  /**
+   * \brief Number of walkers added with `addWalker` still in the system
+   **/
+  std::size_t getNumberOfWalkers() const noexcept { return walkers_.size(); }
+
+  /**
+   * \brief Number of walkers added with `addWalker` that have been taken out
+   * of the system by `run` or `step` as they reached a drain
+   **/
+  std::size_t getNumberOfDrainedWalkers() const noexcept { return drained_walkers_; }
+
+  int getSiteIdOfWalker(const int walker_id) const;
+
+  /**
+   * \brief State of the walkers added with `addWalker`
+   *
+   * The walker index used by the store is the walker id.
+   **/
+  const WalkerStore & getWalkerStore() const noexcept { return walkers_; }
+
   /**
    * \brief Determine if the site is part of a cluster
    *
@@ -214,8 +522,54 @@ class CoarseGrainSystem {
    * @param double
    */
   void setPerformanceRatio(const double performance_ratio) { 
+    waitForBackgroundCoarseGraining_();
     performance_ratio_ = performance_ratio;
   }
+
+  /**
+   * \brief Adjusts which rates are followed when exploring the basin around
+   * a site
+   *
+   * The larger the threshold the closer a rate must be to the fastest rate
+   * seen before it is followed. The default is 0.95.
+   **/
+  void setBasinThreshold(const double threshold);
+  double getBasinThreshold() const;
+
+  /**
+   * \brief Largest basin that is coarse grained
+   *
+   * If more sites than this are found while exploring the basin around a
+   * site the attempt to coarse grain is abandoned. The default is 5. Turns
+   * off the adaptive exploration count.
+   **/
+  void setMaxExplorationCount(const int count);
+  int getMaxExplorationCount() const;
+
+  /**
+   * \brief Let the max exploration count adapt between two limits
+   *
+   * Each time three attempts in a row are abandoned the max exploration count
+   * is doubled, up to max_count. If attempts are still abandoned at max_count
+   * the exploration was wasted and the count drops back to twice the largest
+   * basin that has been coarse grained, but not below min_count.
+   **/
+  void setAdaptiveExplorationCount(const int min_count, const int max_count);
+
+  /**
+   * \brief Totals of the attempts to coarse grain since the system was
+   * created or the statistics were reset
+   **/
+  const CoarseGrainStatistics & getCoarseGrainStatistics() const noexcept {
+    return statistics_;
+  }
+  void resetCoarseGrainStatistics();
+
+  /**
+   * \brief Called after every attempt to coarse grain, pass an empty
+   * function to stop observing
+   **/
+  void setCoarseGrainAttemptObserver(AttemptObserver observer);
  private:
   /// Performance ratio
   double performance_ratio_;
@@ -226,6 +580,45 @@ class CoarseGrainSystem {
   /// The random seed
   unsigned long seed_;
 
+  /// Method used by the sites and clusters to pick the next site
+  SamplingMethod sampling_method_;
+
+  /// Where the random numbers come from, the streams of the walkers are only
+  /// created when they are used
+  RandomStreams random_streams_;
+  std::unique_ptr<WalkerRandomStreams> walker_streams_;
+  /// Seeds of the engines of the sites, an engine is only created once its
+  /// site is hopped off of
+  std::unique_ptr<FeatureSeeds> feature_seeds_;
+
+  /// Method used to find the time to cross a potential cluster
+  CrossingTimeMethod crossing_time_method_;
+
+  /// Memory reused by the native crossing time method
+  std::unique_ptr<ShortestPaths> shortest_paths_;
+
+  /// Explores the basin around a site each time coarse graining is attempted
+  std::unique_ptr<BasinExplorer> basin_explorer_;
+
+  /// Decides which sites coarse graining is attempted around
+  CoarseGrainTrigger coarse_grain_trigger_;
+  int hot_spots_per_attempt_;
+  std::unique_ptr<HotSiteSketch> hot_sites_;
+
+  /// Runs coarse graining on a helper thread when it is in the background
+  bool background_coarse_graining_;
+  std::unique_ptr<BackgroundCoarseGrainer> background_coarse_grainer_;
+
+  /// Limits of the max exploration count when it is adaptive
+  bool adaptive_exploration_;
+  int min_exploration_count_;
+  int max_exploration_count_;
+  int abandoned_in_a_row_;
+  int largest_coarse_grained_basin_;
+
+  CoarseGrainStatistics statistics_;
+  AttemptObserver attempt_observer_;
+
   bool time_resolution_set_;
   /// The resolution of the clusters. Essentially how many hops will a walker
   /// move within the cluster before it is likely to leave, the point of this
@@ -249,13 +642,63 @@ class CoarseGrainSystem {
   /// The iteration threshold is reset to the min value if a cluster is found
   int iteration_threshold_min_;
 
-  std::unordered_map<int, TopologyFeature *> topology_features_;
+  /// Topology feature each site belongs to, either the site itself or the
+  /// cluster it is a part of. Indexed by the dense site index provided by the
+  /// site container, not by the site id.
+  std::vector<TopologyFeature *> topology_features_;
+
+  /// Rates between all the sites stored in compressed sparse row format, the
+  /// row of each site is its dense index
+  std::shared_ptr<const RateGraph> rate_graph_;
+  std::shared_ptr<const RateNetwork> rate_network_;
+
   /// Stores smart pointers to all the sites
   std::unique_ptr<Site_Container> sites_;
 
   /// Stores smart pointers to all the clusters
   std::unique_ptr<Cluster_Container> clusters_;
 
+  /// Remaining dwell time of each walker on the cluster it occupies, shared
+  /// by all the clusters and indexed by the walker id
+  std::shared_ptr<std::vector<double>> cluster_dwell_times_;
+
+  /// Walkers added with addWalker, the walker id is the index in the store
+  WalkerStore walkers_;
+
+  /// Global time at which each of the walkers added with addWalker will hop
+  /// next, keyed by the walker id
+  Queue walker_queue_;
+
+  /// Global time of the system used by run and step
+  double time_;
+
+  /// Number of sampling intervals run has passed the end of
+  long samples_taken_;
+
+  /// Hops made by run since the end of the last sampling interval
+  std::vector<HopEvent> hops_;
+
+  /// Walkers taken out of the system by run and step as they reached a drain
+  std::size_t drained_walkers_;
+
+  /// Id given to the next cluster the system creates
+  int next_cluster_id_;
+
+  /**
+   * \brief Hop a single walker
+   *
+   * The site the walker occupies and the site it will attempt to hop to are
+   * updated in place, along with the dwell time on the site it ends up on.
+   **/
+  void hop_(
+      const int walker_id,
+      int & siteId,
+      int & potential_siteId,
+      double & dwell_time);
+  /// Returns the id of the site the walker ended up on
+  int hopNextWalker_();
+  double nextSampleTime_() const;
+
   void coarseGrainSiteIfNeeded_(std::shared_ptr<Walker>& walker);
 
   /**
@@ -275,6 +718,7 @@ class CoarseGrainSystem {
   bool sitesSatisfyEquilibriumCondition_(std::vector<int> siteIds, double maxtime);
 
   double getInternalTimeLimit_(std::vector<int> siteIds);
+  double getInternalTimeLimitFromGraphLibrary_(std::vector<int> siteIds);
 
   /**
    * @brief Gets the fastest rate off the basin sites
@@ -301,8 +745,21 @@ class CoarseGrainSystem {
   int getFavoredClusterId_(std::vector<int> siteIds);
 
   bool coarseGrain_(int siteId);
+  bool coarseGrainHotSpots_();
+  bool coarseGrainInBackground_(int siteId);
+  /// Runs on the helper thread, only reads state that hops do not change
+  CoarseGrainPlan planCoarseGrain_(const std::vector<int> & siteIds);
+  CoarseGrainAttempt findBasinToCoarseGrain_(int siteId, CoarseGrainPlan & plan);
+  bool carryOutPlan_(CoarseGrainPlan & plan);
+  void waitForBackgroundCoarseGraining_() const;
+  void recordAttempt_(const CoarseGrainAttempt & attempt);
+  void adaptExplorationCount_(const CoarseGrainAttempt & attempt);
   std::unordered_map<int,int> getClustersOfSites(const std::vector<int> & siteIds);
   int createCluster_(std::vector<int> siteIds,double internal_time_limit);
+  std::unique_ptr<Cluster> buildCluster_(
+      const std::vector<int> & siteIds,
+      double internal_time_limit);
+  int installCluster_(Cluster & cluster);
   void mergeSitesAndClusters_(std::unordered_map<int,int> sites_and_clusters, int clusterId);
   double getTimeConstantFromSitesToNeighbors_(const std::vector<int> & siteIds) const;
   std::unordered_map<int,double> filterSites_();
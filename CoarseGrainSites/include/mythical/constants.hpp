@@ -9,6 +9,9 @@ namespace mythical {
     /// that has not been set will be assigned the unassignedId
     const int unassignedId = std::numeric_limits<int>::min();
     const int inf_iterations = std::numeric_limits<int>::max();
+    /// Walker ids index the arrays the walkers are stored in, so they must
+    /// lie between 0 and max_walker_id
+    const int max_walker_id = (1 << 24) - 1;
     const double unassigned_value = std::numeric_limits<double>::min();
     // Boltzmann's constant [ eV / K ]
     const double k_B = 8.617333262145e-5;
@@ -0,0 +1,188 @@
+#ifndef MYTHICAL_DOMAIN_DECOMPOSED_SYSTEM_HPP
+#define MYTHICAL_DOMAIN_DECOMPOSED_SYSTEM_HPP
+
+#include <functional>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "coarsegrainsystem.hpp"
+#include "queue.hpp"
+
+namespace mythical {
+
+namespace charge_transport {
+  class Cuboid;
+}
+
+class RateGraph;
+class RateNetwork;
+
+/**
+ * \brief Hops many walkers in parallel by splitting the sites into domains,
+ * each owned by its own thread
+ *
+ * Uses the synchronous sublattice method. Every domain is split in two
+ * sublattices and time is split into windows. Within a window the walkers on
+ * sublattice 0 of every domain hop first, each domain on its own thread, then
+ * the walkers on sublattice 1. A walker only hops while it is on the active
+ * sublattice, a walker that lands on the other sublattice waits for its turn.
+ * Walkers that land in another domain are handed over to it between the two
+ * halves of the window.
+ *
+ * The domains must be laid out so that no site can be reached from the
+ * active sublattice of two different domains at once, e.g. slabs that are at
+ * least twice as wide as the longest hop, which is checked when the system
+ * is initialized. A walker is never moved onto an occupied site, as in
+ * CoarseGrainSystem::hop it stays where it is and is given a new dwell time
+ * instead.
+ *
+ * Walkers reaching a drain, a site without any rates off of it, are taken out
+ * of the system. Sites are not coarse grained, hops are sampled from the
+ * rates of the network with the random numbers of the domain the walker is
+ * in, so runs with a seed set are reproducible for a given layout of domains
+ * and window. Smaller windows are closer to a serial simulation, as the
+ * order of hops on different sublattices is only kept between windows.
+ **/
+class DomainDecomposedSystem {
+ public:
+  /**
+   * \brief Returns the domain and the sublattice, 0 or 1, of a site
+   **/
+  typedef std::function<std::pair<int,int>(const int siteId)> DomainMap;
+
+  DomainDecomposedSystem();
+  ~DomainDecomposedSystem();
+
+  /**
+   * \brief Slice a cuboid lattice into slabs along x of equal width
+   *
+   * The site ids must be the indices of the lattice.
+   **/
+  static DomainMap slabsAlongX(
+      const charge_transport::Cuboid & lattice,
+      const int number_of_domains);
+
+  /**
+   * \brief Must be set before the system is initialized, by default the seed
+   * is determined from the time
+   **/
+  void setRandomSeed(const unsigned long seed);
+
+  /**
+   * \brief Interval between the samples passed to the observer of `run`
+   *
+   * The time resolution and the windows per sample cannot be changed once
+   * the system has been run.
+   **/
+  void setTimeResolution(const double time_resolution);
+  double getTimeResolution() const noexcept { return time_resolution_; }
+
+  /**
+   * \brief Number of time windows each sampling interval is split into, the
+   * default is 10
+   **/
+  void setWindowsPerSample(const int windows);
+  int getWindowsPerSample() const noexcept { return windows_per_sample_; }
+
+  /**
+   * \brief Split the sites of the network into domains
+   *
+   * \throws invalid_argument if a site could be reached from the active
+   * sublattice of two domains at once
+   **/
+  void initializeSystem(
+      std::shared_ptr<const RateNetwork> rate_network,
+      DomainMap domain_map);
+
+  int getNumberOfDomains() const noexcept {
+    return static_cast<int>(domains_.size());
+  }
+  std::pair<int,int> getDomainOfSite(const int siteId) const;
+
+  /**
+   * \brief Place a walker on a site, it first hops its dwell time after the
+   * current time of the system
+   *
+   * Walker ids must be non-negative and no larger than
+   * constants::max_walker_id.
+   **/
+  void addWalker(const int walker_id, const int siteId);
+  void removeWalker(const int walker_id);
+
+  std::size_t getNumberOfWalkers() const noexcept { return number_of_walkers_; }
+  bool walkerExists(const int walker_id) const noexcept;
+  int getSiteIdOfWalker(const int walker_id) const;
+
+  /**
+   * \brief Hop the walkers until the time is reached
+   *
+   * Only whole windows are run, the time stops at the end of the last window
+   * that fits. The observer is called on the calling thread at the end of
+   * each sampling interval with the hops made during it, ordered by time
+   * and then walker id. As the sublattices take turns a hop reported in an
+   * interval may have happened up to a window before it started. The other
+   * domains keep hopping while the observer is called, so it must not query
+   * or change the system.
+   *
+   * \param[in] until_time global time to stop at
+   * \param[in] observer can be empty if nothing needs to be recorded
+   **/
+  void run(const double until_time, SampleObserver observer);
+
+  double getTime() const noexcept { return time_; }
+
+ private:
+  struct Domain {
+    /// Walkers on each sublattice keyed by the time of their next hop
+    Queue queues[2];
+    std::mt19937 random_engine;
+    /// Walkers that left the domain, one buffer per parity of the half
+    /// window so the next half can fill one while the other is read
+    std::vector<int> outboxes[2];
+    /// Hops made during the window, one buffer per parity of the window
+    std::vector<HopEvent> hops[2];
+    /// Walkers that reached a drain while the domain was being run
+    std::size_t drained_walkers;
+  };
+
+  bool seed_set_;
+  unsigned long seed_;
+  double time_resolution_;
+  int windows_per_sample_;
+  double time_;
+  /// Number of whole windows that have been run
+  long windows_run_;
+
+  std::shared_ptr<const RateNetwork> rate_network_;
+  std::shared_ptr<const RateGraph> rate_graph_;
+  std::unordered_map<int,int> row_of_site_;
+  std::vector<int> domain_of_row_;
+  std::vector<int> sublattice_of_row_;
+  /// One char per row so threads write separate memory locations
+  std::vector<char> occupied_;
+
+  /// State of each walker indexed by the walker id, rows are
+  /// constants::unassignedId for walkers that are not in the system
+  std::vector<int> walker_rows_;
+  std::vector<int> walker_target_rows_;
+  std::vector<double> walker_times_;
+  std::size_t number_of_walkers_;
+
+  std::vector<Domain> domains_;
+  std::vector<HopEvent> sample_hops_;
+
+  void checkDomains_() const;
+  void drawNextHop_(Domain & domain, const int walker_id, const double time);
+  void runHalfWindow_(const int domain_index, const int sublattice,
+      const double window_end, std::vector<int> & outbox,
+      std::vector<HopEvent> & hops);
+  void takeInWalkers_(const int domain_index, const int parity);
+  void queueWalker_(const int walker_id);
+};
+
+}
+
+#endif // MYTHICAL_DOMAIN_DECOMPOSED_SYSTEM_HPP
@@ -4,21 +4,49 @@
 #include "constants.hpp"
 
 #include <cstddef>
-#include <deque>
+#include <cstdint>
+#include <utility>
+#include <vector>
 
 namespace mythical {
 
 /**
+ * \brief Event queue storing the global time at which each walker hops next
+ *
+ * Internally this is an indexed binary min heap keyed by walker id, so the
+ * walker that hops next can be found in constant time, and adding, popping
+ * or changing the time of a walker takes logarithmic time. Walker ids must
+ * be positive and a walker can only be stored once. Walkers with the same
+ * time come out in the order they were added or last updated.
+ *
+ * Walkers can also be added without sorting using `add`, in which case the
+ * queue keeps the order they were added in until `sort` is called. Popping
+ * the front of such a queue, or of one that is completely sorted, takes
+ * constant time.
  **/
 class Queue {
  public:
-  Queue() : sorted_(true) {};
+  Queue() : next_sequence_(0), head_(0), sorted_(true), fully_sorted_(true) {};
 
   /**
    * \brief get the walker at the front of the queue also removes from the list
+   *
+   * If the queue has not been sorted the first walker that was added is
+   * returned.
    **/
   std::pair<int,double> pop_current();
 
+  /**
+   * \brief Remove the walker with the smallest time, sorts the queue first
+   * if needed
+   **/
+  std::pair<int,double> pop();
+
+  /**
+   * \brief Walker with the smallest time, sorts the queue first if needed
+   **/
+  const std::pair<int,double> & peek();
+
   /**
    * \brief add to the queue, without sorting
    **/
@@ -27,31 +55,93 @@ class Queue {
   /**
    * @brief The walker is added in the correct order.
    *
+   * If walkers were added with `add` the queue is sorted first.
+   *
    * @param walker
    */
   void sortedAdd(std::pair<int,double> walker);
 
+  /**
+   * \brief Change the time of a walker already in the queue
+   *
+   * Works for both decreasing and increasing the time.
+   **/
+  void update(std::pair<int,double> walker);
+
+  /**
+   * \brief Remove a walker from the queue
+   **/
+  void erase(const int walker_id);
+
+  /**
+   * \brief Determine if the walker is in the queue
+   **/
+  bool contains(const int walker_id) const noexcept;
+
   bool isSorted() const noexcept;
 
-  void sort(); 
+  void sort();
 
   std::size_t size() const noexcept ;
+  bool empty() const noexcept { return heap_.size() == head_; }
 
+  /**
+   * \brief Return the walker at the index
+   *
+   * Index 0 is always the walker at the front of the queue, accessing any
+   * other index of a sorted queue orders the whole queue.
+   **/
   const std::pair<int,double> & at(int index) const;
  private:
   /**
    * The interger in the pair is the id of the walker and the double is global
    * dwell time of the walker.
    *
-   * The Deque has been chosen because will primarily be popping from the front
-   * which is faster than a list and not possible for a vector, also will
-   * require sorting, we do not need to worry about invalidating pointers either
-   * which means a list is not needed. 
-   *
+   * The walkers in the queue start at head_, the entries in front of it
+   * have been popped and are dropped once they make up half of the vector.
+   * When sorted the walkers form a binary min heap on the time. Mutable
+   * because `at` fully sorts the heap, a sorted vector is still a valid heap.
    **/
-  std::deque<std::pair<int,double>> walker_queue_;
+  mutable std::vector<std::pair<int,double>> heap_;
 
+  /// Position of each walker in heap_ indexed by the walker id,
+  /// constants::unassignedId if the walker is not in the queue
+  mutable std::vector<int> position_;
+
+  /// Order each walker was added or last updated in, breaks ties in time
+  std::vector<std::uint64_t> sequence_;
+  std::uint64_t next_sequence_;
+
+  /// Index in heap_ of the walker at the front of the queue
+  mutable std::size_t head_;
+
+  /// The queue is ordered by time, rather than by when walkers were added
   bool sorted_;
+
+  /// The heap is also completely sorted
+  mutable bool fully_sorted_;
+
+  /// True if the walker comes out of the queue before the other walker
+  bool before_(
+      const std::pair<int,double> & walker,
+      const std::pair<int,double> & other) const noexcept;
+  /// Indices count from the front of the queue rather than the start of heap_
+  void place_(const int index, const std::pair<int,double> & walker) const;
+  void siftUp_(int index);
+  void siftDown_(int index);
+  void removeAt_(const int index);
+  void sortAll_() const;
+  void dropPopped_();
+  void reindex_(const std::size_t from) const;
+  void checkId_(const int walker_id);
 };
+
+// Called on every comparison of the heap so it is kept inline
+inline bool Queue::before_(
+    const std::pair<int,double> & walker,
+    const std::pair<int,double> & other) const noexcept {
+  if(walker.second != other.second) return walker.second < other.second;
+  return sequence_[walker.first] < sequence_[other.first];
+}
 }
 #endif  // MYTHICAL_QUEUE_HPP
@@ -0,0 +1,118 @@
+#ifndef MYTHICAL_RATE_NETWORK_HPP
+#define MYTHICAL_RATE_NETWORK_HPP
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "sampling_method.hpp"
+
+namespace mythical {
+
+class RateGraph;
+
+/**
+ * \brief Rates off of every site in compressed sparse row format
+ *
+ * The rates off of the site of a row are stored between row_offsets[row]
+ * and row_offsets[row+1] of neighbor_ids and rates. The id of the site of
+ * each row is given by site_ids, if it is left empty the id of a site is the
+ * number of its row. An empty row makes a drain, as does any neighbor
+ * without a row.
+ **/
+struct RateTable {
+  std::vector<int> row_offsets;
+  std::vector<int> neighbor_ids;
+  std::vector<double> rates;
+  std::vector<int> site_ids;
+};
+
+/// Called with every rate off of a site, add_rate(siteId, neighId, rate)
+typedef std::function<void(const int siteId, const int neighId,
+    const double rate)> RateSink;
+
+/**
+ * \brief Called once with a sink, passes the rates between all the sites to
+ * the sink
+ *
+ * All the rates off of a site must be passed one after the other.
+ **/
+typedef std::function<void(const RateSink & add_rate)> RateGenerator;
+
+/**
+ * \brief The sites of a system and the rates between them, built once and
+ * shared by any number of systems
+ *
+ * Every site is given a row of a rate graph, sites that only appear as
+ * neighbors are given an empty row so they act as drains. Nothing can be
+ * changed once the network is built, so systems running on different
+ * threads can read it at the same time. Each system keeps its own
+ * occupancy, visit frequencies, random numbers and clusters, which makes
+ * running many seeds or replicas on the same rates cheap in memory.
+ *
+ * The neighbors of a site are picked with the sampling method the network
+ * was built with.
+ **/
+class RateNetwork {
+  public:
+    /**
+     * \brief Build a network from the rates off of each site
+     *
+     * Takes the same rates as CoarseGrainSystem::initializeSystem, the rates
+     * are copied.
+     **/
+    static std::shared_ptr<const RateNetwork> create(
+        const std::unordered_map<int, std::unordered_map<int, double>> & ratesOfAllSites,
+        const SamplingMethod sampling_method = SamplingMethod::linear);
+
+    /**
+     * \brief Build a network from a table of rates
+     *
+     * The arrays of the table are moved into the network rather than copied,
+     * the rows only have to be sorted by neighbor id if they are not
+     * already. Neighbors without a row are found while the index of each
+     * neighbor is looked up and are given empty rows, so they act as drains.
+     * Throws if the table is malformed.
+     **/
+    static std::shared_ptr<const RateNetwork> create(
+        RateTable rate_table,
+        const SamplingMethod sampling_method = SamplingMethod::linear);
+
+    /**
+     * \brief Build a network from rates passed one at a time
+     *
+     * The rates are appended straight to the rows of the network, no other
+     * copy of them is made. Throws if the rates off of a site are not passed
+     * one after the other.
+     **/
+    static std::shared_ptr<const RateNetwork> create(
+        const RateGenerator & generate,
+        const SamplingMethod sampling_method = SamplingMethod::linear);
+
+    int getNumberOfSites() const { return static_cast<int>(site_ids_.size()); }
+
+    /// Id of the site of each row of the rate graph
+    const std::vector<int> & getSiteIds() const { return site_ids_; }
+
+    std::shared_ptr<const RateGraph> getRateGraph() const { return rate_graph_; }
+
+    SamplingMethod getSamplingMethod() const { return sampling_method_; }
+
+  private:
+    RateNetwork() : sampling_method_(SamplingMethod::linear) {};
+
+    /// row_of_site is only read if the table has site ids
+    static std::shared_ptr<const RateNetwork> createFromRows_(
+        RateTable rate_table,
+        const std::unordered_map<int,int> & row_of_site,
+        const SamplingMethod sampling_method);
+
+    std::vector<int> site_ids_;
+    std::shared_ptr<const RateGraph> rate_graph_;
+    SamplingMethod sampling_method_;
+};
+
+}
+
+#endif // MYTHICAL_RATE_NETWORK_HPP
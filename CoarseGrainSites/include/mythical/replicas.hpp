@@ -0,0 +1,91 @@
+#ifndef MYTHICAL_REPLICAS_HPP
+#define MYTHICAL_REPLICAS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace mythical {
+
+/**
+ * \brief Run independent replicas on a pool of threads and reduce what they
+ * observe
+ *
+ * Each replica is run by calling task(replica) with replica going from 0 to
+ * replica_count-1, typically the task creates a CoarseGrainSystem from a
+ * shared RateNetwork, seeds it with the replica number and returns the
+ * observables it measured. The replicas are handed out to the threads as
+ * they become free, the results are then reduced in the order of the
+ * replicas with reduce(total, result) starting from the result of replica 0,
+ * so the total does not depend on the number of threads or how long each
+ * replica took.
+ *
+ * If a task throws the remaining replicas are not started and the first
+ * exception is rethrown once all the threads have finished.
+ *
+ * \param[in] replica_count number of replicas, must be at least 1
+ * \param[in] thread_count number of threads, 0 uses one per hardware thread
+ * \param[in] task callable taking the replica number and returning its
+ * observables, the result must be default constructible and movable
+ * \param[in] reduce callable adding the observables of a replica to the
+ * total
+ *
+ * \return the reduced observables
+ **/
+template<typename Task, typename Reduce>
+auto runReplicas(
+    const int replica_count,
+    int thread_count,
+    Task task,
+    Reduce reduce) -> decltype(task(0)) {
+
+  typedef decltype(task(0)) Observables;
+  if(replica_count < 1){
+    throw std::invalid_argument("At least one replica must be run.");
+  }
+  if(thread_count <= 0){
+    thread_count = std::max(1,static_cast<int>(std::thread::hardware_concurrency()));
+  }
+  thread_count = std::min(thread_count,replica_count);
+
+  std::vector<Observables> results(replica_count);
+  std::vector<std::exception_ptr> errors(replica_count);
+  std::atomic<int> next_replica(0);
+  std::atomic<bool> failed(false);
+
+  auto run = [&](){
+    int replica;
+    while(!failed && (replica = next_replica++) < replica_count){
+      try{
+        results[replica] = task(replica);
+      }catch(...){
+        errors[replica] = std::current_exception();
+        failed = true;
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count-1);
+  for(int thread = 1; thread < thread_count; ++thread) threads.emplace_back(run);
+  run();
+  for(std::thread & thread : threads) thread.join();
+
+  for(const std::exception_ptr & error : errors){
+    if(error) std::rethrow_exception(error);
+  }
+
+  Observables total = std::move(results[0]);
+  for(int replica = 1; replica < replica_count; ++replica){
+    reduce(total,results[replica]);
+  }
+  return total;
+}
+
+}
+
+#endif // MYTHICAL_REPLICAS_HPP
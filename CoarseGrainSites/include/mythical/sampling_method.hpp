@@ -0,0 +1,53 @@
+#ifndef MYTHICAL_SAMPLING_METHOD_HPP
+#define MYTHICAL_SAMPLING_METHOD_HPP
+
+namespace mythical {
+
+/**
+ * \brief Methods used to pick the site a walker will hop to next
+ *
+ * All the methods consume a single random number per pick, so switching
+ * between them does not change how many random numbers are drawn.
+ *
+ * linear
+ *
+ * Walks the cumulative probabilities until the random number is exceeded,
+ * O(n) per pick. This is the default and reproduces earlier results for a
+ * given seed.
+ *
+ * binary_search
+ *
+ * Bisects the cumulative probabilities, O(log n) per pick. Picks the same
+ * neighbor as linear for the same random number.
+ *
+ * alias
+ *
+ * Walker/Vose alias method, O(1) per pick with an O(n) table built whenever
+ * the probabilities are recalculated. Picks neighbors with the same
+ * probabilities but not the same neighbor as linear for a given random
+ * number.
+ *
+ * automatic
+ *
+ * Uses linear sampling for features with few neighbors, binary search for
+ * a moderate number and the alias method beyond that, see
+ * sampling_limits below.
+ **/
+enum class SamplingMethod {
+  linear,
+  binary_search,
+  alias,
+  automatic
+};
+
+namespace sampling_limits {
+  /// Automatic sampling uses linear sampling up to this number of outcomes
+  const int linear = 8;
+  /// Automatic sampling uses binary search up to this number of outcomes,
+  /// beyond it the alias method is used
+  const int binary_search = 16;
+}
+
+}
+
+#endif // MYTHICAL_SAMPLING_METHOD_HPP
@@ -0,0 +1,96 @@
+#ifndef MYTHICAL_WALKER_STORE_HPP
+#define MYTHICAL_WALKER_STORE_HPP
+
+#include "constants.hpp"
+#include "walker.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace mythical {
+
+/**
+ * \brief Stores the state of many walkers in contiguous arrays
+ *
+ * Rather than each walker being a separate object on the heap, the site each
+ * walker occupies, the site it will attempt to hop to, its dwell time and the
+ * global time of its next hop are each kept in their own array. The arrays
+ * are addressed by the walker index, which is also the id of the walker, so
+ * walker ids should be small non-negative integers no larger than
+ * constants::max_walker_id. Walkers that have been
+ * removed leave a gap that is reused if a walker with the same index is
+ * added again.
+ *
+ * The Walker class can still be used as a facade to a single walker, see
+ * `getWalker`.
+ **/
+class WalkerStore {
+ public:
+  WalkerStore() : count_(0) {};
+
+  /**
+   * \brief Add a walker occupying a site
+   *
+   * The potential site is left unassigned, the dwell time and the global time
+   * are set to 0.0.
+   **/
+  void add(const int walker_index, const int siteId);
+
+  void remove(const int walker_index);
+
+  bool exist(const int walker_index) const noexcept {
+    return walker_index >= 0 &&
+      walker_index < static_cast<int>(site_ids_.size()) &&
+      site_ids_[walker_index] != constants::unassignedId;
+  }
+
+  /// Number of walkers stored
+  std::size_t size() const noexcept { return count_; }
+
+  /// One past the largest walker index that has been stored
+  std::size_t capacity() const noexcept { return site_ids_.size(); }
+
+  /**
+   * \brief Reserve memory for walker indices up to count - 1
+   **/
+  void reserve(const std::size_t count);
+
+  /**
+   * No bounds checking is done by the getters and setters, the walker must
+   * exist.
+   **/
+  int getSiteId(const int walker_index) const { return site_ids_[walker_index]; }
+  void setSiteId(const int walker_index, const int siteId) { site_ids_[walker_index] = siteId; }
+
+  int getPotentialSiteId(const int walker_index) const { return potential_site_ids_[walker_index]; }
+  void setPotentialSiteId(const int walker_index, const int siteId) { potential_site_ids_[walker_index] = siteId; }
+
+  double getDwellTime(const int walker_index) const { return dwell_times_[walker_index]; }
+  void setDwellTime(const int walker_index, const double dwell_time) { dwell_times_[walker_index] = dwell_time; }
+
+  /// Global time at which the walker will hop next
+  double getGlobalTime(const int walker_index) const { return global_times_[walker_index]; }
+  void setGlobalTime(const int walker_index, const double time) { global_times_[walker_index] = time; }
+
+  /**
+   * \brief Access to the whole arrays, removed walkers have a site id of
+   * constants::unassignedId
+   **/
+  const std::vector<int> & getSiteIds() const noexcept { return site_ids_; }
+  const std::vector<int> & getPotentialSiteIds() const noexcept { return potential_site_ids_; }
+  const std::vector<double> & getDwellTimes() const noexcept { return dwell_times_; }
+  const std::vector<double> & getGlobalTimes() const noexcept { return global_times_; }
+
+  /**
+   * \brief Copy the state of a walker into a Walker object
+   **/
+  Walker getWalker(const int walker_index) const;
+ private:
+  std::vector<int> site_ids_;
+  std::vector<int> potential_site_ids_;
+  std::vector<double> dwell_times_;
+  std::vector<double> global_times_;
+  std::size_t count_;
+};
+}
+#endif  // MYTHICAL_WALKER_STORE_HPP
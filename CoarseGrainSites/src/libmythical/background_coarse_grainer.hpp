@@ -0,0 +1,64 @@
+#ifndef MYTHICAL_BACKGROUND_COARSE_GRAINER_HPP
+#define MYTHICAL_BACKGROUND_COARSE_GRAINER_HPP
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include "mythical/coarsegrainsystem.hpp"
+#include "topologyfeatures/cluster.hpp"
+
+namespace mythical {
+
+/**
+ * \brief What was found when looking for a basin to coarse grain
+ **/
+struct CoarseGrainPlan {
+  enum class Action {
+    none,
+    create_cluster,
+    merge_with_clusters
+  };
+
+  CoarseGrainPlan() : action(Action::none), internal_time_limit(0.0) {};
+
+  Action action;
+  /// Sites of the basin that was found
+  std::vector<int> site_ids;
+  double internal_time_limit;
+  /// Built and solved ahead of time when a cluster is created
+  std::unique_ptr<Cluster> cluster;
+  /// Every attempt made while looking for the basin
+  std::vector<CoarseGrainAttempt> attempts;
+};
+
+/**
+ * \brief Runs the search for a coarse grain plan on a helper thread
+ *
+ * At most one search is in flight at a time. The task may only read state
+ * that does not change while the walkers hop, the plan it returns is put
+ * into effect by the thread that owns the system.
+ **/
+class BackgroundCoarseGrainer {
+  public:
+    ~BackgroundCoarseGrainer() { wait(); }
+
+    void start(std::function<CoarseGrainPlan()> task) {
+      plan_ = std::async(std::launch::async,task);
+    }
+
+    bool pending() const { return plan_.valid(); }
+
+    void wait() const { if(plan_.valid()) plan_.wait(); }
+
+    /// Waits for the plan if it is not ready yet, the worker is then idle
+    CoarseGrainPlan collect() { return plan_.get(); }
+
+  private:
+    std::future<CoarseGrainPlan> plan_;
+};
+
+}
+
+#endif // MYTHICAL_BACKGROUND_COARSE_GRAINER_HPP
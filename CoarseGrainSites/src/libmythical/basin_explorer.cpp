@@ -1,30 +1,26 @@
 
-#include <unordered_set>
+#include <algorithm>
 
 #include "basin_explorer.hpp"
-#include "graph_library_adapter.hpp"
-#include "ugly/graphvisitor/graphvisitor_largest_known_value.hpp"
+#include "rate_graph.hpp"
 
-using namespace ugly;
 using namespace std;
 
 namespace mythical {
 
-  typedef unordered_set<shared_ptr<Edge>> shared_edge_set;
-  typedef vector<weak_ptr<Edge>> weak_edge_vec;
-
-  vector<int> BasinExplorer::findBasin(
+  const vector<int> & BasinExplorer::findBasin(
       Site_Container& sites,
       Cluster_Container& clusters,
       int siteId){
-    
-    auto edges_store = 
-      convertSitesOutgoingRatesToSharedWeightedEdges<shared_edge_set>( sites, siteId);
-
-    weak_edge_vec edges_weak(edges_store.begin(),edges_store.end());
 
-    GraphVisitorLargestKnownValue gv_largest_known;
-    gv_largest_known.setStartingVertex(siteId);
+    if(explored_in_search_.size() < sites.size()){
+      explored_in_search_.resize(sites.size(),0);
+    }
+    ++search_;
+    explored_.clear();
+    frontier_.clear();
+    edges_added_ = 0;
+    limit_reached_ = false;
 
     fastest_rate_ = sites.getFastestRateOffSite(siteId);
     if(sites.partOfCluster(siteId)){
@@ -35,56 +31,71 @@ namespace mythical {
     }
     current_sites_fastest_rate_ = fastest_rate_;
 
-    addEdges_(sites,edges_weak,siteId,gv_largest_known);
-
-    int exploration_count = 1;
+    explore_(sites,siteId,sites.getIndex(siteId));
 
-    while(gv_largest_known.allEdgesExplored()==false){
-      weak_ptr<Edge> next_edge = gv_largest_known.getNextEdge<Edge>();
+    while(!frontier_.empty()){
+      pop_heap(frontier_.begin(),frontier_.end(),slowerEdge_);
+      const FrontierEdge next_edge = frontier_.back();
+      frontier_.pop_back();
+      // The site was reached by a faster rate since the edge was added
+      if(isExplored_(next_edge.index)) continue;
 
-      auto next_vertex = gv_largest_known.chooseTerminalVertex(next_edge);
+      explore_(sites,next_edge.siteId,next_edge.index);
 
-      gv_largest_known.exploreEdge(next_edge);
-      auto edges_tmp = convertSitesOutgoingRatesToSharedWeightedEdges<shared_edge_set>( sites, next_vertex);
-      
-      weak_edge_vec edges_weak_tmp(edges_tmp.begin(),edges_tmp.end());
-      edges_store.insert(edges_tmp.begin(),edges_tmp.end());
-
-      addEdges_(sites,edges_weak_tmp,next_vertex,gv_largest_known);
- 
-      ++exploration_count; 
-      if(gv_largest_known.countExploredVertices()>max_exploration_count_){
-        vector<int> empty_vec;
-        return empty_vec;
+      if(explored_.size()>max_exploration_count_){
+        explored_count_ = static_cast<int>(explored_.size());
+        limit_reached_ = true;
+        explored_.clear();
+        return explored_;
       }
     }
-    return gv_largest_known.getExploredVertices();
+    explored_count_ = static_cast<int>(explored_.size());
+    return explored_;
+  }
 
+  bool BasinExplorer::slowerEdge_(
+      const FrontierEdge & edge1,
+      const FrontierEdge & edge2){
+    if(edge1.rate != edge2.rate) return edge1.rate < edge2.rate;
+    return edge1.order > edge2.order;
   }
 
-  void BasinExplorer::addEdges_(
-      Site_Container& sites,
-      weak_edge_vec edges_weak,
-      int vertex,
-      GraphVisitorLargestKnownValue & gv_largest_known){
-
-    for(auto edge : edges_weak){
-      if(gv_largest_known.edgeCanBeAdded(edge)){
-        double rate = getRate_(sites,edge, vertex);
-        updateFastestRate_(rate);
-
-        current_sites_fastest_rate_ = sites.getFastestRateOffSite(vertex);
-        // The problem with this is it is updating as it accessing nodes.
-
-        if(rateFastEnough_(rate)){
-          
-          gv_largest_known.addEdge(edge);
-          // Update the slowest rate
-          updateSlowestRate_(rate);
-        }
+  void BasinExplorer::explore_(
+      Site_Container & sites,
+      const int & siteId,
+      const int & index){
+    explored_in_search_[index] = search_;
+    explored_.push_back(siteId);
+    addEdges_(sites,index);
+  }
+
+  void BasinExplorer::addEdges_(Site_Container & sites, const int & index){
+
+    Site & site = sites.getSiteByIndex(index);
+    current_sites_fastest_rate_ = site.getFastestRate();
+
+    const RateGraph & graph = site.getRateGraph();
+    const int row = site.getRateGraphRow();
+    const int end = graph.getRowEnd(row);
+    for(int entry = graph.getRowBegin(row); entry < end; ++entry){
+      const int neighId = graph.getNeighborId(entry);
+      // Sites outside of the container cannot be part of a basin
+      if(!sites.exist(neighId)) continue;
+      const int neigh_index = sites.getIndex(neighId);
+      if(isExplored_(neigh_index)) continue;
+
+      double rate = graph.getRate(entry);
+      // The problem with this is it is updating as it accessing nodes.
+      updateFastestRate_(rate);
+
+      if(rateFastEnough_(rate)){
+        frontier_.push_back({rate,edges_added_,neighId,neigh_index});
+        push_heap(frontier_.begin(),frontier_.end(),slowerEdge_);
+        ++edges_added_;
+        // Update the slowest rate
+        updateSlowestRate_(rate);
       }
     }
-
   }
 
   void BasinExplorer::setThreshold(double threshold){
@@ -115,15 +126,4 @@ namespace mythical {
     return false;
   }
 
-  double BasinExplorer::getRate_(Site_Container& sites,std::weak_ptr<Edge> edge, int vertex){
-    double rate;
-    if(auto ed = edge.lock()){
-      rate = sites.getRateToNeighborOfSite(vertex,ed->getOtherVertex(vertex));
-    }else{
-      throw runtime_error("Edge is no longer accesible in memory.");
-    }
-    return rate;
-  }
-
 }
-
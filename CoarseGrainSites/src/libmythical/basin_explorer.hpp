@@ -5,33 +5,93 @@
 
 #include "site_container.hpp"
 #include "cluster_container.hpp"
-#include "ugly/graphvisitor/graphvisitor_largest_known_value.hpp"
 
 namespace mythical {
 
+/**
+ * \brief Finds the basin of sites connected by fast rates around a site
+ *
+ * Starting from a site the explorer repeatedly follows the fastest known rate
+ * leading to a site that has not been explored, only rates that are fast
+ * enough compared to the other rates seen are followed. The rates that can be
+ * followed are kept in a max heap. Explored sites are marked in an array
+ * indexed by the dense site index, the marks are stamped with the number of
+ * the search so they do not need to be cleared between searches. All the
+ * buffers are kept between searches so a search allocates nothing once they
+ * have grown, and only the rows of the sites explored are read.
+ **/
 class BasinExplorer{
   public:
-    BasinExplorer() : threshold_(0.95), max_exploration_count_(5) {};
+    BasinExplorer() :
+      threshold_(0.95),
+      max_exploration_count_(5),
+      limit_reached_(false),
+      explored_count_(0),
+      search_(0) {};
     void setThreshold(double threshold);
+    double getThreshold() const { return threshold_; }
     void setMaxExplorationCount(int count);
-    std::vector<int> findBasin(Site_Container& sites,Cluster_Container& clusters, int siteId);
+    int getMaxExplorationCount() const {
+      return static_cast<int>(max_exploration_count_);
+    }
+
+    /// True if the last search was abandoned because the basin had more
+    /// sites than the max exploration count
+    bool limitReached() const { return limit_reached_; }
+
+    /// Number of sites explored by the last search, including abandoned ones
+    int getNumberOfExploredSites() const { return explored_count_; }
+
+    /**
+     * \brief Explore the basin around a site
+     *
+     * \return the site ids of the basin, starting with siteId, or an empty
+     * vector if the basin has more sites than the max exploration count. The
+     * reference is valid until the next search.
+     **/
+    const std::vector<int> & findBasin(
+        Site_Container& sites,
+        Cluster_Container& clusters,
+        int siteId);
   private:
     double threshold_;
     double fastest_rate_;
     double slowest_rate_;
     double current_sites_fastest_rate_; 
     size_t max_exploration_count_;
+    bool limit_reached_;
+    int explored_count_;
+
+    /// A rate from an explored site to a site that may not be explored yet
+    struct FrontierEdge {
+      double rate;
+      /// Order the edge was added in, the earliest wins ties
+      long order;
+      int siteId;
+      int index;
+    };
+    static bool slowerEdge_(const FrontierEdge & edge1, const FrontierEdge & edge2);
+
+    /// Max heap of the rates that can be followed
+    std::vector<FrontierEdge> frontier_;
+    long edges_added_;
+
+    /// Site ids of the explored sites in the order they were explored
+    std::vector<int> explored_;
+
+    /// explored_in_search_[index] is the search the site was explored in
+    std::vector<unsigned long> explored_in_search_;
+    unsigned long search_;
 
     bool rateFastEnough_(double rate);
-    double getRate_(Site_Container& sites, std::weak_ptr<ugly::Edge> edge, int vertex);
     void updateFastestRate_(double rate);
     void updateSlowestRate_(double rate);
 
-    void addEdges_(
-        Site_Container& sites,
-        std::vector<std::weak_ptr<ugly::Edge>> edges_weak, 
-        int vertex, 
-        ugly::GraphVisitorLargestKnownValue & gv_largest_known);
+    bool isExplored_(const int & index) const {
+      return explored_in_search_[index]==search_;
+    }
+    void explore_(Site_Container & sites, const int & siteId, const int & index);
+    void addEdges_(Site_Container & sites, const int & index);
 };
 
 
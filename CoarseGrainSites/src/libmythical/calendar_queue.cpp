@@ -0,0 +1,235 @@
+
+#include "mythical/calendar_queue.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+  /// Number of earliest walkers used to estimate the width of a bucket
+  const size_t width_sample = 25;
+
+  struct later_than
+  {
+    inline bool operator() (const pair<int,double>& struct1, const pair<int,double>& struct2)
+    {
+      return (struct1.second > struct2.second);
+    }
+  };
+}
+
+namespace mythical {
+
+  CalendarQueue::CalendarQueue() :
+    buckets_(2),
+    size_(0),
+    calendar_size_(0),
+    width_(1.0),
+    current_window_(0.0),
+    current_bucket_(0),
+    year_end_(2.0) {}
+
+  void CalendarQueue::sortedAdd(pair<int,double> walker){
+    checkId_(walker.first);
+    if(size_ == 0) startYear_(windowOf_(walker.second));
+    insert_(walker);
+    in_queue_[walker.first] = true;
+    ++size_;
+    if(size_ > 2*buckets_.size()) resize_(2*buckets_.size());
+  }
+
+  pair<int,double> CalendarQueue::pop(){
+    if(size_ == 0){
+      throw out_of_range("Cannot pop walker from an empty calendar queue.");
+    }
+    auto & bucket = buckets_[findEarliestBucket_()];
+    pair<int,double> walker = bucket.back();
+    bucket.pop_back();
+    in_queue_[walker.first] = false;
+    --calendar_size_;
+    --size_;
+    if(buckets_.size() > 2 && size_ < buckets_.size()/2){
+      resize_(buckets_.size()/2);
+    }
+    return walker;
+  }
+
+  const pair<int,double> & CalendarQueue::peek(){
+    if(size_ == 0){
+      throw out_of_range("Cannot peek at an empty calendar queue.");
+    }
+    return buckets_[findEarliestBucket_()].back();
+  }
+
+  void CalendarQueue::update(pair<int,double> walker){
+    if(!contains(walker.first)){
+      throw invalid_argument("Cannot update walker it is not in the queue.");
+    }
+    remove_(walker.first);
+    if(size_ == 1) startYear_(windowOf_(walker.second));
+    insert_(walker);
+  }
+
+  void CalendarQueue::erase(const int walker_id){
+    if(!contains(walker_id)){
+      throw invalid_argument("Cannot erase walker it is not in the queue.");
+    }
+    remove_(walker_id);
+    in_queue_[walker_id] = false;
+    --size_;
+    if(buckets_.size() > 2 && size_ < buckets_.size()/2){
+      resize_(buckets_.size()/2);
+    }
+  }
+
+  bool CalendarQueue::contains(const int walker_id) const noexcept {
+    return walker_id >= 0 &&
+      walker_id < static_cast<int>(in_queue_.size()) &&
+      in_queue_[walker_id];
+  }
+
+  /****************************************************************************
+   * Private Internal Functions
+   ****************************************************************************/
+
+  double CalendarQueue::windowOf_(const double time) const {
+    return floor(time/width_);
+  }
+
+  size_t CalendarQueue::bucketOf_(const double window) const {
+    const double number_of_buckets = static_cast<double>(buckets_.size());
+    double bucket = fmod(window,number_of_buckets);
+    if(bucket < 0.0) bucket += number_of_buckets;
+    return static_cast<size_t>(bucket);
+  }
+
+  void CalendarQueue::insert_(const pair<int,double> & walker){
+    const double window = windowOf_(walker.second);
+    time_of_[walker.first] = walker.second;
+    if(window >= year_end_){
+      later_walkers_.sortedAdd(walker);
+      return;
+    }
+    auto & bucket = buckets_[bucketOf_(window)];
+    auto position = upper_bound(bucket.begin(),bucket.end(),walker,later_than());
+    bucket.insert(position,walker);
+    ++calendar_size_;
+    // Walkers earlier than the search window move the search back
+    if(calendar_size_ == 1 || window < current_window_){
+      current_window_ = window;
+      current_bucket_ = bucketOf_(window);
+    }
+  }
+
+  void CalendarQueue::remove_(const int walker_id){
+    if(later_walkers_.contains(walker_id)){
+      later_walkers_.erase(walker_id);
+      return;
+    }
+    auto & bucket = buckets_[bucketOf_(windowOf_(time_of_[walker_id]))];
+    for(auto walker = bucket.begin(); walker != bucket.end(); ++walker){
+      if(walker->first == walker_id){
+        bucket.erase(walker);
+        break;
+      }
+    }
+    --calendar_size_;
+  }
+
+  void CalendarQueue::startYear_(const double window){
+    current_window_ = window;
+    current_bucket_ = bucketOf_(window);
+    year_end_ = window + static_cast<double>(buckets_.size());
+  }
+
+  void CalendarQueue::estimateWidth_(vector<double> & times){
+    // The width is a few times the average separation of the earliest
+    // walkers, so the walkers hopping next are spread over the buckets
+    const size_t sample = min(width_sample,times.size());
+    if(sample < 2) return;
+    nth_element(times.begin(),times.begin()+sample-1,times.end());
+    std::sort(times.begin(),times.begin()+sample);
+    const double separation = (times[sample-1]-times[0])/(sample-1);
+    if(separation > 0.0 && isfinite(separation)) width_ = 3.0*separation;
+  }
+
+  size_t CalendarQueue::findEarliestBucket_(){
+    if(calendar_size_ == 0) refill_();
+
+    // Step through the calendar one window at a time, one full year at most
+    for(size_t step = 0; step < buckets_.size(); ++step){
+      const auto & bucket = buckets_[current_bucket_];
+      if(!bucket.empty() && windowOf_(bucket.back().second) <= current_window_){
+        return current_bucket_;
+      }
+      ++current_bucket_;
+      if(current_bucket_ == buckets_.size()) current_bucket_ = 0;
+      current_window_ += 1.0;
+    }
+
+    // Walkers added out of order can leave gaps longer than a year, search
+    // the buckets directly
+    double earliest = numeric_limits<double>::max();
+    for(const auto & bucket : buckets_){
+      if(!bucket.empty() && bucket.back().second < earliest){
+        earliest = bucket.back().second;
+      }
+    }
+    current_window_ = windowOf_(earliest);
+    current_bucket_ = bucketOf_(current_window_);
+    return current_bucket_;
+  }
+
+  void CalendarQueue::refill_(){
+    // Start the next year from the earliest walkers waiting in the heap
+    vector<pair<int,double>> earliest;
+    vector<double> times;
+    while(!later_walkers_.empty() && earliest.size() < width_sample){
+      earliest.push_back(later_walkers_.pop());
+      times.push_back(earliest.back().second);
+    }
+    estimateWidth_(times);
+    startYear_(windowOf_(earliest.front().second));
+    for(const auto & walker : earliest) insert_(walker);
+    while(!later_walkers_.empty() &&
+        windowOf_(later_walkers_.peek().second) < year_end_){
+      insert_(later_walkers_.pop());
+    }
+  }
+
+  void CalendarQueue::resize_(const size_t number_of_buckets){
+    vector<pair<int,double>> walkers;
+    walkers.reserve(size_);
+    for(const auto & bucket : buckets_){
+      walkers.insert(walkers.end(),bucket.begin(),bucket.end());
+    }
+    while(!later_walkers_.empty()) walkers.push_back(later_walkers_.pop());
+
+    vector<double> times;
+    times.reserve(walkers.size());
+    for(const auto & walker : walkers) times.push_back(walker.second);
+    estimateWidth_(times);
+
+    buckets_.assign(number_of_buckets,vector<pair<int,double>>());
+    calendar_size_ = 0;
+    if(walkers.empty()) return;
+    startYear_(windowOf_(*min_element(times.begin(),times.end())));
+    for(const auto & walker : walkers) insert_(walker);
+  }
+
+  void CalendarQueue::checkId_(const int walker_id){
+    if(walker_id < 0){
+      throw invalid_argument("Walker ids stored in the queue must be positive.");
+    }
+    if(contains(walker_id)){
+      throw invalid_argument("Walker is already stored in the queue.");
+    }
+    if(walker_id >= static_cast<int>(in_queue_.size())){
+      in_queue_.resize(walker_id+1,false);
+      time_of_.resize(walker_id+1,0.0);
+    }
+  }
+}
@@ -1,8 +1,13 @@
 
 #include "mythical/charge_transport/cuboid_lattice.hpp"
+#include "mythical/charge_transport/neighbor_stencil.hpp"
 
+#include <algorithm>
+#include <exception>
 #include <iostream>
+#include <numeric>
 #include <string>
+#include <thread>
 #include <vector>
 #include <stdexcept>
 
@@ -154,6 +159,45 @@ namespace mythical {
     }
 
 
+    void Cuboid::visitSlab_(const NeighborStencil & stencil,
+        const int x_begin,
+        const int x_end,
+        const NeighborVisitor & visitor) const {
+
+      std::vector<int> neighbor_indices;
+      std::vector<double> distances;
+      std::vector<std::pair<int,double>> images;
+      neighbor_indices.reserve(stencil.size());
+      distances.reserve(stencil.size());
+
+      for ( int z = 0; z < height_; ++z ) {
+        for ( int y = 0; y < width_; ++y ) {
+          for ( int x = x_begin; x < x_end; ++x ) {
+            const int index = getIndex_(x, y, z);
+            stencil.getNeighbors(index, neighbor_indices, distances);
+
+            if ( stencil.repeatsImages() ) {
+              // Keep the closest image of each neighbor
+              images.clear();
+              for ( size_t neigh = 0; neigh < neighbor_indices.size(); ++neigh ) {
+                images.emplace_back(neighbor_indices[neigh], distances[neigh]);
+              }
+              std::sort(images.begin(), images.end());
+              neighbor_indices.clear();
+              distances.clear();
+              for ( const std::pair<int,double> & image : images ) {
+                if ( neighbor_indices.empty() || neighbor_indices.back() != image.first ) {
+                  neighbor_indices.push_back(image.first);
+                  distances.push_back(image.second);
+                }
+              }
+            }
+            visitor(index, neighbor_indices, distances);
+          } // for x
+        } // for y
+      } // for z
+    }
+
     int Cuboid::getXPeriodic_( const int x ) const noexcept{
       if(x<0){
         return x+length_;
@@ -441,65 +485,83 @@ namespace mythical {
 
     std::unordered_map<int, std::unordered_map<int,double>> Cuboid::getNeighborDistances(const double cutoff) const {
 
-      // Calculate the number of sites that will be within the cutoff 
-      int num_sites = static_cast<int>(std::floor(cutoff/inter_site_distance_));  
-      
-      int total_num_sites = length_*width_*height_;
-      // So as not to return redundant info, only provide distance if the 
-      // neighbor has a smaller index
       std::unordered_map<int, std::unordered_map<int, double>> neigh_distances;
-
-      for ( int index = 0; index < total_num_sites; ++index ) {
-        
-        std::vector<int> pos_i = getPos_(index);
-        const int x = pos_i.at(0);
-        const int y = pos_i.at(1);
-        const int z = pos_i.at(2);
-
-        const int x_min = x - num_sites;
-        const int x_max = x;
-        const int y_min = y - num_sites;
-        const int y_max = y;
-        const int z_min = z - num_sites;
-        const int z_max = z;
-
-        for ( int x_ind = x_min; x_ind <= x_max; ++x_ind ) {
-          int x_lattice_pos = x_ind;
-          if ( x_bound_ == BoundarySetting::Periodic ) {
-            x_lattice_pos = getXPeriodic_(x_ind);
-          }       
-          if ( x_lattice_pos >= 0 && x_lattice_pos < length_ ) {
-            for ( int y_ind = y_min; y_ind <= y_max; ++y_ind ) {
-              int y_lattice_pos = y_ind;
-              if ( y_bound_ == BoundarySetting::Periodic ) {
-                y_lattice_pos = getYPeriodic_(y_ind);
-              }       
-              if ( y_lattice_pos >= 0 && y_lattice_pos < width_ ) {
-                for ( int z_ind = z_min; z_ind <= z_max; ++z_ind ){
-                  int z_lattice_pos = z_ind;
-
-                  if ( z_bound_ == BoundarySetting::Periodic ) {
-                    z_lattice_pos = getZPeriodic_(z_ind);
-                  }       
-                  if ( z_lattice_pos >= 0 && z_lattice_pos < height_ ) {
-                    double dist = getDistance_(x_ind, y_ind, z_ind, pos_i.at(0), pos_i.at(1), pos_i.at(2));
-                    if ( dist <= cutoff ) {
-                      int neigh_index = getIndex_(x_lattice_pos, y_lattice_pos, z_lattice_pos);
-                      if ( neigh_index != index ) {
-                        neigh_distances[neigh_index][index] = dist;
-                        neigh_distances[index][neigh_index] = dist;
-                      }
-                    }
-                  }
-                } // for z
-              }
-            } // for y
-          }
-        } // for x
-      } // index
+      visitNeighborDistances(cutoff,
+          [&](const int index, const std::vector<int> & neighbor_indices,
+            const std::vector<double> & distances) {
+            if ( neighbor_indices.empty() ) return;
+            std::unordered_map<int, double> & neighbors = neigh_distances[index];
+            neighbors.reserve(neighbor_indices.size());
+            for ( size_t neigh = 0; neigh < neighbor_indices.size(); ++neigh ) {
+              neighbors[neighbor_indices[neigh]] = distances[neigh];
+            }
+          });
       return neigh_distances;
     }
 
+    void Cuboid::visitNeighborDistances(const double cutoff,
+        NeighborVisitor visitor,
+        int thread_count) const {
+
+      if ( thread_count <= 0 ) {
+        thread_count = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+      }
+      thread_count = std::max(1, std::min(thread_count, length_));
+
+      const NeighborStencil stencil(*this, cutoff);
+
+      std::vector<std::exception_ptr> errors(thread_count);
+      auto visit = [&](const int slab) {
+        try {
+          visitSlab_(stencil,
+              slab * length_ / thread_count,
+              (slab + 1) * length_ / thread_count,
+              visitor);
+        } catch (...) {
+          errors[slab] = std::current_exception();
+        }
+      };
+
+      std::vector<std::thread> threads;
+      threads.reserve(thread_count-1);
+      for ( int slab = 1; slab < thread_count; ++slab ) threads.emplace_back(visit, slab);
+      visit(0);
+      for ( std::thread & thread : threads ) thread.join();
+
+      for ( const std::exception_ptr & error : errors ) {
+        if ( error ) std::rethrow_exception(error);
+      }
+    }
+
+    NeighborList Cuboid::getNeighborList(const double cutoff,
+        int thread_count) const {
+
+      // Count the neighbors of each site first so the rows can be written in
+      // place by the slabs without any locking
+      NeighborList neighbor_list;
+      neighbor_list.row_offsets.assign(total_+1, 0);
+      visitNeighborDistances(cutoff,
+          [&](const int index, const std::vector<int> & neighbor_indices,
+            const std::vector<double> &) {
+            neighbor_list.row_offsets[index+1] = neighbor_indices.size();
+          }, thread_count);
+      std::partial_sum(neighbor_list.row_offsets.begin(),
+          neighbor_list.row_offsets.end(), neighbor_list.row_offsets.begin());
+
+      neighbor_list.neighbor_indices.resize(neighbor_list.row_offsets.back());
+      neighbor_list.distances.resize(neighbor_list.row_offsets.back());
+      visitNeighborDistances(cutoff,
+          [&](const int index, const std::vector<int> & neighbor_indices,
+            const std::vector<double> & distances) {
+            const size_t begin = neighbor_list.row_offsets[index];
+            std::copy(neighbor_indices.begin(), neighbor_indices.end(),
+                neighbor_list.neighbor_indices.begin() + begin);
+            std::copy(distances.begin(), distances.end(),
+                neighbor_list.distances.begin() + begin);
+          }, thread_count);
+      return neighbor_list;
+    }
+
     double Cuboid::getSmallestDistance(const int index1, const int index2) const {
       checkIndex_(index1);
       checkIndex_(index2);
@@ -15,7 +15,32 @@ namespace mythical {
 
     double Marcus::getRate(const double E_i, const double E_j, const double H_AB) const noexcept {
       // DeltaG = E_j - E_i 
-      return pre_factor_ * H_AB * H_AB * std::exp(-1.0*std::pow(lambda_ + E_j - E_i,2.0)/expon_denom_);
+      const double energy = lambda_ + E_j - E_i;
+      return pre_factor_ * H_AB * H_AB * std::exp(-1.0*energy*energy/expon_denom_);
+    }
+
+    void Marcus::getRates(const size_t count,
+        const double * E_i,
+        const double * E_j,
+        const double * H_AB,
+        double * rates,
+        const ExpPrecision precision) const noexcept {
+
+      // Divide once rather than for every hop
+      const double inv_expon_denom = -1.0/expon_denom_;
+      if ( precision == ExpPrecision::fast ) {
+        for ( size_t hop = 0; hop < count; ++hop ) {
+          const double energy = lambda_ + E_j[hop] - E_i[hop];
+          rates[hop] = pre_factor_ * H_AB[hop] * H_AB[hop] *
+            fastExp(energy*energy*inv_expon_denom);
+        }
+      } else {
+        for ( size_t hop = 0; hop < count; ++hop ) {
+          const double energy = lambda_ + E_j[hop] - E_i[hop];
+          rates[hop] = pre_factor_ * H_AB[hop] * H_AB[hop] *
+            std::exp(-1.0*energy*energy/expon_denom_);
+        }
+      }
     }
   }
 }
@@ -0,0 +1,14 @@
+#include "mythical/charge_transport/miller_abrahams.hpp"
+#include "mythical/constants.hpp"
+
+using namespace mythical::constants;
+
+namespace mythical {
+  namespace charge_transport {
+
+    MillerAbrahams::MillerAbrahams(const double nu_0, const double a, const double T) :
+      nu_0_(nu_0),
+      distance_factor_(-2.0/a),
+      inv_k_B_T_(1.0/(k_B*T)) {}
+  }
+}
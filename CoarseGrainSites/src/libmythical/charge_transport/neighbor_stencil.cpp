@@ -0,0 +1,81 @@
+
+#include "mythical/charge_transport/neighbor_stencil.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace std;
+namespace mythical {
+
+  namespace charge_transport {
+
+    /**************************************************************************
+     * Internal Methods
+     *************************************************************************/
+    std::vector<int> NeighborStencil::getWrapTable_(const int size,
+        const int reach,
+        const bool periodic) {
+
+      std::vector<int> wrap_table(size + 2*reach, -1);
+      for ( int pos = -reach; pos < size + reach; ++pos ) {
+        if ( pos >= 0 && pos < size ) {
+          wrap_table[pos + reach] = pos;
+        } else if ( periodic && size > 0 ) {
+          wrap_table[pos + reach] = ((pos % size) + size) % size;
+        }
+      }
+      return wrap_table;
+    }
+
+    /**************************************************************************
+     * Public Methods
+     *************************************************************************/
+    NeighborStencil::NeighborStencil(const Cuboid & lattice, const double cutoff) :
+      length_(lattice.getLength()),
+      width_(lattice.getWidth()),
+      height_(lattice.getHeight()),
+      reach_(std::max(0, static_cast<int>(std::floor(cutoff/lattice.getLatticeSpacing())))),
+      cutoff_(cutoff)
+    {
+      const double spacing = lattice.getLatticeSpacing();
+      for ( int z = -reach_; z <= reach_; ++z ) {
+        for ( int y = -reach_; y <= reach_; ++y ) {
+          for ( int x = -reach_; x <= reach_; ++x ) {
+            if ( x == 0 && y == 0 && z == 0 ) continue;
+            double dist = std::pow(static_cast<double>(x*x + y*y + z*z), 0.5) * spacing;
+            if ( dist <= cutoff ) {
+              offset_x_.push_back(x);
+              offset_y_.push_back(y);
+              offset_z_.push_back(z);
+              index_deltas_.push_back((z*length_*width_) + (y*length_) + x);
+              distances_.push_back(dist);
+            }
+          }
+        }
+      }
+
+      const int span = 2*reach_ + 1;
+      repeats_images_ = ( lattice.isXPeriodic() && span > length_ ) ||
+        ( lattice.isYPeriodic() && span > width_ ) ||
+        ( lattice.isZPeriodic() && span > height_ );
+
+      wrap_x_ = getWrapTable_(length_, reach_, lattice.isXPeriodic());
+      wrap_y_ = getWrapTable_(width_, reach_, lattice.isYPeriodic());
+      wrap_z_ = getWrapTable_(height_, reach_, lattice.isZPeriodic());
+    }
+
+    size_t NeighborStencil::getNeighbors(const int index,
+        std::vector<int> & neighbor_indices,
+        std::vector<double> & distances) const {
+
+      neighbor_indices.clear();
+      distances.clear();
+      visitNeighbors(index, [&](const int neigh_index, const double dist) {
+          neighbor_indices.push_back(neigh_index);
+          distances.push_back(dist);
+        });
+      return neighbor_indices.size();
+    }
+  } // charge_transport
+} // mythical
@@ -1,10 +1,13 @@
 
 #include <algorithm>
+#include <cassert>
 #include <chrono>
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <set>
 #include <stdexcept>
+#include <string>
 #include <unordered_set>
 
 #include "mythical/coarsegrainsystem.hpp"
@@ -15,10 +18,17 @@
 #include "topologyfeatures/cluster.hpp"
 #include "topologyfeatures/site.hpp"
 #include "log.hpp"
+#include "background_coarse_grainer.hpp"
 #include "basin_explorer.hpp"
 #include "graph_library_adapter.hpp"
+#include "hot_site_sketch.hpp"
+#include "random_numbers.hpp"
 #include "site_container.hpp"
+#include "walker_random_streams.hpp"
 #include "cluster_container.hpp"
+#include "mythical/rate_network.hpp"
+#include "rate_graph.hpp"
+#include "shortest_paths.hpp"
 
 #include "../../../UGLY/include/ugly/pair_hash.hpp"
 #include "../../../UGLY/include/ugly/edge_directed_weighted.hpp"
@@ -45,6 +55,10 @@ namespace mythical {
 
   size_t countUniqueClusters(const unordered_map<int,int> & sites_and_clusters);
   int getFavoredClusterId(unordered_map<int,int> sites_and_clusters);
+  void checkWalkerId(const int walker_id);
+
+  /// Number of sites the hot spot trigger keeps visit counts for
+  const int hot_site_counters = 64;
 
   /****************************************************************************
    * Public Facing Functions
@@ -54,16 +68,40 @@ namespace mythical {
     performance_ratio_(1.00),
     seed_set_(false),
     seed_(0),
+    sampling_method_(SamplingMethod::linear),
+    random_streams_(RandomStreams::per_feature),
+    crossing_time_method_(CrossingTimeMethod::native),
+    coarse_grain_trigger_(CoarseGrainTrigger::last_hop),
+    hot_spots_per_attempt_(3),
+    background_coarse_graining_(false),
+    adaptive_exploration_(false),
+    min_exploration_count_(0),
+    max_exploration_count_(0),
+    abandoned_in_a_row_(0),
+    largest_coarse_grained_basin_(0),
+    statistics_(),
     time_resolution_set_(false),
     minimum_coarse_graining_resolution_(2),
     iteration_(0),
     iteration_threshold_(1000),
-    iteration_threshold_min_(1000){
+    iteration_threshold_min_(1000),
+    time_(0.0),
+    samples_taken_(0),
+    drained_walkers_(0),
+    next_cluster_id_(0){
       sites_ = unique_ptr<Site_Container>( new Site_Container );
       clusters_ = unique_ptr<Cluster_Container>( new Cluster_Container );
+      cluster_dwell_times_ = shared_ptr<vector<double>>( new vector<double> );
+      shortest_paths_ = unique_ptr<ShortestPaths>( new ShortestPaths );
+      basin_explorer_ = unique_ptr<BasinExplorer>( new BasinExplorer );
+      hot_sites_ = unique_ptr<HotSiteSketch>( new HotSiteSketch(hot_site_counters) );
+      background_coarse_grainer_ = unique_ptr<BackgroundCoarseGrainer>(
+          new BackgroundCoarseGrainer );
     }
 
+  // The helper thread reads the sites and clusters so it must finish first
   CoarseGrainSystem::~CoarseGrainSystem(){
+    waitForBackgroundCoarseGraining_();
   }
 
   double CoarseGrainSystem::getTimeResolution() { 
@@ -78,47 +116,96 @@ namespace mythical {
     if(time_resolution<=0.0){
       throw invalid_argument("The time resolution must be a positive value.");
     }
+    waitForBackgroundCoarseGraining_();
     time_resolution_set_ = true;
     time_resolution_ = time_resolution;
   }
 
   void CoarseGrainSystem::initializeSystem(unordered_map<int, unordered_map<int, double>>& ratesOfAllSites) {
+    if(!time_resolution_set_){
+      throw runtime_error("You must first set the time resolution of the system "
+          "before you can initialize the system.");
+    }
+    if(rate_network_){
+      throw runtime_error("The system has already been initialized.");
+    }
+    initializeSystem(RateNetwork::create(ratesOfAllSites,sampling_method_));
+  }
 
-    LOG("Initializeing system", 1);
+  void CoarseGrainSystem::initializeSystem(RateTable rate_table) {
+    if(!time_resolution_set_){
+      throw runtime_error("You must first set the time resolution of the system "
+          "before you can initialize the system.");
+    }
+    if(rate_network_){
+      throw runtime_error("The system has already been initialized.");
+    }
+    initializeSystem(RateNetwork::create(move(rate_table),sampling_method_));
+  }
 
+  void CoarseGrainSystem::initializeSystem(const RateGenerator & generate) {
     if(!time_resolution_set_){
       throw runtime_error("You must first set the time resolution of the system "
           "before you can initialize the system.");
     }
+    if(rate_network_){
+      throw runtime_error("The system has already been initialized.");
+    }
+    initializeSystem(RateNetwork::create(generate,sampling_method_));
+  }
 
-    for (auto it = ratesOfAllSites.begin(); it != ratesOfAllSites.end(); ++it) {
-      Site site;
-      site.setId(it->first);
+  void CoarseGrainSystem::initializeSystem(shared_ptr<const RateNetwork> rate_network) {
 
-      site.setRatesToNeighbors(it->second);
-      if (seed_set_) {
-        site.setRandomSeed(seed_);
-        ++seed_;
-      }
-      sites_->addSite(site);
-      topology_features_[it->first] = &(sites_->getSite(it->first));
-    }
+    LOG("Initializeing system", 1);
 
-    // Address sites that will act as drains with no rates off of them
-    unordered_set<int> drain_sites;
-    for (pair<const int,unordered_map<int,double>> & sites_and_rates : ratesOfAllSites){
-      for(const pair<int,double> & site_and_rate : sites_and_rates.second ){
-        if(ratesOfAllSites.count(site_and_rate.first)==0){
-          drain_sites.insert(site_and_rate.first);
-        }
-      }
+    if(!time_resolution_set_){
+      throw runtime_error("You must first set the time resolution of the system "
+          "before you can initialize the system.");
+    }
+    if(rate_network_){
+      throw runtime_error("The system has already been initialized.");
+    }
+    if(!rate_network){
+      throw invalid_argument("Cannot initialize the system without a rate "
+          "network.");
     }
 
-    for( const int & drain_site_id : drain_sites ){
+    // Every site reads its rates from its own row of the shared graph, the
+    // sites are added in the same order as the rows so that the row of a
+    // site is also its dense index
+    rate_network_ = rate_network;
+    rate_graph_ = rate_network->getRateGraph();
+    sampling_method_ = rate_network->getSamplingMethod();
+    const vector<int> & siteIds = rate_network->getSiteIds();
+    if (random_streams_ == RandomStreams::per_walker) {
+      const unsigned long seed = seed_set_ ? seed_ :
+        static_cast<unsigned long>(system_clock::now().time_since_epoch().count());
+      walker_streams_ = unique_ptr<WalkerRandomStreams>(
+          new WalkerRandomStreams(seed));
+    }
+    // The engine of each site is seeded with the seed plus its row, but only
+    // created once a walker hops off of the site
+    if (seed_set_ && !walker_streams_) {
+      feature_seeds_ = unique_ptr<FeatureSeeds>(new FeatureSeeds(seed_));
+      seed_ += siteIds.size();
+    }
+    sites_->reserve(siteIds.size());
+    for (size_t row = 0; row < siteIds.size(); ++row) {
       Site site;
-      site.setId(drain_site_id);
+      site.setId(siteIds[row]);
+      site.setRateGraph(rate_graph_,static_cast<int>(row));
+      site.setWalkerRandomStreams(walker_streams_.get());
+      // Drains are seeded as well, a walker landing on one still draws its
+      // dwell time and next site from the drain
+      if (feature_seeds_) site.setFeatureSeeds(feature_seeds_.get());
       sites_->addSite(site);
-      topology_features_[drain_site_id] = &(sites_->getSite(drain_site_id));
+    }
+
+    // Only once all the sites have been added are their addresses stable
+    sites_->buildIndexLookupTable();
+    topology_features_.resize(sites_->size());
+    for( size_t index = 0; index < sites_->size(); ++index ){
+      topology_features_[index] = &(sites_->getSiteByIndex(static_cast<int>(index)));
     }
   }
 
@@ -146,6 +233,7 @@ namespace mythical {
           "can initialize the walkers");
     }
     for ( size_t index = 0; index<walkers.size(); ++index){
+      checkWalkerId(walkers.at(index).first);
       int siteId;
       try {
         siteId = walkers.at(index).second->getIdOfSiteCurrentlyOccupying();
@@ -156,7 +244,7 @@ namespace mythical {
         throw runtime_error(error_msg);
       }
 
-      if (topology_features_.count(siteId) == 0 ) {
+      if (sites_->exist(siteId) == false ) {
         string error_msg = std::string(__FILE__) + ":" + to_string(__LINE__) +
           " Walker at index " + to_string(index) +
           " is found to occupy site " + to_string(siteId) + " but an associated"
@@ -165,10 +253,12 @@ namespace mythical {
           "within the rates parameter.";
         throw runtime_error(error_msg);
       }
-      topology_features_[siteId]->occupy();
+      TopologyFeature * feature = topology_features_[sites_->getIndex(siteId)];
+      feature->occupy();
+      if (walker_streams_) walker_streams_->reset(walkers.at(index).first);
 
-      auto hopTime = topology_features_[siteId]->getDwellTime(walkers.at(index).first);
-      int newId = topology_features_[siteId]->pickNewSiteId(walkers.at(index).first);
+      auto hopTime = feature->getDwellTime(walkers.at(index).first);
+      int newId = feature->pickNewSiteId(walkers.at(index).first);
       walkers.at(index).second->setDwellTime(hopTime);
       walkers.at(index).second->setPotentialSite(newId);
     }
@@ -180,6 +270,71 @@ namespace mythical {
     iteration_threshold_ = threshold_min;
   }
 
+  void CoarseGrainSystem::setHotSpotsPerAttempt(const int count) {
+    if(count < 1 || count > hot_site_counters){
+      throw invalid_argument("The number of hot spots tried per attempt must be "
+          "between 1 and " + to_string(hot_site_counters) + ".");
+    }
+    hot_spots_per_attempt_ = count;
+  }
+
+  void CoarseGrainSystem::setBackgroundCoarseGraining(const bool background) {
+    if(!background && background_coarse_grainer_->pending()){
+      CoarseGrainPlan plan = background_coarse_grainer_->collect();
+      if(carryOutPlan_(plan)) iteration_threshold_ = iteration_threshold_min_;
+    }
+    background_coarse_graining_ = background;
+  }
+
+  void CoarseGrainSystem::setBasinThreshold(const double threshold) {
+    if(threshold < 0.0){
+      throw invalid_argument("The basin threshold cannot be negative.");
+    }
+    waitForBackgroundCoarseGraining_();
+    basin_explorer_->setThreshold(threshold);
+  }
+
+  double CoarseGrainSystem::getBasinThreshold() const {
+    return basin_explorer_->getThreshold();
+  }
+
+  void CoarseGrainSystem::setMaxExplorationCount(const int count) {
+    if(count < 1){
+      throw invalid_argument("The max exploration count must be at least 1.");
+    }
+    waitForBackgroundCoarseGraining_();
+    adaptive_exploration_ = false;
+    basin_explorer_->setMaxExplorationCount(count);
+  }
+
+  int CoarseGrainSystem::getMaxExplorationCount() const {
+    return basin_explorer_->getMaxExplorationCount();
+  }
+
+  void CoarseGrainSystem::setAdaptiveExplorationCount(
+      const int min_count,
+      const int max_count) {
+    if(min_count < 1 || max_count < min_count){
+      throw invalid_argument("The adaptive exploration count limits must be "
+          "at least 1 and the min count cannot exceed the max count.");
+    }
+    waitForBackgroundCoarseGraining_();
+    adaptive_exploration_ = true;
+    min_exploration_count_ = min_count;
+    max_exploration_count_ = max_count;
+    abandoned_in_a_row_ = 0;
+    const int count = basin_explorer_->getMaxExplorationCount();
+    basin_explorer_->setMaxExplorationCount(min(max(count,min_count),max_count));
+  }
+
+  void CoarseGrainSystem::resetCoarseGrainStatistics() {
+    statistics_ = CoarseGrainStatistics();
+  }
+
+  void CoarseGrainSystem::setCoarseGrainAttemptObserver(AttemptObserver observer) {
+    attempt_observer_ = observer;
+  }
+
   void CoarseGrainSystem::setRandomSeed(const unsigned long seed) {
     if (topology_features_.size() != 0) {
       throw runtime_error(
@@ -190,14 +345,33 @@ namespace mythical {
     seed_set_ = true;
   }
 
+  void CoarseGrainSystem::setSamplingMethod(const SamplingMethod sampling_method) {
+    if (topology_features_.size() != 0) {
+      throw runtime_error(
+          "For the sampling method to have an affect, it must be "
+          "set before initializeSystem is called");
+    }
+    sampling_method_ = sampling_method;
+  }
+
+  void CoarseGrainSystem::setRandomStreams(const RandomStreams streams) {
+    if (topology_features_.size() != 0) {
+      throw runtime_error(
+          "For the random streams to have an affect, they must be "
+          "set before initializeSystem is called");
+    }
+    random_streams_ = streams;
+  }
+
   void CoarseGrainSystem::removeWalkerFromSystem(pair<int,std::shared_ptr<Walker>>& walker) {
     removeWalkerFromSystem(walker.first,walker.second);
   }
 
   void CoarseGrainSystem::removeWalkerFromSystem(int walker_id, std::shared_ptr<Walker>& walker) {
     LOG("Walker is being removed from system", 1);
+    checkWalkerId(walker_id);
     auto siteId = walker->getIdOfSiteCurrentlyOccupying();
-    topology_features_[siteId]->removeWalker(walker_id,siteId);
+    topology_features_[sites_->getIndex(siteId)]->removeWalker(walker_id,siteId);
   }
 
   int CoarseGrainSystem::getClusterIdOfSite(const int siteId) {
@@ -209,30 +383,150 @@ namespace mythical {
   }
 
   void CoarseGrainSystem::hop(int walker_id, std::shared_ptr<Walker> & walker) {
-    const int & siteId = walker->getIdOfSiteCurrentlyOccupying();
-    const int & siteToHopToId = walker->getPotentialSite();
-    TopologyFeature * feature = topology_features_[siteId];
-    TopologyFeature * feature_to_hop_to = topology_features_[siteToHopToId];
+    checkWalkerId(walker_id);
+    int siteId = walker->getIdOfSiteCurrentlyOccupying();
+    int potential_siteId = walker->getPotentialSite();
+    double dwell_time;
+    hop_(walker_id,siteId,potential_siteId,dwell_time);
+    walker->occupySite(siteId);
+    walker->setPotentialSite(potential_siteId);
+    walker->setDwellTime(dwell_time);
+  }
+
+  void CoarseGrainSystem::addWalker(const int walker_id, const int siteId) {
+    if (topology_features_.size() == 0) {
+      throw runtime_error(
+          "You must first initialize the system before you "
+          "can add walkers");
+    }
+    if (sites_->exist(siteId) == false ) {
+      throw invalid_argument("Cannot add walker " + to_string(walker_id) +
+          " to site " + to_string(siteId) + " as the site is not stored in "
+          "the coarse grained system.");
+    }
+    checkWalkerId(walker_id);
+    if (walkers_.exist(walker_id)) {
+      throw invalid_argument("Cannot add walker " + to_string(walker_id) +
+          " walker ids must be unique.");
+    }
+    if (rate_graph_->getRowSize(sites_->getIndex(siteId)) == 0) {
+      throw invalid_argument("Cannot add walker " + to_string(walker_id) +
+          " to site " + to_string(siteId) + " as the site is a drain.");
+    }
+    walkers_.add(walker_id,siteId);
+    TopologyFeature * feature = topology_features_[sites_->getIndex(siteId)];
+    feature->occupy();
+    if (walker_streams_) walker_streams_->reset(walker_id);
+    const double dwell_time = feature->getDwellTime(walker_id);
+    walkers_.setDwellTime(walker_id,dwell_time);
+    walkers_.setPotentialSiteId(walker_id,feature->pickNewSiteId(walker_id));
+    walkers_.setGlobalTime(walker_id,time_+dwell_time);
+    walker_queue_.sortedAdd({walker_id,time_+dwell_time});
+  }
+
+  void CoarseGrainSystem::removeWalker(const int walker_id) {
+    if (!walkers_.exist(walker_id)) {
+      throw invalid_argument("Cannot remove walker " + to_string(walker_id) +
+          " it was not added to the coarse grained system.");
+    }
+    LOG("Walker is being removed from system", 1);
+    walker_queue_.erase(walker_id);
+    const int siteId = walkers_.getSiteId(walker_id);
+    topology_features_[sites_->getIndex(siteId)]->removeWalker(walker_id,siteId);
+    walkers_.remove(walker_id);
+  }
+
+  int CoarseGrainSystem::getSiteIdOfWalker(const int walker_id) const {
+    if (!walkers_.exist(walker_id)) {
+      throw invalid_argument("Cannot get the site of walker " +
+          to_string(walker_id) + " it was not added to the coarse grained "
+          "system.");
+    }
+    return walkers_.getSiteId(walker_id);
+  }
+
+  void CoarseGrainSystem::run(const double until_time, SampleObserver observer) {
+    if(!time_resolution_set_){
+      throw runtime_error("You must first set the time resolution of the system "
+          "before it can be run.");
+    }
+    while(!walker_queue_.empty() && walker_queue_.peek().second < until_time){
+      const double hop_time = walker_queue_.peek().second;
+      // The observer may remove walkers so the queue is checked again after
+      // each interval
+      if(nextSampleTime_() <= hop_time){
+        if(observer) observer(nextSampleTime_(),hops_);
+        hops_.clear();
+        ++samples_taken_;
+        continue;
+      }
+      const int walker_id = walker_queue_.peek().first;
+      const int siteId = walkers_.getSiteId(walker_id);
+      const int new_siteId = hopNextWalker_();
+      hops_.push_back({walker_id,siteId,new_siteId,hop_time});
+    }
+    while(nextSampleTime_() <= until_time){
+      if(observer) observer(nextSampleTime_(),hops_);
+      hops_.clear();
+      ++samples_taken_;
+    }
+    if(until_time > time_) time_ = until_time;
+  }
+
+  void CoarseGrainSystem::step(const int number_of_hops) {
+    for(int hop_count = 0; hop_count < number_of_hops; ++hop_count){
+      if(walker_queue_.empty()) return;
+      hopNextWalker_();
+    }
+  }
+
+  /****************************************************************************
+   * Internal Private Functions
+   ****************************************************************************/
+
+  void CoarseGrainSystem::hop_(
+      const int walker_id,
+      int & siteId,
+      int & potential_siteId,
+      double & dwell_time) {
+
+    const int siteToHopToId = potential_siteId;
+    TopologyFeature * feature = topology_features_[sites_->getIndex(siteId)];
+    TopologyFeature * feature_to_hop_to =
+      topology_features_[sites_->getIndex(siteToHopToId)];
 
     if(!feature_to_hop_to->isOccupied(siteToHopToId)){
       feature->vacate(siteId);
       feature_to_hop_to->occupy(siteToHopToId);
 
-      walker->occupySite(siteToHopToId);
-      walker->setDwellTime(feature_to_hop_to->getDwellTime(walker_id));
-      walker->setPotentialSite(feature_to_hop_to->pickNewSiteId(walker_id));
+      siteId = siteToHopToId;
+      dwell_time = feature_to_hop_to->getDwellTime(walker_id);
+      potential_siteId = feature_to_hop_to->pickNewSiteId(walker_id);
     }else{
       feature->vacate(siteId);
       feature->occupy(siteId);
 
-      walker->setDwellTime(feature->getDwellTime(walker_id));
-      walker->setPotentialSite(feature->pickNewSiteId(walker_id));
+      dwell_time = feature->getDwellTime(walker_id);
+      potential_siteId = feature->pickNewSiteId(walker_id);
+    }
+
+    if(coarse_grain_trigger_==CoarseGrainTrigger::hot_spots){
+      const int index = sites_->getIndex(siteId);
+      if(!sites_->getSiteByIndex(index).partOfCluster()) hot_sites_->visit(siteId);
     }
 
     ++iteration_;
     if(iteration_ > iteration_threshold_){
       if(iteration_threshold_min_!=constants::inf_iterations){
-        if(coarseGrain_(siteToHopToId)){
+        bool coarse_grained;
+        if(background_coarse_graining_){
+          coarse_grained = coarseGrainInBackground_(siteToHopToId);
+        }else if(coarse_grain_trigger_==CoarseGrainTrigger::hot_spots){
+          coarse_grained = coarseGrainHotSpots_();
+        }else{
+          coarse_grained = coarseGrain_(siteToHopToId);
+        }
+        if(coarse_grained){
           iteration_threshold_ = iteration_threshold_min_;
         }else{
           iteration_threshold_*=2;
@@ -242,16 +536,69 @@ namespace mythical {
     }
   }
 
-  /****************************************************************************
-   * Internal Private Functions
-   ****************************************************************************/
+  // The walker that hops next stays at the front of the queue, its time is
+  // moved forward in place rather than popping and adding it back. Walkers
+  // landing on a drain have nowhere to hop to so they are taken out of the
+  // system.
+  int CoarseGrainSystem::hopNextWalker_() {
+    const pair<int,double> & next = walker_queue_.peek();
+    const int walker_id = next.first;
+    time_ = next.second;
+    int siteId = walkers_.getSiteId(walker_id);
+    int potential_siteId = walkers_.getPotentialSiteId(walker_id);
+    double dwell_time;
+    hop_(walker_id,siteId,potential_siteId,dwell_time);
+    const int index = sites_->getIndex(siteId);
+    if(rate_graph_->getRowSize(index) == 0){
+      walker_queue_.erase(walker_id);
+      topology_features_[index]->removeWalker(walker_id,siteId);
+      walkers_.remove(walker_id);
+      ++drained_walkers_;
+      return siteId;
+    }
+    walkers_.setSiteId(walker_id,siteId);
+    walkers_.setPotentialSiteId(walker_id,potential_siteId);
+    walkers_.setDwellTime(walker_id,dwell_time);
+    walkers_.setGlobalTime(walker_id,time_+dwell_time);
+    walker_queue_.update({walker_id,time_+dwell_time});
+    return siteId;
+  }
+
+  double CoarseGrainSystem::nextSampleTime_() const {
+    return static_cast<double>(samples_taken_+1)*time_resolution_;
+  }
 
   bool CoarseGrainSystem::coarseGrain_(int siteId){
-    BasinExplorer basin_explorer;
-    auto basin_site_ids = basin_explorer.findBasin(*sites_,*clusters_,siteId);
+    auto start = steady_clock::now();
+    CoarseGrainPlan plan;
+    CoarseGrainAttempt attempt = findBasinToCoarseGrain_(siteId,plan);
+    if(plan.action==CoarseGrainPlan::Action::create_cluster){
+      createCluster_(plan.site_ids,plan.internal_time_limit);
+    }else if(plan.action==CoarseGrainPlan::Action::merge_with_clusters){
+      auto sites_and_clusters = getClustersOfSites(plan.site_ids);
+      mergeSitesAndClusters_(sites_and_clusters,getFavoredClusterId(sites_and_clusters));
+    }
+    attempt.seconds = duration<double>(steady_clock::now()-start).count();
+    recordAttempt_(attempt);
+    return attempt.coarse_grained;
+  }
 
-    double internal_time_limit = getInternalTimeLimit_(basin_site_ids);
+  CoarseGrainAttempt CoarseGrainSystem::findBasinToCoarseGrain_(
+      int siteId,
+      CoarseGrainPlan & plan){
 
+    CoarseGrainAttempt attempt;
+    attempt.site_id = siteId;
+    attempt.max_exploration_count = basin_explorer_->getMaxExplorationCount();
+    attempt.seconds = 0.0;
+
+    const vector<int> & basin_site_ids =
+      basin_explorer_->findBasin(*sites_,*clusters_,siteId);
+    attempt.sites_explored = basin_explorer_->getNumberOfExploredSites();
+    attempt.limit_reached = basin_explorer_->limitReached();
+
+    plan.action = CoarseGrainPlan::Action::none;
+    double internal_time_limit = getInternalTimeLimit_(basin_site_ids);
     if( sitesSatisfyEquilibriumCondition_(basin_site_ids, internal_time_limit) ){
       auto sites_and_clusters = getClustersOfSites(basin_site_ids);
       auto number_clusters = countUniqueClusters(sites_and_clusters);
@@ -259,16 +606,134 @@ namespace mythical {
       if(number_clusters==1 &&
           sites_and_clusters.begin()->second==constants::unassignedId)
       {
-        createCluster_(basin_site_ids,internal_time_limit);
-        return true;
+        plan.action = CoarseGrainPlan::Action::create_cluster;
       }else if(number_clusters!=1){
         // Joint clusters and sites to an existing cluster
-        int favored_clusterId = getFavoredClusterId(sites_and_clusters);
-        mergeSitesAndClusters_(sites_and_clusters,favored_clusterId);
-        return true;
+        plan.action = CoarseGrainPlan::Action::merge_with_clusters;
+      }
+    }
+    if(plan.action!=CoarseGrainPlan::Action::none){
+      plan.site_ids = basin_site_ids;
+      plan.internal_time_limit = internal_time_limit;
+    }
+    attempt.coarse_grained = plan.action!=CoarseGrainPlan::Action::none;
+    return attempt;
+  }
+
+  // The sketch is cleared so the next attempt only sees the sites that have
+  // been hot since this one
+  bool CoarseGrainSystem::coarseGrainHotSpots_(){
+    bool coarse_grained = false;
+    for(const int siteId : hot_sites_->getHottestSites(hot_spots_per_attempt_)){
+      if(sites_->partOfCluster(siteId)) continue;
+      if(coarseGrain_(siteId)){
+        coarse_grained = true;
+        break;
       }
     }
-    return false;
+    hot_sites_->clear();
+    return coarse_grained;
+  }
+
+  // Whatever the helper found during the previous period is put in place
+  // before it is handed the sites picked for the next one
+  bool CoarseGrainSystem::coarseGrainInBackground_(int siteId){
+    bool coarse_grained = false;
+    if(background_coarse_grainer_->pending()){
+      CoarseGrainPlan plan = background_coarse_grainer_->collect();
+      coarse_grained = carryOutPlan_(plan);
+    }
+
+    vector<int> siteIds;
+    if(coarse_grain_trigger_==CoarseGrainTrigger::hot_spots){
+      siteIds = hot_sites_->getHottestSites(hot_spots_per_attempt_);
+      hot_sites_->clear();
+    }else{
+      siteIds.push_back(siteId);
+    }
+    siteIds.erase(remove_if(siteIds.begin(),siteIds.end(),
+          [this](const int & id){ return sites_->partOfCluster(id); }),
+        siteIds.end());
+    if(!siteIds.empty()){
+      background_coarse_grainer_->start(
+          [this,siteIds](){ return planCoarseGrain_(siteIds); });
+    }
+    return coarse_grained;
+  }
+
+  CoarseGrainPlan CoarseGrainSystem::planCoarseGrain_(const vector<int> & siteIds){
+    CoarseGrainPlan plan;
+    for(const int siteId : siteIds){
+      auto start = steady_clock::now();
+      CoarseGrainAttempt attempt = findBasinToCoarseGrain_(siteId,plan);
+      if(plan.action==CoarseGrainPlan::Action::create_cluster){
+        plan.cluster = buildCluster_(plan.site_ids,plan.internal_time_limit);
+      }
+      attempt.seconds = duration<double>(steady_clock::now()-start).count();
+      plan.attempts.push_back(attempt);
+      if(attempt.coarse_grained) break;
+    }
+    return plan;
+  }
+
+  // Runs on the thread that owns the system, the time spent here is added to
+  // the attempt that found the basin
+  bool CoarseGrainSystem::carryOutPlan_(CoarseGrainPlan & plan){
+    auto start = steady_clock::now();
+    if(plan.action==CoarseGrainPlan::Action::create_cluster){
+      installCluster_(*plan.cluster);
+    }else if(plan.action==CoarseGrainPlan::Action::merge_with_clusters){
+      auto sites_and_clusters = getClustersOfSites(plan.site_ids);
+      mergeSitesAndClusters_(sites_and_clusters,getFavoredClusterId(sites_and_clusters));
+    }
+    if(!plan.attempts.empty()){
+      plan.attempts.back().seconds +=
+        duration<double>(steady_clock::now()-start).count();
+    }
+    for(const CoarseGrainAttempt & attempt : plan.attempts) recordAttempt_(attempt);
+    return plan.action!=CoarseGrainPlan::Action::none;
+  }
+
+  void CoarseGrainSystem::waitForBackgroundCoarseGraining_() const {
+    background_coarse_grainer_->wait();
+  }
+
+  void CoarseGrainSystem::recordAttempt_(const CoarseGrainAttempt & attempt){
+    ++statistics_.attempts;
+    if(attempt.coarse_grained){
+      ++statistics_.coarse_grained;
+      statistics_.seconds_coarse_grained += attempt.seconds;
+    }else if(attempt.limit_reached){
+      ++statistics_.abandoned;
+      statistics_.seconds_abandoned += attempt.seconds;
+    }else{
+      ++statistics_.rejected;
+      statistics_.seconds_rejected += attempt.seconds;
+    }
+    if(adaptive_exploration_) adaptExplorationCount_(attempt);
+    if(attempt_observer_) attempt_observer_(attempt);
+  }
+
+  void CoarseGrainSystem::adaptExplorationCount_(const CoarseGrainAttempt & attempt){
+    if(!attempt.limit_reached){
+      abandoned_in_a_row_ = 0;
+      if(attempt.coarse_grained && attempt.sites_explored > largest_coarse_grained_basin_){
+        largest_coarse_grained_basin_ = attempt.sites_explored;
+      }
+      return;
+    }
+    ++abandoned_in_a_row_;
+    if(abandoned_in_a_row_ < 3) return;
+    abandoned_in_a_row_ = 0;
+
+    int count = basin_explorer_->getMaxExplorationCount();
+    if(count < max_exploration_count_){
+      count = min(2*count,max_exploration_count_);
+    }else{
+      count = max(min_exploration_count_,
+          min(2*largest_coarse_grained_basin_,max_exploration_count_));
+    }
+    basin_explorer_->setMaxExplorationCount(count);
   }
 
   size_t countUniqueClusters(const unordered_map<int,int> & sites_and_clusters){
@@ -292,6 +757,14 @@ namespace mythical {
     return clusterId;
   }
 
+  void checkWalkerId(const int walker_id){
+    if(walker_id < 0 || walker_id > constants::max_walker_id){
+      throw invalid_argument("Walker id " + to_string(walker_id) + " is not "
+          "valid, walker ids must lie between 0 and " +
+          to_string(constants::max_walker_id) + ".");
+    }
+  }
+
   // The first int is the site id the second int is the cluster id 
   unordered_map<int,int> CoarseGrainSystem::getClustersOfSites(const vector<int> & siteIds){
     unordered_map<int,int> sites_and_clusters;
@@ -307,18 +780,32 @@ namespace mythical {
 
   int CoarseGrainSystem::createCluster_(vector<int> siteIds, double internal_time_limit) {
     LOG("Creating cluster from vector of sites", 1);
+    unique_ptr<Cluster> cluster = buildCluster_(siteIds,internal_time_limit);
+    return installCluster_(*cluster);
+  }
 
-    Cluster cluster;
-    cluster.setConvergenceMethod(Cluster::Method::converge_by_tolerance);
-    cluster.setConvergenceTolerance(0.001);
-    vector<Site> sites;
-    for (auto siteId : siteIds){
-      sites.push_back(sites_->getSite(siteId));
+  // Only reads the rates of the sites so that it can run on the helper thread,
+  // the sites of the cluster start out unoccupied
+  unique_ptr<Cluster> CoarseGrainSystem::buildCluster_(
+      const vector<int> & siteIds,
+      double internal_time_limit) {
+
+    unique_ptr<Cluster> cluster( new Cluster );
+    // Ids are counted per system so replicas on other threads cannot change
+    // them, the smallest id is favored when clusters are merged
+    cluster->setId(next_cluster_id_++);
+    cluster->setConvergenceMethod(Cluster::Method::converge_automatically);
+    cluster->setConvergenceTolerance(0.001);
+    cluster->setSamplingMethod(sampling_method_);
+    vector<Site> sites(siteIds.size());
+    for (size_t index = 0; index < siteIds.size(); ++index){
+      sites[index].setId(siteIds[index]);
+      sites[index].setRateGraph(rate_graph_,sites_->getIndex(siteIds[index]));
     }
-    cluster.addSites(sites);
-    cluster.updateProbabilitiesAndTimeConstant();
+    cluster->addSites(sites);
+    cluster->updateProbabilitiesAndTimeConstant();
 
-    double cluster_time_const = cluster.getTimeConstant();
+    double cluster_time_const = cluster->getTimeConstant();
     // Cut the resolution in half from what it would otherwise be otherwise not worth doing
     double res = cluster_time_const/(2*internal_time_limit);
     double allowed_resolution = cluster_time_const/time_resolution_;
@@ -329,8 +816,18 @@ namespace mythical {
 
     if(chosen_resolution<2.0) chosen_resolution=2.0;
    
-    cluster.setResolution(chosen_resolution);
-    if (seed_set_) {
+    cluster->setResolution(chosen_resolution);
+    return cluster;
+  }
+
+  int CoarseGrainSystem::installCluster_(Cluster & cluster) {
+    const vector<int> siteIds = cluster.getSiteIdsInCluster();
+    for(const int & siteId : siteIds){
+      if(sites_->isOccupied(siteId)) cluster.setSiteToOccupiedStatus(siteId);
+    }
+    cluster.setWalkerDwellTimeTable(cluster_dwell_times_);
+    cluster.setWalkerRandomStreams(walker_streams_.get());
+    if (seed_set_ && !walker_streams_) {
       cluster.setRandomSeed(seed_);
       ++seed_;
     }
@@ -338,11 +835,8 @@ namespace mythical {
 
     for(auto siteId : siteIds){
       sites_->setClusterId(siteId,cluster.getId());  
-      topology_features_[siteId] = &(clusters_->getCluster(cluster.getId()));
+      topology_features_[sites_->getIndex(siteId)] = &(clusters_->getCluster(cluster.getId()));
     }
-
-    auto sitesFoundInCluster = cluster.getSiteIdsInCluster();
-
     return cluster.getId();
   }
 
@@ -350,7 +844,8 @@ namespace mythical {
 
     LOG("Merging sites to cluster", 1);
     vector<Site> isolated_sites;
-    unordered_set<int> cluster_ids;
+    // Ordered so the clusters are always migrated in the same order
+    set<int> cluster_ids;
 
     for (auto site_and_cluster : sites_and_clusters) { 
       if(site_and_cluster.second != favoredClusterId){ 
@@ -359,12 +854,16 @@ namespace mythical {
         } else {
           cluster_ids.insert(site_and_cluster.second);
         }
-        topology_features_[site_and_cluster.first] = &(clusters_->getCluster(favoredClusterId));
+        topology_features_[sites_->getIndex(site_and_cluster.first)] =
+          &(clusters_->getCluster(favoredClusterId));
         sites_->setClusterId(site_and_cluster.first,favoredClusterId);
       }
     }
     clusters_->getCluster(favoredClusterId).addSites(isolated_sites);
-    clusters_->getCluster(favoredClusterId).updateProbabilitiesAndTimeConstant();
+    // Migrating the sites of a cluster also updates the favored cluster
+    if(cluster_ids.empty() && !isolated_sites.empty()){
+      clusters_->getCluster(favoredClusterId).updateProbabilitiesAndTimeConstant();
+    }
     for(auto clusterId : cluster_ids ){
       clusters_->getCluster(favoredClusterId).migrateSitesFrom(clusters_->getCluster(clusterId));
       clusters_->erase(clusterId);
@@ -381,12 +880,12 @@ namespace mythical {
 
     double max_rate_off = 0; 
     for(const int & site_id : siteIds){
-      Site & site = sites_->getSite(site_id);
-      const unordered_map<int,double *> neigh_and_rates = site.getNeighborsAndRatesConst();
-      for( const pair<int,double *> & neigh_and_rate : neigh_and_rates){
-        if(internal_sites.count(neigh_and_rate.first)==0){
-          if(*(neigh_and_rate.second) > max_rate_off){
-            max_rate_off = *(neigh_and_rate.second);
+      const int row = sites_->getIndex(site_id);
+      const int end = rate_graph_->getRowEnd(row);
+      for( int entry = rate_graph_->getRowBegin(row); entry < end; ++entry){
+        if(internal_sites.count(rate_graph_->getNeighborId(entry))==0){
+          if(rate_graph_->getRate(entry) > max_rate_off){
+            max_rate_off = rate_graph_->getRate(entry);
           }
         }
       }
@@ -397,6 +896,17 @@ namespace mythical {
 double CoarseGrainSystem::getInternalTimeLimit_(vector<int> siteIds ){
   LOG("Getting the internal time limit of a cluster", 1);
 
+  if(crossing_time_method_ == CrossingTimeMethod::graph_library){
+    return getInternalTimeLimitFromGraphLibrary_(siteIds);
+  }
+
+  // Reuse the memory of siteIds for the rows of the sites
+  for(int & siteId : siteIds) siteId = sites_->getIndex(siteId);
+  return shortest_paths_->maxShortestTime(*rate_graph_,siteIds);
+}
+
+double CoarseGrainSystem::getInternalTimeLimitFromGraphLibrary_(vector<int> siteIds ){
+
   auto nodes = convertSitesToEmptySharedNodes(siteIds);
 
   unordered_map<int, weak_ptr<GraphNode<string>>> nodes_weak;
@@ -0,0 +1,85 @@
+
+#include <cassert>
+
+#include "discrete_sampler.hpp"
+
+using namespace std;
+
+namespace mythical {
+
+  void buildAliasTable(const double * weights, const int count,
+      double * alias_probabilities, int * aliases){
+
+    double total = 0.0;
+    for(int index = 0; index < count; ++index) total += weights[index];
+    assert(total>0.0 && "Cannot build an alias table without any weight");
+
+    // Scale so that the average column has a probability of 1
+    vector<double> scaled(count);
+    vector<int> small;
+    vector<int> large;
+    small.reserve(count);
+    large.reserve(count);
+    const double scale = static_cast<double>(count)/total;
+    for(int index = 0; index < count; ++index){
+      scaled[index] = weights[index]*scale;
+      if(scaled[index] < 1.0){
+        small.push_back(index);
+      }else{
+        large.push_back(index);
+      }
+    }
+
+    while(!small.empty() && !large.empty()){
+      const int less = small.back();
+      small.pop_back();
+      const int more = large.back();
+      alias_probabilities[less] = scaled[less];
+      aliases[less] = more;
+      scaled[more] = (scaled[more]+scaled[less])-1.0;
+      if(scaled[more] < 1.0){
+        large.pop_back();
+        small.push_back(more);
+      }
+    }
+
+    // Whatever is left over is only off from 1 because of round off
+    for(const int & index : large){
+      alias_probabilities[index] = 1.0;
+      aliases[index] = index;
+    }
+    for(const int & index : small){
+      alias_probabilities[index] = 1.0;
+      aliases[index] = index;
+    }
+  }
+
+  void DiscreteSampler::build(const vector<double> & probabilities,
+      const SamplingMethod method){
+
+    clear();
+    const int count = static_cast<int>(probabilities.size());
+    method_ = resolveSamplingMethod(method,count);
+
+    cumulative_.reserve(count);
+    double total = 0.0;
+    for(const double & probability : probabilities){
+      total += probability;
+      cumulative_.push_back(total);
+    }
+    if(count>0) cumulative_.back() = 1.0;
+
+    if(method_==SamplingMethod::alias && count>0){
+      alias_probabilities_.resize(count);
+      aliases_.resize(count);
+      buildAliasTable(probabilities.data(),count,alias_probabilities_.data(),
+          aliases_.data());
+    }
+  }
+
+  void DiscreteSampler::clear(){
+    cumulative_.clear();
+    alias_probabilities_.clear();
+    aliases_.clear();
+  }
+}
@@ -0,0 +1,125 @@
+#ifndef MYTHICAL_DISCRETE_SAMPLER_HPP
+#define MYTHICAL_DISCRETE_SAMPLER_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include "mythical/sampling_method.hpp"
+
+namespace mythical {
+
+/**
+ * \brief Determine the method actually used to sample a number of outcomes
+ *
+ * Only differs from the method passed in if it is automatic.
+ **/
+inline SamplingMethod resolveSamplingMethod(const SamplingMethod method,
+    const int count){
+  if(method!=SamplingMethod::automatic) return method;
+  if(count <= sampling_limits::linear) return SamplingMethod::linear;
+  if(count <= sampling_limits::binary_search) return SamplingMethod::binary_search;
+  return SamplingMethod::alias;
+}
+
+/**
+ * \brief Index of the first cumulative probability larger than the number
+ *
+ * Falls back on the last outcome if the cumulative probabilities do not quite
+ * reach the number because of round off.
+ **/
+inline int sampleCumulativeLinear(const double * cumulative, const int count,
+    const double number){
+  for(int index = 0; index < count; ++index){
+    if(number < cumulative[index]) return index;
+  }
+  return count-1;
+}
+
+/// Same as sampleCumulativeLinear but bisects the cumulative probabilities
+inline int sampleCumulativeBinary(const double * cumulative, const int count,
+    const double number){
+  const double * it = std::upper_bound(cumulative,cumulative+count,number);
+  const int index = static_cast<int>(it-cumulative);
+  return index < count ? index : count-1;
+}
+
+/**
+ * \brief Pick an outcome from an alias table with a single random number
+ *
+ * The integer part of number*count selects the column, the fractional part
+ * decides between the column and its alias.
+ **/
+inline int sampleAliasTable(const double * alias_probabilities,
+    const int * aliases, const int count, const double number){
+  const double scaled = number*static_cast<double>(count);
+  int column = static_cast<int>(scaled);
+  if(column >= count) column = count-1;
+  const double fraction = scaled-static_cast<double>(column);
+  return fraction < alias_probabilities[column] ? column : aliases[column];
+}
+
+/**
+ * \brief Build a Walker/Vose alias table
+ *
+ * \param[in] weights of each outcome, they do not need to be normalized
+ * \param[in] count number of outcomes
+ * \param[out] alias_probabilities probability of keeping each column
+ * \param[out] aliases outcome picked when a column is not kept
+ **/
+void buildAliasTable(const double * weights, const int count,
+    double * alias_probabilities, int * aliases);
+
+/**
+ * \brief Samples the index of an outcome from a discrete distribution
+ *
+ * Stores whatever tables the chosen sampling method needs, the outcomes are
+ * referred to by the order their probabilities were provided in.
+ **/
+class DiscreteSampler {
+  public:
+    DiscreteSampler() : method_(SamplingMethod::linear) {};
+
+    /**
+     * \brief Set the probabilities of each outcome
+     *
+     * \param[in] probabilities of the outcomes, they should sum to one any
+     * round off is absorbed by the last outcome
+     * \param[in] method used to pick an outcome
+     **/
+    void build(const std::vector<double> & probabilities,
+        const SamplingMethod method);
+
+    /**
+     * \brief Pick an outcome
+     *
+     * \param[in] number uniform random number between 0 and 1
+     *
+     * \return index of the outcome, -1 if there are no outcomes
+     **/
+    int sample(const double number) const {
+      const int count = static_cast<int>(cumulative_.size());
+      if(count==0) return -1;
+      if(method_==SamplingMethod::alias){
+        return sampleAliasTable(alias_probabilities_.data(),aliases_.data(),
+            count,number);
+      }else if(method_==SamplingMethod::binary_search){
+        return sampleCumulativeBinary(cumulative_.data(),count,number);
+      }
+      return sampleCumulativeLinear(cumulative_.data(),count,number);
+    }
+
+    /// The method used after resolving automatic
+    SamplingMethod getMethod() const { return method_; }
+    size_t size() const { return cumulative_.size(); }
+    void clear();
+
+  private:
+    SamplingMethod method_;
+    std::vector<double> cumulative_;
+    std::vector<double> alias_probabilities_;
+    std::vector<int> aliases_;
+};
+
+}
+
+#endif // MYTHICAL_DISCRETE_SAMPLER_HPP
@@ -0,0 +1,466 @@
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "mythical/charge_transport/cuboid_lattice.hpp"
+#include "mythical/constants.hpp"
+#include "mythical/domain_decomposed_system.hpp"
+#include "mythical/rate_network.hpp"
+#include "rate_graph.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+namespace mythical {
+
+  namespace {
+
+    /// Holds the threads of the domains until all of them have arrived
+    class Barrier {
+      public:
+        explicit Barrier(const int count) :
+          count_(count), waiting_(0), generation_(0) {};
+
+        void wait() {
+          unique_lock<mutex> lock(mutex_);
+          const long generation = generation_;
+          if(++waiting_==count_){
+            waiting_ = 0;
+            ++generation_;
+            released_.notify_all();
+          }else{
+            released_.wait(lock,[&](){ return generation != generation_; });
+          }
+        }
+
+      private:
+        mutex mutex_;
+        condition_variable released_;
+        const int count_;
+        int waiting_;
+        long generation_;
+    };
+
+    bool hopsInOrder(const HopEvent & hop1, const HopEvent & hop2) {
+      if(hop1.time != hop2.time) return hop1.time < hop2.time;
+      return hop1.walker_id < hop2.walker_id;
+    }
+
+  }
+
+  DomainDecomposedSystem::DomainDecomposedSystem() :
+    seed_set_(false),
+    seed_(0),
+    time_resolution_(0.0),
+    windows_per_sample_(10),
+    time_(0.0),
+    windows_run_(0),
+    number_of_walkers_(0) {}
+
+  DomainDecomposedSystem::~DomainDecomposedSystem() {}
+
+  DomainDecomposedSystem::DomainMap DomainDecomposedSystem::slabsAlongX(
+      const charge_transport::Cuboid & lattice,
+      const int number_of_domains) {
+
+    const int length = lattice.getLength();
+    if(number_of_domains < 1 || number_of_domains > length){
+      throw invalid_argument("Cannot slice a lattice of length " +
+          to_string(length) + " into " + to_string(number_of_domains) +
+          " domains.");
+    }
+    return [lattice, length, number_of_domains](const int siteId){
+      const int x = lattice.getX(siteId);
+      const int domain = x * number_of_domains / length;
+      // First x of this domain and of the next one
+      const int begin = (domain * length + number_of_domains - 1) / number_of_domains;
+      const int end = ((domain + 1) * length + number_of_domains - 1) / number_of_domains;
+      const int sublattice = 2 * (x - begin) < end - begin ? 0 : 1;
+      return pair<int,int>(domain,sublattice);
+    };
+  }
+
+  void DomainDecomposedSystem::setRandomSeed(const unsigned long seed) {
+    if (!domains_.empty()) {
+      throw runtime_error(
+          "For the random seed to have an affect, it must be "
+          "set before initializeSystem is called");
+    }
+    seed_ = seed;
+    seed_set_ = true;
+  }
+
+  void DomainDecomposedSystem::setTimeResolution(const double time_resolution) {
+    if (windows_run_ != 0) {
+      throw runtime_error("The time resolution cannot be changed once the "
+          "system has been run.");
+    }
+    if (!(time_resolution > 0.0)) {
+      throw invalid_argument("The time resolution must be greater than 0.");
+    }
+    time_resolution_ = time_resolution;
+  }
+
+  void DomainDecomposedSystem::setWindowsPerSample(const int windows) {
+    if (windows_run_ != 0) {
+      throw runtime_error("The windows per sample cannot be changed once the "
+          "system has been run.");
+    }
+    if (windows < 1) {
+      throw invalid_argument("Each sample must be split into at least one "
+          "window.");
+    }
+    windows_per_sample_ = windows;
+  }
+
+  void DomainDecomposedSystem::initializeSystem(
+      shared_ptr<const RateNetwork> rate_network,
+      DomainMap domain_map) {
+
+    if (!domains_.empty()) {
+      throw runtime_error("The system has already been initialized.");
+    }
+    if (!rate_network) {
+      throw invalid_argument("Cannot initialize the system without a rate "
+          "network.");
+    }
+    if (!domain_map) {
+      throw invalid_argument("Cannot initialize the system without a map of "
+          "the domains.");
+    }
+
+    const vector<int> & siteIds = rate_network->getSiteIds();
+    vector<int> domain_of_row(siteIds.size());
+    vector<int> sublattice_of_row(siteIds.size());
+    int number_of_domains = 0;
+    for(size_t row = 0; row < siteIds.size(); ++row){
+      const pair<int,int> domain_and_sublattice = domain_map(siteIds[row]);
+      if(domain_and_sublattice.first < 0 ||
+          (domain_and_sublattice.second != 0 && domain_and_sublattice.second != 1)){
+        throw invalid_argument("Site " + to_string(siteIds[row]) + " was "
+            "placed in domain " + to_string(domain_and_sublattice.first) +
+            " sublattice " + to_string(domain_and_sublattice.second) + ", "
+            "domains must be positive and sublattices 0 or 1.");
+      }
+      domain_of_row[row] = domain_and_sublattice.first;
+      sublattice_of_row[row] = domain_and_sublattice.second;
+      number_of_domains = max(number_of_domains,domain_and_sublattice.first+1);
+    }
+
+    rate_network_ = rate_network;
+    rate_graph_ = rate_network->getRateGraph();
+    domain_of_row_ = move(domain_of_row);
+    sublattice_of_row_ = move(sublattice_of_row);
+    try {
+      checkDomains_();
+    } catch (...) {
+      rate_network_.reset();
+      rate_graph_.reset();
+      throw;
+    }
+
+    row_of_site_.clear();
+    row_of_site_.reserve(siteIds.size());
+    for(size_t row = 0; row < siteIds.size(); ++row){
+      row_of_site_[siteIds[row]] = static_cast<int>(row);
+    }
+    occupied_.assign(siteIds.size(),0);
+
+    const unsigned long seed = seed_set_ ? seed_ :
+      static_cast<unsigned long>(system_clock::now().time_since_epoch().count());
+    domains_.resize(number_of_domains);
+    for(int domain = 0; domain < number_of_domains; ++domain){
+      domains_[domain].random_engine.seed(seed + static_cast<unsigned long>(domain));
+      domains_[domain].drained_walkers = 0;
+    }
+  }
+
+  pair<int,int> DomainDecomposedSystem::getDomainOfSite(const int siteId) const {
+    auto row = row_of_site_.find(siteId);
+    if(row == row_of_site_.end()){
+      throw invalid_argument("Site " + to_string(siteId) + " is not stored in "
+          "the system.");
+    }
+    return pair<int,int>(domain_of_row_[row->second],sublattice_of_row_[row->second]);
+  }
+
+  void DomainDecomposedSystem::addWalker(const int walker_id, const int siteId) {
+    if (domains_.empty()) {
+      throw runtime_error(
+          "You must first initialize the system before you "
+          "can add walkers");
+    }
+    auto row = row_of_site_.find(siteId);
+    if (row == row_of_site_.end()) {
+      throw invalid_argument("Cannot add walker " + to_string(walker_id) +
+          " to site " + to_string(siteId) + " as the site is not stored in "
+          "the system.");
+    }
+    if (walker_id < 0 || walker_id > constants::max_walker_id ||
+        walkerExists(walker_id)) {
+      throw invalid_argument("Cannot add walker " + to_string(walker_id) +
+          " walker ids must be non-negative, no larger than " +
+          to_string(constants::max_walker_id) + " and unique.");
+    }
+    if (rate_graph_->getRowSize(row->second) == 0 || occupied_[row->second]) {
+      throw invalid_argument("Cannot add walker " + to_string(walker_id) +
+          " to site " + to_string(siteId) + " as the site is a drain or is "
+          "already occupied.");
+    }
+    if (static_cast<size_t>(walker_id) >= walker_rows_.size()) {
+      walker_rows_.resize(walker_id+1,constants::unassignedId);
+      walker_target_rows_.resize(walker_id+1,constants::unassignedId);
+      walker_times_.resize(walker_id+1,0.0);
+    }
+    walker_rows_[walker_id] = row->second;
+    occupied_[row->second] = 1;
+    drawNextHop_(domains_[domain_of_row_[row->second]],walker_id,time_);
+    queueWalker_(walker_id);
+    ++number_of_walkers_;
+  }
+
+  void DomainDecomposedSystem::removeWalker(const int walker_id) {
+    if (!walkerExists(walker_id)) {
+      throw invalid_argument("Cannot remove walker " + to_string(walker_id) +
+          " it was not added to the system.");
+    }
+    const int row = walker_rows_[walker_id];
+    domains_[domain_of_row_[row]].queues[sublattice_of_row_[row]].erase(walker_id);
+    occupied_[row] = 0;
+    walker_rows_[walker_id] = constants::unassignedId;
+    --number_of_walkers_;
+  }
+
+  bool DomainDecomposedSystem::walkerExists(const int walker_id) const noexcept {
+    return walker_id >= 0 &&
+      static_cast<size_t>(walker_id) < walker_rows_.size() &&
+      walker_rows_[walker_id] != constants::unassignedId;
+  }
+
+  int DomainDecomposedSystem::getSiteIdOfWalker(const int walker_id) const {
+    if (!walkerExists(walker_id)) {
+      throw invalid_argument("Walker " + to_string(walker_id) + " is not in "
+          "the system.");
+    }
+    return rate_network_->getSiteIds()[walker_rows_[walker_id]];
+  }
+
+  void DomainDecomposedSystem::run(const double until_time, SampleObserver observer) {
+    if (time_resolution_ == 0.0) {
+      throw runtime_error("You must first set the time resolution of the system "
+          "before it can be run.");
+    }
+    if (domains_.empty()) {
+      throw runtime_error("You must first initialize the system before it can "
+          "be run.");
+    }
+    const double window = time_resolution_ / windows_per_sample_;
+    // Allow for rounding when the time is a multiple of the window
+    const long last_window = static_cast<long>(floor(until_time / window * (1.0 + 1E-12)));
+    if (last_window <= windows_run_) return;
+
+    const int number_of_domains = getNumberOfDomains();
+    const long first_window = windows_run_;
+    Barrier barrier(number_of_domains);
+    vector<exception_ptr> errors(number_of_domains);
+    // One flag per parity of the half window, so a domain failing in the
+    // next half cannot change what the others see after the last barrier
+    atomic<bool> failed[2];
+    failed[0] = false;
+    failed[1] = false;
+
+    auto collect_hops = [&](const long window_index){
+      const int parity = static_cast<int>(window_index % 2);
+      for(Domain & domain : domains_){
+        sample_hops_.insert(sample_hops_.end(),domain.hops[parity].begin(),
+            domain.hops[parity].end());
+      }
+      if((window_index + 1) % windows_per_sample_ == 0){
+        sort(sample_hops_.begin(),sample_hops_.end(),hopsInOrder);
+        if(observer) observer((window_index + 1) * window,sample_hops_);
+        sample_hops_.clear();
+      }
+    };
+
+    auto run_domain = [&](const int domain_index){
+      Domain & domain = domains_[domain_index];
+      for(long window_index = first_window; window_index < last_window; ++window_index){
+        const double window_end = (window_index + 1) * window;
+        vector<HopEvent> & hops = domain.hops[window_index % 2];
+        for(int sublattice = 0; sublattice < 2; ++sublattice){
+          if(!failed[sublattice]){
+            try{
+              // The other domains are done with the hops of the last window
+              // once they have passed the barrier ending it
+              if(domain_index == 0 && sublattice == 0 && window_index != first_window){
+                collect_hops(window_index - 1);
+              }
+              if(sublattice == 0) hops.clear();
+              domain.outboxes[sublattice].clear();
+              runHalfWindow_(domain_index,sublattice,window_end,
+                  domain.outboxes[sublattice],hops);
+            }catch(...){
+              errors[domain_index] = current_exception();
+              failed[sublattice] = true;
+            }
+          }
+          barrier.wait();
+          if(failed[sublattice]) return;
+          takeInWalkers_(domain_index,sublattice);
+        }
+      }
+    };
+
+    vector<thread> threads;
+    threads.reserve(number_of_domains-1);
+    for(int domain_index = 1; domain_index < number_of_domains; ++domain_index){
+      threads.emplace_back(run_domain,domain_index);
+    }
+    run_domain(0);
+    for(thread & domain_thread : threads) domain_thread.join();
+
+    for(Domain & domain : domains_){
+      number_of_walkers_ -= domain.drained_walkers;
+      domain.drained_walkers = 0;
+    }
+    for(const exception_ptr & error : errors){
+      if(error) rethrow_exception(error);
+    }
+    collect_hops(last_window - 1);
+    windows_run_ = last_window;
+    time_ = windows_run_ * window;
+  }
+
+  /****************************************************************************
+   * Internal Private Functions
+   ****************************************************************************/
+
+  void DomainDecomposedSystem::checkDomains_() const {
+    // For each half window the domain that is the only one allowed to write
+    // to each site
+    const int number_of_rows = rate_graph_->getNumberOfRows();
+    vector<int> writers[2];
+    writers[0].assign(number_of_rows,constants::unassignedId);
+    writers[1].assign(number_of_rows,constants::unassignedId);
+    for(int row = 0; row < number_of_rows; ++row){
+      if(rate_graph_->getRowSize(row) > 0){
+        writers[sublattice_of_row_[row]][row] = domain_of_row_[row];
+      }
+    }
+    for(int row = 0; row < number_of_rows; ++row){
+      const int domain = domain_of_row_[row];
+      vector<int> & writers_of_sublattice = writers[sublattice_of_row_[row]];
+      for(int entry = rate_graph_->getRowBegin(row); entry < rate_graph_->getRowEnd(row); ++entry){
+        const int neigh_row = rate_graph_->getNeighborIndex(entry);
+        // Walkers are taken out of the system rather than placed on drains
+        if(rate_graph_->getRowSize(neigh_row) == 0) continue;
+        int & writer = writers_of_sublattice[neigh_row];
+        if(writer == constants::unassignedId){
+          writer = domain;
+        }else if(writer != domain){
+          throw invalid_argument("Site " +
+              to_string(rate_network_->getSiteIds()[neigh_row]) + " can be "
+              "reached from both domain " + to_string(writer) + " and domain " +
+              to_string(domain) + " while they hop at the same time, the "
+              "domains or their sublattices are too thin for the hops "
+              "between the sites.");
+        }
+      }
+    }
+  }
+
+  void DomainDecomposedSystem::drawNextHop_(
+      Domain & domain,
+      const int walker_id,
+      const double time) {
+
+    const int row = walker_rows_[walker_id];
+    uniform_real_distribution<double> distribution(0.0,1.0);
+    // Keep the number above 0 so the dwell time is finite
+    const double number = 1.0 - distribution(domain.random_engine);
+    walker_times_[walker_id] = time - log(number) / rate_graph_->getSumOfRates(row);
+    const int entry = rate_graph_->sampleRow(row,distribution(domain.random_engine));
+    walker_target_rows_[walker_id] = rate_graph_->getNeighborIndex(entry);
+  }
+
+  void DomainDecomposedSystem::runHalfWindow_(
+      const int domain_index,
+      const int sublattice,
+      const double window_end,
+      vector<int> & outbox,
+      vector<HopEvent> & hops) {
+
+    Domain & domain = domains_[domain_index];
+    Queue & queue = domain.queues[sublattice];
+    const vector<int> & siteIds = rate_network_->getSiteIds();
+    while(!queue.empty() && queue.peek().second < window_end){
+      const int walker_id = queue.peek().first;
+      const double time = queue.peek().second;
+      const int row = walker_rows_[walker_id];
+      const int target_row = walker_target_rows_[walker_id];
+
+      if(rate_graph_->getRowSize(target_row) == 0){
+        hops.push_back({walker_id,siteIds[row],siteIds[target_row],time});
+        queue.erase(walker_id);
+        occupied_[row] = 0;
+        walker_rows_[walker_id] = constants::unassignedId;
+        ++domain.drained_walkers;
+        continue;
+      }
+
+      if(occupied_[target_row]){
+        hops.push_back({walker_id,siteIds[row],siteIds[row],time});
+        drawNextHop_(domain,walker_id,time);
+        queue.update({walker_id,walker_times_[walker_id]});
+        continue;
+      }
+
+      hops.push_back({walker_id,siteIds[row],siteIds[target_row],time});
+      occupied_[row] = 0;
+      occupied_[target_row] = 1;
+      walker_rows_[walker_id] = target_row;
+      drawNextHop_(domain,walker_id,time);
+      if(domain_of_row_[target_row] == domain_index &&
+          sublattice_of_row_[target_row] == sublattice){
+        queue.update({walker_id,walker_times_[walker_id]});
+      }else{
+        queue.erase(walker_id);
+        if(domain_of_row_[target_row] == domain_index){
+          domain.queues[1-sublattice].sortedAdd({walker_id,walker_times_[walker_id]});
+        }else{
+          outbox.push_back(walker_id);
+        }
+      }
+    }
+  }
+
+  void DomainDecomposedSystem::takeInWalkers_(
+      const int domain_index,
+      const int parity) {
+
+    // Going through the domains in order keeps the queues reproducible
+    for(int other_domain = 0; other_domain < getNumberOfDomains(); ++other_domain){
+      if(other_domain == domain_index) continue;
+      for(const int walker_id : domains_[other_domain].outboxes[parity]){
+        if(domain_of_row_[walker_rows_[walker_id]] == domain_index){
+          queueWalker_(walker_id);
+        }
+      }
+    }
+  }
+
+  void DomainDecomposedSystem::queueWalker_(const int walker_id) {
+    const int row = walker_rows_[walker_id];
+    domains_[domain_of_row_[row]].queues[sublattice_of_row_[row]].sortedAdd(
+        {walker_id,walker_times_[walker_id]});
+  }
+
+}
@@ -6,25 +6,61 @@
 #include <memory>
 #include <string>
 
+#include "rate_graph.hpp"
 #include "site_container.hpp"
 #include "ugly/edge_directed_weighted.hpp"
 #include "ugly/graph_node.hpp"
 
 namespace mythical {
-  
+
+  /**
+   * \brief Read only view of the rates off of a single site
+   *
+   * Reads the row of the site straight out of the rate graph shared by the
+   * sites, so nothing is copied and no maps are built. The view is only valid
+   * as long as the site container it was taken from.
+   **/
+  class OutgoingRates {
+    public:
+      OutgoingRates(const Site & site) :
+        graph_(&site.getRateGraph()),
+        begin_(graph_->getRowBegin(site.getRateGraphRow())),
+        end_(graph_->getRowEnd(site.getRateGraphRow())) {};
+
+      int size() const { return end_-begin_; }
+      int getNeighborId(const int & neighbor) const {
+        return graph_->getNeighborId(begin_+neighbor);
+      }
+      double getRate(const int & neighbor) const {
+        return graph_->getRate(begin_+neighbor);
+      }
+    private:
+      const RateGraph * graph_;
+      int begin_;
+      int end_;
+  };
+
+  inline OutgoingRates getOutgoingRates(
+      const Site_Container & site_container,
+      const int & siteId)
+  {
+    return OutgoingRates(
+        site_container.getSiteByIndex(site_container.getIndex(siteId)));
+  }
+
   // Can only take arguments of type container<unique_ptr<Edge>>
   template<typename T> 
   T convertSitesOutgoingRatesToUniqueWeightedEdges(
-      Site_Container site_container, 
+      const Site_Container & site_container, 
       int siteId)
   {
     T container;
-    Rate_Map rate_map = site_container.getRates();
-    for ( auto neigh : rate_map[siteId] ){
-      int neigh_id = neigh.first;
-      double * rate = neigh.second;
+    const OutgoingRates rates = getOutgoingRates(site_container,siteId);
+    for ( int neighbor = 0; neighbor < rates.size(); ++neighbor ){
+      int neigh_id = rates.getNeighborId(neighbor);
+      double rate = rates.getRate(neighbor);
     
-      auto edge_ptr = std::unique_ptr<ugly::EdgeDirectedWeighted>(new ugly::EdgeDirectedWeighted(siteId,neigh_id,*rate));
+      auto edge_ptr = std::unique_ptr<ugly::EdgeDirectedWeighted>(new ugly::EdgeDirectedWeighted(siteId,neigh_id,rate));
 
       container.insert(container.begin(),std::move(edge_ptr));
     }
@@ -34,16 +70,16 @@ namespace mythical {
   // Can only take arguments of type container<shared_ptr<Edge>>
   template<typename T> 
   T convertSitesOutgoingRatesToSharedWeightedEdges(
-      Site_Container site_container, 
+      const Site_Container & site_container, 
       int siteId)
   {
     T container;
-    Rate_Map rate_map = site_container.getRates();
-    for ( auto neigh : rate_map[siteId] ){
-      int neigh_id = neigh.first;
-      double * rate = neigh.second;
+    const OutgoingRates rates = getOutgoingRates(site_container,siteId);
+    for ( int neighbor = 0; neighbor < rates.size(); ++neighbor ){
+      int neigh_id = rates.getNeighborId(neighbor);
+      double rate = rates.getRate(neighbor);
     
-      auto edge_ptr = std::shared_ptr<ugly::EdgeDirectedWeighted>(new ugly::EdgeDirectedWeighted(siteId,neigh_id,*rate));
+      auto edge_ptr = std::shared_ptr<ugly::EdgeDirectedWeighted>(new ugly::EdgeDirectedWeighted(siteId,neigh_id,rate));
 
       container.insert(container.begin(),std::move(edge_ptr));
     }
@@ -53,17 +89,17 @@ namespace mythical {
   // Same as the above method but for a vector of integers
   template<typename T> 
   T convertSitesOutgoingRatesToSharedWeightedEdges(
-      Site_Container site_container, 
-      std::vector<int> siteIds)
+      const Site_Container & site_container, 
+      const std::vector<int> & siteIds)
   {
     T container;
-    Rate_Map rate_map = site_container.getRates();
     for(auto siteId : siteIds ){
-      for ( auto neigh : rate_map[siteId] ){
-        int neigh_id = neigh.first;
-        double * rate = neigh.second;
+      const OutgoingRates rates = getOutgoingRates(site_container,siteId);
+      for ( int neighbor = 0; neighbor < rates.size(); ++neighbor ){
+        int neigh_id = rates.getNeighborId(neighbor);
+        double rate = rates.getRate(neighbor);
 
-        auto edge_ptr = std::shared_ptr<ugly::EdgeDirectedWeighted>(new ugly::EdgeDirectedWeighted(siteId,neigh_id,*rate));
+        auto edge_ptr = std::shared_ptr<ugly::EdgeDirectedWeighted>(new ugly::EdgeDirectedWeighted(siteId,neigh_id,rate));
 
         container.insert(container.begin(),std::move(edge_ptr));
       }
@@ -73,15 +109,15 @@ namespace mythical {
 
   template<typename T> 
   T convertSitesOutgoingRatesToTimeSharedWeightedEdges(
-      Site_Container site_container, 
-      std::vector<int> siteIds)
+      const Site_Container & site_container, 
+      const std::vector<int> & siteIds)
   {
     T container;
-    Rate_Map rate_map = site_container.getRates();
     for(auto siteId : siteIds ){
-      for ( auto neigh : rate_map[siteId] ){
-        int neigh_id = neigh.first;
-        double  time = 1.0/(*neigh.second);
+      const OutgoingRates rates = getOutgoingRates(site_container,siteId);
+      for ( int neighbor = 0; neighbor < rates.size(); ++neighbor ){
+        int neigh_id = rates.getNeighborId(neighbor);
+        double  time = 1.0/(rates.getRate(neighbor));
         auto edge_ptr = std::shared_ptr<ugly::EdgeDirectedWeighted>(new ugly::EdgeDirectedWeighted(siteId,neigh_id,time));
 
         container.insert(container.begin(),std::move(edge_ptr));
@@ -0,0 +1,121 @@
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "hot_site_sketch.hpp"
+
+using namespace std;
+
+namespace mythical {
+
+  HotSiteSketch::HotSiteSketch(const int capacity) : capacity_(capacity) {
+    if(capacity < 1){
+      throw invalid_argument("A hot site sketch needs at least one counter.");
+    }
+    counters_.reserve(capacity);
+    buckets_.reserve(capacity+1);
+    free_buckets_.reserve(capacity+1);
+    position_of_site_.reserve(capacity);
+  }
+
+  void HotSiteSketch::visit(const int siteId){
+    auto position = position_of_site_.find(siteId);
+    if(position != position_of_site_.end()){
+      increment_(position->second);
+      return;
+    }
+    const int last = static_cast<int>(counters_.size())-1;
+    if(last+1 < capacity_){
+      // Starts with no visits so it goes at the back
+      position_of_site_[siteId] = last+1;
+      counters_.push_back({siteId,0,0,newBucket_(0,last+1)});
+      increment_(last+1);
+      return;
+    }
+    // The counter at the back has the fewest visits
+    Counter & coldest = counters_[last];
+    position_of_site_.erase(coldest.siteId);
+    position_of_site_[siteId] = last;
+    coldest.siteId = siteId;
+    coldest.error = coldest.visits;
+    increment_(last);
+  }
+
+  const vector<int> & HotSiteSketch::getHottestSites(const int count){
+    hottest_sites_.clear();
+    for(const Counter & counter : counters_) hottest_sites_.push_back(counter.siteId);
+    const size_t returned = min(hottest_sites_.size(),
+        static_cast<size_t>(max(count,0)));
+    // Ties go to the site with the smaller error, its count is more certain
+    partial_sort(hottest_sites_.begin(),hottest_sites_.begin()+returned,
+        hottest_sites_.end(),
+        [this](const int & siteId1, const int & siteId2){
+          const Counter & counter1 = counters_[position_of_site_.at(siteId1)];
+          const Counter & counter2 = counters_[position_of_site_.at(siteId2)];
+          if(counter1.visits != counter2.visits){
+            return counter1.visits > counter2.visits;
+          }
+          if(counter1.error != counter2.error) return counter1.error < counter2.error;
+          return counter1.siteId < counter2.siteId;
+        });
+    hottest_sites_.resize(returned);
+    return hottest_sites_;
+  }
+
+  long HotSiteSketch::getVisits(const int siteId) const {
+    auto position = position_of_site_.find(siteId);
+    if(position == position_of_site_.end()) return 0;
+    return counters_[position->second].visits;
+  }
+
+  void HotSiteSketch::clear(){
+    counters_.clear();
+    buckets_.clear();
+    free_buckets_.clear();
+    position_of_site_.clear();
+    hottest_sites_.clear();
+  }
+
+  // The counter is swapped with the first counter of its bucket, it then
+  // either joins the bucket in front or starts a new one, so the counters
+  // stay in order
+  void HotSiteSketch::increment_(int position){
+    const int bucket = counters_[position].bucket;
+    const int first = buckets_[bucket].first;
+    swapCounters_(position,first);
+    position = first;
+
+    const long visits = buckets_[bucket].visits+1;
+    const int next = position+1;
+    if(next < static_cast<int>(counters_.size()) && counters_[next].bucket == bucket){
+      buckets_[bucket].first = next;
+    }else{
+      free_buckets_.push_back(bucket);
+    }
+    if(position > 0 && counters_[position-1].visits == visits){
+      counters_[position].bucket = counters_[position-1].bucket;
+    }else{
+      counters_[position].bucket = newBucket_(visits,position);
+    }
+    counters_[position].visits = visits;
+  }
+
+  int HotSiteSketch::newBucket_(const long visits, const int first){
+    if(free_buckets_.empty()){
+      buckets_.push_back({visits,first});
+      return static_cast<int>(buckets_.size())-1;
+    }
+    const int bucket = free_buckets_.back();
+    free_buckets_.pop_back();
+    buckets_[bucket] = {visits,first};
+    return bucket;
+  }
+
+  void HotSiteSketch::swapCounters_(const int position1, const int position2){
+    if(position1 == position2) return;
+    swap(counters_[position1],counters_[position2]);
+    position_of_site_[counters_[position1].siteId] = position1;
+    position_of_site_[counters_[position2].siteId] = position2;
+  }
+
+}
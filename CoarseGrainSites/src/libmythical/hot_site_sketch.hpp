@@ -0,0 +1,77 @@
+#ifndef MYTHICAL_HOT_SITE_SKETCH_HPP
+#define MYTHICAL_HOT_SITE_SKETCH_HPP
+
+#include <unordered_map>
+#include <vector>
+
+namespace mythical {
+
+/**
+ * \brief Keeps track of the most visited sites with a fixed amount of memory
+ *
+ * Uses the space saving algorithm. A counter is kept for at most capacity
+ * sites, when a site without a counter is visited and all the counters are in
+ * use the counter with the fewest visits is handed over to the new site and
+ * incremented. Any site visited more than 1/capacity of the time is
+ * guaranteed to hold a counter. A counter never has fewer visits than its
+ * site was given, it can overestimate them by at most its error.
+ *
+ * The counters are kept in order of their visits and grouped into buckets of
+ * equal visits, the stream summary of Metwally et al., so a visit takes
+ * constant time whether or not the site holds a counter.
+ **/
+class HotSiteSketch {
+  public:
+    explicit HotSiteSketch(const int capacity);
+
+    void visit(const int siteId);
+
+    /**
+     * \brief Sites with the most visits, the most visited first
+     *
+     * \param[in] count the largest number of sites returned
+     **/
+    const std::vector<int> & getHottestSites(const int count);
+
+    /// Visits counted for a site, 0 if the site does not hold a counter
+    long getVisits(const int siteId) const;
+
+    int getCapacity() const { return capacity_; }
+
+    /// Forget all the visits, the memory is kept
+    void clear();
+
+  private:
+    struct Counter {
+      int siteId;
+      long visits;
+      /// Visits the counter had when it was handed over to the site
+      long error;
+      /// Bucket of the counters with the same visits
+      int bucket;
+    };
+
+    /// Position of the first counter with the visits of the bucket
+    struct Bucket {
+      long visits;
+      int first;
+    };
+
+    int capacity_;
+    /// Ordered from the most to the fewest visits
+    std::vector<Counter> counters_;
+    std::vector<Bucket> buckets_;
+    std::vector<int> free_buckets_;
+    /// Position of each site's counter
+    std::unordered_map<int,int> position_of_site_;
+    std::vector<int> hottest_sites_;
+
+    /// Add a visit to the counter at the position, keeping the order
+    void increment_(int position);
+    int newBucket_(const long visits, const int first);
+    void swapCounters_(const int position1, const int position2);
+};
+
+}
+
+#endif // MYTHICAL_HOT_SITE_SKETCH_HPP
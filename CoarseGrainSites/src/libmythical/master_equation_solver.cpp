@@ -0,0 +1,263 @@
+
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "master_equation_solver.hpp"
+
+using namespace std;
+
+namespace {
+  /// Maximum number of factorizations used by the direct solve
+  const long max_factorizations = 50;
+
+  /**
+   * \brief LU factorization with partial pivoting of a dense row major matrix
+   *
+   * Pivots that are exactly zero, which happens when the shift matches the
+   * eigenvalue, are replaced with a tiny value so the solve still points
+   * along the eigenvector.
+   **/
+  void factorize(vector<double> & matrix, const int count, vector<int> & pivots){
+    pivots.resize(count);
+    for(int column = 0; column < count; ++column){
+      int pivot = column;
+      for(int row = column+1; row < count; ++row){
+        if(fabs(matrix[row*count+column]) > fabs(matrix[pivot*count+column])){
+          pivot = row;
+        }
+      }
+      pivots[column] = pivot;
+      if(pivot != column){
+        for(int entry = 0; entry < count; ++entry){
+          swap(matrix[column*count+entry],matrix[pivot*count+entry]);
+        }
+      }
+      double & diagonal = matrix[column*count+column];
+      if(diagonal == 0.0) diagonal = numeric_limits<double>::epsilon();
+      const double inverse_diagonal = 1.0/diagonal;
+      for(int row = column+1; row < count; ++row){
+        double * lower = &matrix[row*count];
+        const double * upper = &matrix[column*count];
+        const double factor = lower[column]*inverse_diagonal;
+        lower[column] = factor;
+        for(int entry = column+1; entry < count; ++entry){
+          lower[entry] -= factor*upper[entry];
+        }
+      }
+    }
+  }
+
+  void solveFactorized(const vector<double> & matrix, const int count,
+      const vector<int> & pivots, vector<double> & values){
+    for(int row = 0; row < count; ++row){
+      swap(values[row],values[pivots[row]]);
+    }
+    for(int row = 0; row < count; ++row){
+      const double * lower = &matrix[row*count];
+      double value = values[row];
+      for(int entry = 0; entry < row; ++entry) value -= lower[entry]*values[entry];
+      values[row] = value;
+    }
+    for(int row = count-1; row >= 0; --row){
+      const double * upper = &matrix[row*count];
+      double value = values[row];
+      for(int entry = row+1; entry < count; ++entry) value -= upper[entry]*values[entry];
+      values[row] = value/upper[row];
+    }
+  }
+}
+
+namespace mythical {
+
+  int MasterEquationSolver::addRow(
+      const vector<pair<int,double>> & sources_and_probabilities,
+      const double probability_of_staying){
+
+    for(const pair<int,double> & source : sources_and_probabilities){
+      sources_.push_back(source.first);
+      transition_probabilities_.push_back(source.second);
+    }
+    row_offsets_.push_back(static_cast<int>(sources_.size()));
+    probability_of_staying_.push_back(probability_of_staying);
+    return size()-1;
+  }
+
+  void MasterEquationSolver::clear(){
+    row_offsets_.assign(1,0);
+    sources_.clear();
+    transition_probabilities_.clear();
+    probability_of_staying_.clear();
+    probabilities_.clear();
+    next_probabilities_.clear();
+    older_probabilities_.clear();
+    old_probabilities_.clear();
+  }
+
+  void MasterEquationSolver::initializeProbabilities(){
+    probabilities_.assign(size(),1.0/static_cast<double>(size()));
+    next_probabilities_.assign(size(),0.0);
+  }
+
+  void MasterEquationSolver::initializeProbabilities(const vector<double> & initial){
+    assert(static_cast<int>(initial.size())==size() && "there must be one "
+        "probability per row");
+    double total = 0.0;
+    for(const double & probability : initial) total += probability;
+    if(!(total > 0.0)){
+      initializeProbabilities();
+      return;
+    }
+    const double inverse_total = 1.0/total;
+    probabilities_.resize(size());
+    for(int row = 0; row < size(); ++row){
+      probabilities_[row] = initial[row]*inverse_total;
+    }
+    next_probabilities_.assign(size(),0.0);
+  }
+
+  double MasterEquationSolver::sweep(){
+    const int rows = size();
+    const int * offsets = row_offsets_.data();
+    const int * sources = sources_.data();
+    const double * transitions = transition_probabilities_.data();
+    const double * staying = probability_of_staying_.data();
+    const double * probabilities = probabilities_.data();
+    double * next = next_probabilities_.data();
+
+    double total = 0.0;
+    for(int row = 0; row < rows; ++row){
+      double probability = staying[row]*probabilities[row];
+      const int end = offsets[row+1];
+      for(int entry = offsets[row]; entry < end; ++entry){
+        probability += transitions[entry]*probabilities[sources[entry]];
+      }
+      next[row] = probability;
+      total += probability;
+    }
+
+    // Combine the former probability with the presently calculated probability
+    const double inverse_total = 1.0/total;
+    double total2 = 0.0;
+    for(int row = 0; row < rows; ++row){
+      next[row] = (next[row]*inverse_total + probabilities[row])*0.5;
+      total2 += next[row];
+    }
+
+    // Normalize the probability
+    const double inverse_total2 = 1.0/total2;
+    double error = 0.0;
+    for(int row = 0; row < rows; ++row){
+      next[row] *= inverse_total2;
+      const double diff = probabilities[row] - next[row];
+      error += diff*diff;
+    }
+
+    probabilities_.swap(next_probabilities_);
+    return sqrt(error);
+  }
+
+  long MasterEquationSolver::sweepUntilConverged(const double tolerance){
+    long sweeps = 0;
+    double error = tolerance * 1.1;
+    while(error > tolerance){
+      error = sweep();
+      ++sweeps;
+    }
+    return sweeps;
+  }
+
+  long MasterEquationSolver::sweepUntilConvergedAccelerated(const double tolerance){
+    long sweeps = 0;
+    double error = tolerance * 1.1;
+    while(error > tolerance){
+      if(sweeps%3 == 1){
+        older_probabilities_ = probabilities_;
+      }else if(sweeps%3 == 2){
+        old_probabilities_ = probabilities_;
+      }
+      error = sweep();
+      ++sweeps;
+      if(sweeps%3 == 0 && error > tolerance) extrapolate_();
+    }
+    return sweeps;
+  }
+
+  long MasterEquationSolver::solveDirect(const double tolerance){
+    const int count = size();
+    if(count == 0) return 0;
+
+    vector<double> transitions(static_cast<size_t>(count)*count,0.0);
+    for(int row = 0; row < count; ++row){
+      transitions[row*count+row] += probability_of_staying_[row];
+      for(int entry = row_offsets_[row]; entry < row_offsets_[row+1]; ++entry){
+        transitions[row*count+sources_[entry]] += transition_probabilities_[entry];
+      }
+    }
+
+    vector<double> shifted;
+    vector<int> pivots;
+    long factorizations = 0;
+    while(factorizations < max_factorizations){
+      // The largest ratio of the transitioned to the current probabilities is
+      // an upper bound of the largest eigenvalue, so the shifted matrix picks
+      // out its eigenvector
+      double shift = 0.0;
+      for(int row = 0; row < count; ++row){
+        if(probabilities_[row] <= 0.0) continue;
+        double transitioned = 0.0;
+        for(int column = 0; column < count; ++column){
+          transitioned += transitions[row*count+column]*probabilities_[column];
+        }
+        const double ratio = transitioned/probabilities_[row];
+        if(ratio > shift) shift = ratio;
+      }
+
+      shifted = transitions;
+      for(size_t entry = 0; entry < shifted.size(); ++entry) shifted[entry] = -shifted[entry];
+      for(int row = 0; row < count; ++row) shifted[row*count+row] += shift;
+      factorize(shifted,count,pivots);
+
+      next_probabilities_ = probabilities_;
+      solveFactorized(shifted,count,pivots,next_probabilities_);
+      ++factorizations;
+
+      double total = 0.0;
+      for(int row = 0; row < count; ++row) total += next_probabilities_[row];
+      const double inverse_total = 1.0/total;
+      double error = 0.0;
+      for(int row = 0; row < count; ++row){
+        next_probabilities_[row] *= inverse_total;
+        const double diff = probabilities_[row] - next_probabilities_[row];
+        error += diff*diff;
+      }
+      probabilities_.swap(next_probabilities_);
+      if(sqrt(error) <= tolerance) break;
+    }
+    return factorizations;
+  }
+
+  /****************************************************************************
+   * Private Internal Functions
+   ****************************************************************************/
+
+  void MasterEquationSolver::extrapolate_(){
+    const int rows = size();
+    const double * older = older_probabilities_.data();
+    const double * old = old_probabilities_.data();
+    double * probabilities = probabilities_.data();
+    double total = 0.0;
+    for(int row = 0; row < rows; ++row){
+      const double step = probabilities[row]-old[row];
+      const double curvature = step-(old[row]-older[row]);
+      if(curvature != 0.0){
+        const double extrapolated = probabilities[row]-step*step/curvature;
+        if(extrapolated > 0.0) probabilities[row] = extrapolated;
+      }
+      total += probabilities[row];
+    }
+    const double inverse_total = 1.0/total;
+    for(int row = 0; row < rows; ++row) probabilities[row] *= inverse_total;
+  }
+
+}
@@ -0,0 +1,130 @@
+#ifndef MYTHICAL_MASTER_EQUATION_SOLVER_HPP
+#define MYTHICAL_MASTER_EQUATION_SOLVER_HPP
+
+#include <utility>
+#include <vector>
+
+namespace mythical {
+
+/**
+ * \brief Solves the master equation of the sites in a cluster
+ *
+ * Each site of the cluster is given a row, the row stores the sites within
+ * the cluster a walker can hop to the site from, along with the probability
+ * of that hop, in compressed sparse row format. The probability of a walker
+ * staying on a site is stored separately. Everything is kept in dense arrays
+ * referred to by the order the rows were added in, so a sweep only walks
+ * contiguous memory.
+ *
+ * The matrix only needs to be built once each time the cluster changes,
+ * after which any number of sweeps can be run on it.
+ **/
+class MasterEquationSolver {
+  public:
+    MasterEquationSolver() : row_offsets_(1,0) {};
+
+    /**
+     * \brief Append the row of a site
+     *
+     * \param[in] sources_and_probabilities the first int is the row of a site
+     * a walker can hop to this site from, the double is the probability of
+     * hopping from that site to this one
+     * \param[in] probability_of_staying one minus the probability of hopping
+     * off of the site to any of its neighbors, within or outside the cluster
+     *
+     * \return the index of the row that was added
+     **/
+    int addRow(const std::vector<std::pair<int,double>> & sources_and_probabilities,
+        const double probability_of_staying);
+
+    void clear();
+
+    int size() const { return static_cast<int>(probability_of_staying_.size()); }
+
+    /**
+     * \brief Set the probability of a walker being on each site to be equal
+     **/
+    void initializeProbabilities();
+
+    /**
+     * \brief Start from a guess of the probabilities, one per row
+     *
+     * The guess does not need to be normalized. Starting close to the
+     * solution, e.g. from the probabilities of the clusters that were merged
+     * to form this one, reduces the number of sweeps needed.
+     **/
+    void initializeProbabilities(const std::vector<double> & initial);
+
+    /**
+     * \brief Update the probabilities with a single Jacobi sweep
+     *
+     * The probabilities found by the sweep are normalized and then averaged
+     * with the previous probabilities before normalizing again.
+     *
+     * \return the root of the sum of the squared change in the probabilities
+     **/
+    double sweep();
+
+    /**
+     * \brief Sweep until the change in the probabilities is below the
+     * tolerance
+     *
+     * \return the number of sweeps
+     **/
+    long sweepUntilConverged(const double tolerance);
+
+    /**
+     * \brief Same as sweepUntilConverged but every third sweep the
+     * probabilities are extrapolated with Aitken's delta squared process
+     *
+     * Converges to the same probabilities in fewer sweeps when the sweeps
+     * converge slowly, as happens when the rates within the cluster differ
+     * by orders of magnitude.
+     *
+     * \return the number of sweeps
+     **/
+    long sweepUntilConvergedAccelerated(const double tolerance);
+
+    /**
+     * \brief Find the probabilities with dense LU factorizations
+     *
+     * The probabilities are the eigenvector of the transition matrix with
+     * the largest eigenvalue, which is 1 if walkers cannot leave the cluster
+     * in which case the probabilities span the null space of the generator.
+     * They are found with inverse iteration, shifting the matrix by an upper
+     * bound of the eigenvalue that tightens each iteration, so only a handful
+     * of factorizations are needed. Takes O(n^3) time with n rows so it is
+     * meant for small clusters.
+     *
+     * \return the number of factorizations
+     **/
+    long solveDirect(const double tolerance);
+
+    /**
+     * \brief Probability of a walker being on the site of each row
+     **/
+    const std::vector<double> & getProbabilities() const { return probabilities_; }
+
+  private:
+    /// row_offsets_[row] is the first entry of the row, there is one more
+    /// offset than there are rows
+    std::vector<int> row_offsets_;
+    /// Row of the site a walker hops from for each entry
+    std::vector<int> sources_;
+    /// Probability of the hop for each entry
+    std::vector<double> transition_probabilities_;
+    std::vector<double> probability_of_staying_;
+
+    std::vector<double> probabilities_;
+    /// Scratch space used by the sweeps
+    std::vector<double> next_probabilities_;
+    /// Earlier sweeps used by the extrapolation
+    std::vector<double> older_probabilities_;
+    std::vector<double> old_probabilities_;
+
+    void extrapolate_();
+};
+
+}
+
+#endif // MYTHICAL_MASTER_EQUATION_SOLVER_HPP
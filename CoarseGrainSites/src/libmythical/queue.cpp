@@ -3,59 +3,202 @@
 
 #include <algorithm>
 #include <iostream>
+#include <stdexcept>
 
 using namespace std;
 
-namespace {
-  struct Comparator {
-    explicit Comparator(pair<int,double> value) : value_(value) { }
-    inline bool operator()(const pair<int,double> & value) const {
-      return value_.second < value.second;
-    }
-    private:
-    pair<int,double> value_;
-  };
-
-  struct less_than
-  {
-    inline bool operator() (const pair<int,double>& struct1, const pair<int,double>& struct2)
-    {
-      return (struct1.second < struct2.second);
-    }
-  }; 
-}
-
 namespace mythical {
 
-  size_t Queue::size() const noexcept { return walker_queue_.size(); }
+  size_t Queue::size() const noexcept { return heap_.size()-head_; }
 
   void Queue::add(pair<int,double> walker){
-    walker_queue_.push_back(walker);
+    checkId_(walker.first);
+    sequence_[walker.first] = next_sequence_++;
+    place_(static_cast<int>(size()),walker);
     sorted_ = false;
+    fully_sorted_ = false;
   }
 
   void Queue::sortedAdd(pair<int,double> walker){
-    Comparator comp(walker);
-    auto it = find_if(walker_queue_.begin(),walker_queue_.end(),comp);
-    walker_queue_.insert(it,walker);
+    sort();
+    checkId_(walker.first);
+    sequence_[walker.first] = next_sequence_++;
+    // Appending a walker that comes out after the last one keeps the heap
+    // sorted
+    bool still_sorted = fully_sorted_ && (empty() || before_(heap_.back(),walker));
+    place_(static_cast<int>(size()),walker);
+    siftUp_(static_cast<int>(size())-1);
+    fully_sorted_ = still_sorted;
+  }
+
+  void Queue::update(pair<int,double> walker){
+    if(!contains(walker.first)){
+      throw invalid_argument("Cannot update walker it is not in the queue.");
+    }
+    const int index = position_[walker.first]-static_cast<int>(head_);
+    heap_[position_[walker.first]].second = walker.second;
+    sequence_[walker.first] = next_sequence_++;
+    if(!sorted_) return;
+    // A walker that still comes out between its neighbors keeps the heap
+    // sorted
+    if(fully_sorted_){
+      const int last = static_cast<int>(size())-1;
+      if((index == 0 || before_(heap_[head_+index-1],walker)) &&
+          (index == last || before_(walker,heap_[head_+index+1]))) return;
+    }
+    siftUp_(index);
+    siftDown_(position_[walker.first]-static_cast<int>(head_));
+    fully_sorted_ = size()<2;
+  }
+
+  void Queue::erase(const int walker_id){
+    if(!contains(walker_id)){
+      throw invalid_argument("Cannot erase walker it is not in the queue.");
+    }
+    removeAt_(position_[walker_id]-static_cast<int>(head_));
+  }
+
+  bool Queue::contains(const int walker_id) const noexcept {
+    return walker_id >= 0 &&
+      walker_id < static_cast<int>(position_.size()) &&
+      position_[walker_id] != constants::unassignedId;
   }
 
   pair<int,double> Queue::pop_current() {
-    auto current = walker_queue_.front();
-    walker_queue_.pop_front();
+    if(sorted_) return pop();
+    auto current = heap_.at(head_);
+    removeAt_(0);
+    return current;
+  }
+
+  pair<int,double> Queue::pop() {
+    sort();
+    auto current = heap_.at(head_);
+    removeAt_(0);
     return current;
   }
 
+  const pair<int,double> & Queue::peek() {
+    sort();
+    return heap_.at(head_);
+  }
+
   bool Queue::isSorted() const noexcept { return sorted_ ; }
 
   void Queue::sort() {
     if ( sorted_ ) return;
-    std::sort( walker_queue_.begin(), walker_queue_.end(), less_than() );
+    sortAll_();
     sorted_ = true;
   }
 
   const pair<int,double> & Queue::at(int index) const {
-    return walker_queue_.at(index); 
+    if( sorted_ && index!=0 && !fully_sorted_ ) sortAll_();
+    return heap_.at(head_+index);
+  }
+
+  /****************************************************************************
+   * Private Internal Functions
+   ****************************************************************************/
+
+  void Queue::place_(const int index, const pair<int,double> & walker) const {
+    const size_t position = head_+index;
+    if(position == heap_.size()){
+      heap_.push_back(walker);
+    }else{
+      heap_[position] = walker;
+    }
+    position_[walker.first] = static_cast<int>(position);
+  }
+
+  void Queue::siftUp_(int index){
+    const pair<int,double> walker = heap_[head_+index];
+    while(index > 0){
+      const int parent = (index-1)/2;
+      if(!before_(walker,heap_[head_+parent])) break;
+      place_(index,heap_[head_+parent]);
+      index = parent;
+    }
+    place_(index,walker);
+  }
+
+  void Queue::siftDown_(int index){
+    const int count = static_cast<int>(size());
+    const pair<int,double> walker = heap_[head_+index];
+    while(true){
+      int child = 2*index+1;
+      if(child >= count) break;
+      if(child+1 < count && before_(heap_[head_+child+1],heap_[head_+child])){
+        ++child;
+      }
+      if(!before_(heap_[head_+child],walker)) break;
+      place_(index,heap_[head_+child]);
+      index = child;
+    }
+    place_(index,walker);
+  }
+
+  void Queue::removeAt_(const int index){
+    position_[heap_[head_+index].first] = constants::unassignedId;
+    // The rest of an unsorted or fully sorted queue is left in order
+    if(index == 0 && (!sorted_ || fully_sorted_)){
+      ++head_;
+      dropPopped_();
+      return;
+    }
+    if(!sorted_){
+      // Keep the order the walkers were added in
+      heap_.erase(heap_.begin()+head_+index);
+      reindex_(head_+index);
+      return;
+    }
+    const int last = static_cast<int>(size())-1;
+    if(index == last){
+      // Removing the back of a sorted heap leaves it sorted
+      heap_.pop_back();
+      return;
+    }
+    const int moved_id = heap_.back().first;
+    place_(index,heap_.back());
+    heap_.pop_back();
+    siftUp_(index);
+    siftDown_(position_[moved_id]-static_cast<int>(head_));
+    fully_sorted_ = size()<2;
+  }
+
+  void Queue::sortAll_() const {
+    std::sort( heap_.begin()+head_, heap_.end(),
+        [this](const pair<int,double> & walker, const pair<int,double> & other){
+          return before_(walker,other);
+        });
+    reindex_(head_);
+    fully_sorted_ = true;
+  }
+
+  // Each walker is moved at most once for every walker popped before it, so
+  // popping the front stays constant time on average
+  void Queue::dropPopped_(){
+    if(2*head_ < heap_.size()) return;
+    heap_.erase(heap_.begin(),heap_.begin()+head_);
+    head_ = 0;
+    reindex_(0);
+  }
+
+  void Queue::reindex_(const size_t from) const {
+    for(size_t position = from; position < heap_.size(); ++position){
+      position_[heap_[position].first] = static_cast<int>(position);
+    }
+  }
+
+  void Queue::checkId_(const int walker_id){
+    if(walker_id < 0){
+      throw invalid_argument("Walker ids stored in the queue must be positive.");
+    }
+    if(contains(walker_id)){
+      throw invalid_argument("Walker is already stored in the queue.");
+    }
+    if(walker_id >= static_cast<int>(position_.size())){
+      position_.resize(walker_id+1,constants::unassignedId);
+      sequence_.resize(walker_id+1,0);
+    }
   }
-  
 }
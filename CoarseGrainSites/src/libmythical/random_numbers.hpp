@@ -0,0 +1,66 @@
+#ifndef MYTHICAL_RANDOM_NUMBERS_HPP
+#define MYTHICAL_RANDOM_NUMBERS_HPP
+
+#include <random>
+#include <stdexcept>
+
+namespace mythical {
+
+/**
+ * \brief Source of the uniform random numbers the sites and clusters draw
+ * when walkers hop off of them
+ **/
+class RandomNumbers {
+  public:
+    virtual ~RandomNumbers() {};
+
+    /// Next uniform number in [0,1) for a hop of the walker
+    virtual double draw(const int walker_id) = 0;
+};
+
+/**
+ * \brief Mersenne Twister owned by a single site or cluster, every walker
+ * draws from the same engine
+ **/
+class FeatureRandomNumbers : public RandomNumbers {
+  public:
+    explicit FeatureRandomNumbers(const unsigned long seed) :
+      random_engine_(seed) {};
+
+    double draw(const int) override {
+      std::uniform_real_distribution<double> random_distribution(0.0, 1.0);
+      return random_distribution(random_engine_);
+    }
+
+  private:
+    std::mt19937 random_engine_;
+};
+
+/**
+ * \brief Seeds of the engines of many features, shared by the features
+ *
+ * A feature only creates its engine the first time it draws a number, seeded
+ * with the seed plus the offset of the feature, so features that are never
+ * visited do not pay for an engine. The numbers are drawn from the engines,
+ * never from the seeds.
+ **/
+class FeatureSeeds : public RandomNumbers {
+  public:
+    explicit FeatureSeeds(const unsigned long seed) : seed_(seed) {};
+
+    double draw(const int) override {
+      throw std::logic_error("Random numbers are drawn from the engines "
+          "created from the feature seeds, not from the seeds.");
+    }
+
+    FeatureRandomNumbers * createEngine(const unsigned long offset) const {
+      return new FeatureRandomNumbers(seed_+offset);
+    }
+
+  private:
+    unsigned long seed_;
+};
+
+}
+
+#endif // MYTHICAL_RANDOM_NUMBERS_HPP
@@ -0,0 +1,159 @@
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "rate_graph.hpp"
+
+using namespace std;
+
+namespace mythical {
+
+  int RateGraph::addRow(const unordered_map<int,double> & neighbors_and_rates){
+    vector<pair<int,double>> row(neighbors_and_rates.begin(),
+        neighbors_and_rates.end());
+    return addRow(move(row));
+  }
+
+  int RateGraph::addRow(vector<pair<int,double>> neighbors_and_rates){
+
+    const int size = static_cast<int>(neighbors_and_rates.size());
+    vector<int> neighbor_ids;
+    vector<double> rates;
+    neighbor_ids.reserve(size);
+    rates.reserve(size);
+    for(const pair<int,double> & neigh_and_rate : neighbors_and_rates){
+      neighbor_ids.push_back(neigh_and_rate.first);
+      rates.push_back(neigh_and_rate.second);
+    }
+    vector<double> cumulative_probabilities(size);
+    const double sum = normalizeRow_(neighbor_ids.data(),rates.data(),
+        cumulative_probabilities.data(),size);
+
+    neighbor_ids_.insert(neighbor_ids_.end(),neighbor_ids.begin(),neighbor_ids.end());
+    neighbor_indices_.insert(neighbor_indices_.end(),size,constants::unassignedId);
+    rates_.insert(rates_.end(),rates.begin(),rates.end());
+    cumulative_probabilities_.insert(cumulative_probabilities_.end(),
+        cumulative_probabilities.begin(),cumulative_probabilities.end());
+
+    sum_of_rates_.push_back(sum);
+    row_offsets_.push_back(static_cast<int>(neighbor_ids_.size()));
+    const int row = getNumberOfRows()-1;
+    if(usesAliasTables_()) buildAliasTableOfRow_(row);
+    return row;
+  }
+
+  void RateGraph::assignRows(vector<int> row_offsets,
+      vector<int> neighbor_ids,
+      vector<double> rates){
+
+    if(row_offsets.empty() || row_offsets.front()!=0 ||
+        row_offsets.back()!=static_cast<int>(neighbor_ids.size()) ||
+        neighbor_ids.size()!=rates.size()){
+      throw invalid_argument("Cannot assign rows to the rate graph, the row "
+          "offsets must start at 0 and end at the number of rates and neighbor "
+          "ids.");
+    }
+
+    const int rows = static_cast<int>(row_offsets.size())-1;
+    vector<double> sum_of_rates(rows,0.0);
+    vector<double> cumulative_probabilities(rates.size());
+    for(int row = 0; row < rows; ++row){
+      const int begin = row_offsets[row];
+      const int end = row_offsets[row+1];
+      if(end<begin){
+        throw invalid_argument("Cannot assign rows to the rate graph, the row "
+            "offsets must not decrease.");
+      }
+      sum_of_rates[row] = normalizeRow_(neighbor_ids.data()+begin,
+          rates.data()+begin,cumulative_probabilities.data()+begin,end-begin);
+    }
+
+    row_offsets_ = move(row_offsets);
+    neighbor_ids_ = move(neighbor_ids);
+    rates_ = move(rates);
+    cumulative_probabilities_ = move(cumulative_probabilities);
+    sum_of_rates_ = move(sum_of_rates);
+    neighbor_indices_.assign(neighbor_ids_.size(),constants::unassignedId);
+    setSamplingMethod(sampling_method_);
+  }
+
+  double RateGraph::normalizeRow_(int * neighbor_ids,
+      double * rates,
+      double * cumulative_probabilities,
+      const int size){
+
+    if(!is_sorted(neighbor_ids,neighbor_ids+size)){
+      vector<pair<int,double>> row(size);
+      for(int entry = 0; entry < size; ++entry){
+        row[entry] = make_pair(neighbor_ids[entry],rates[entry]);
+      }
+      sort(row.begin(),row.end(),
+          [](const pair<int,double> & lhs, const pair<int,double> & rhs){
+            return lhs.first < rhs.first;
+          });
+      for(int entry = 0; entry < size; ++entry){
+        neighbor_ids[entry] = row[entry].first;
+        rates[entry] = row[entry].second;
+      }
+    }
+
+    double sum = 0.0;
+    for(int entry = 0; entry < size; ++entry){
+      if(entry>0 && neighbor_ids[entry-1]==neighbor_ids[entry]){
+        throw invalid_argument("Cannot add a row to the rate graph with the "
+            "same neighbor listed more than once.");
+      }
+      sum += rates[entry];
+    }
+
+    double cumulative = 0.0;
+    for(int entry = 0; entry < size; ++entry){
+      cumulative += rates[entry]/sum;
+      cumulative_probabilities[entry] = cumulative;
+    }
+    // Guard against round off, a random number below 1 must land in the row
+    if(size>0) cumulative_probabilities[size-1] = 1.0;
+    return sum;
+  }
+
+  void RateGraph::setSamplingMethod(const SamplingMethod method){
+    sampling_method_ = method;
+    alias_probabilities_.clear();
+    aliases_.clear();
+    if(!usesAliasTables_()) return;
+    for(int row = 0; row < getNumberOfRows(); ++row){
+      buildAliasTableOfRow_(row);
+    }
+  }
+
+  void RateGraph::buildAliasTableOfRow_(const int & row){
+    alias_probabilities_.resize(rates_.size(),1.0);
+    aliases_.resize(rates_.size(),constants::unassignedId);
+    const int count = getRowSize(row);
+    if(count==0) return;
+    if(resolveSamplingMethod(sampling_method_,count)!=SamplingMethod::alias){
+      return;
+    }
+    const int begin = row_offsets_[row];
+    buildAliasTable(&rates_[begin],count,&alias_probabilities_[begin],
+        &aliases_[begin]);
+  }
+
+  int RateGraph::findEntry(const int & row, const int & neighId) const {
+    auto begin = neighbor_ids_.begin()+row_offsets_[row];
+    auto end = neighbor_ids_.begin()+row_offsets_[row+1];
+    auto it = lower_bound(begin,end,neighId);
+    if(it==end || *it!=neighId) return constants::unassignedId;
+    return static_cast<int>(it-neighbor_ids_.begin());
+  }
+
+  shared_ptr<const RateGraph> RateGraph::getEmptyGraph(){
+    static const shared_ptr<const RateGraph> empty_graph = [](){
+      shared_ptr<RateGraph> graph(new RateGraph);
+      graph->addRow(vector<pair<int,double>>());
+      return graph;
+    }();
+    return empty_graph;
+  }
+
+}
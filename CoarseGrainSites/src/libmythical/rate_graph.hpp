@@ -0,0 +1,174 @@
+#ifndef MYTHICAL_RATE_GRAPH_HPP
+#define MYTHICAL_RATE_GRAPH_HPP
+
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "mythical/constants.hpp"
+#include "mythical/sampling_method.hpp"
+#include "discrete_sampler.hpp"
+
+namespace mythical {
+
+/**
+ * \brief Stores the rates between sites in compressed sparse row format
+ *
+ * Each site is assigned a row, the rates off of the site are stored
+ * contiguously in the entries between getRowBegin and getRowEnd of that row.
+ * Within a row the entries are sorted by the id of the neighboring site.
+ * Along with the rates the graph stores the dense index of each neighbor and
+ * the cumulative probability of hopping to each neighbor, so that picking a
+ * neighbor only requires walking a contiguous block of memory.
+ *
+ * The rates are copied into the graph, changing the rates that were used to
+ * build it has no effect on the graph.
+ **/
+class RateGraph {
+  public:
+    RateGraph() : row_offsets_(1,0), sampling_method_(SamplingMethod::linear) {};
+
+    /**
+     * \brief Append a row containing the rates off of a site
+     *
+     * \param[in] neighbors_and_rates the first int is the id of the
+     * neighboring site the double is the rate to that neighbor
+     *
+     * \return the index of the row that was added
+     **/
+    int addRow(const std::unordered_map<int,double> & neighbors_and_rates);
+    int addRow(std::vector<std::pair<int,double>> neighbors_and_rates);
+
+    /**
+     * \brief Replace every row with rows already in compressed format
+     *
+     * The vectors are taken over by the graph, each row is sorted by
+     * neighbor id if it is not already.
+     *
+     * \param[in] row_offsets one more offset than there are rows, starting
+     * at 0 and ending at the number of entries
+     **/
+    void assignRows(std::vector<int> row_offsets,
+        std::vector<int> neighbor_ids,
+        std::vector<double> rates);
+
+    /**
+     * \brief Fill in the dense index of every neighbor
+     *
+     * Until this is called the neighbor indices are unassigned.
+     *
+     * \param[in] index_of_site callable converting a site id to its dense
+     * index
+     **/
+    template<typename IndexOf>
+    void resolveNeighborIndices(IndexOf index_of_site){
+      for(size_t entry = 0; entry < neighbor_ids_.size(); ++entry){
+        neighbor_indices_[entry] = index_of_site(neighbor_ids_[entry]);
+      }
+    }
+
+    int getNumberOfRows() const {
+      return static_cast<int>(row_offsets_.size())-1;
+    }
+    int getNumberOfEntries() const {
+      return static_cast<int>(neighbor_ids_.size());
+    }
+
+    int getRowBegin(const int & row) const { return row_offsets_[row]; }
+    int getRowEnd(const int & row) const { return row_offsets_[row+1]; }
+    int getRowSize(const int & row) const {
+      return row_offsets_[row+1]-row_offsets_[row];
+    }
+
+    int getNeighborId(const int & entry) const { return neighbor_ids_[entry]; }
+    int getNeighborIndex(const int & entry) const {
+      return neighbor_indices_[entry];
+    }
+    double getRate(const int & entry) const { return rates_[entry]; }
+    double getCumulativeProbability(const int & entry) const {
+      return cumulative_probabilities_[entry];
+    }
+    double getSumOfRates(const int & row) const { return sum_of_rates_[row]; }
+
+    /**
+     * \brief Find the entry of a neighbor within a row
+     *
+     * \return the entry or constants::unassignedId if the site is not a
+     * neighbor
+     **/
+    int findEntry(const int & row, const int & neighId) const;
+
+    /**
+     * \brief Set how entries are picked by sampleRow
+     *
+     * Alias tables are built for every row the method needs them for,
+     * including rows added afterwards.
+     **/
+    void setSamplingMethod(const SamplingMethod method);
+    SamplingMethod getSamplingMethod() const { return sampling_method_; }
+
+    /**
+     * \brief Pick an entry of the row with the probability of hopping to it
+     *
+     * \param[in] number a uniform random number between 0 and 1
+     *
+     * \return the entry picked or constants::unassignedId if the row is empty
+     **/
+    int sampleRow(const int & row, const double & number) const {
+      const int begin = row_offsets_[row];
+      const int count = row_offsets_[row+1]-begin;
+      if(count==0) return constants::unassignedId;
+      switch(resolveSamplingMethod(sampling_method_,count)){
+        case SamplingMethod::alias:
+          return begin + sampleAliasTable(&alias_probabilities_[begin],
+              &aliases_[begin],count,number);
+        case SamplingMethod::binary_search:
+          return begin + sampleCumulativeBinary(
+              &cumulative_probabilities_[begin],count,number);
+        default:
+          return begin + sampleCumulativeLinear(
+              &cumulative_probabilities_[begin],count,number);
+      }
+    }
+
+    /**
+     * \brief Graph containing a single row without any rates
+     *
+     * Shared by all the sites that have not been given any rates.
+     **/
+    static std::shared_ptr<const RateGraph> getEmptyGraph();
+
+  private:
+    /// row_offsets_[row] is the first entry of the row, there is one more
+    /// offset than there are rows
+    std::vector<int> row_offsets_;
+    std::vector<int> neighbor_ids_;
+    std::vector<int> neighbor_indices_;
+    std::vector<double> rates_;
+    std::vector<double> cumulative_probabilities_;
+    std::vector<double> sum_of_rates_;
+
+    SamplingMethod sampling_method_;
+    /// Alias tables of each row, only filled in for the rows that the
+    /// sampling method needs them for
+    std::vector<double> alias_probabilities_;
+    std::vector<int> aliases_;
+
+    bool usesAliasTables_() const {
+      return sampling_method_==SamplingMethod::alias ||
+        sampling_method_==SamplingMethod::automatic;
+    }
+    void buildAliasTableOfRow_(const int & row);
+
+    /// Sorts a row by neighbor id, fills in its cumulative probabilities and
+    /// returns the sum of its rates, throws if a neighbor is listed twice
+    static double normalizeRow_(int * neighbor_ids,
+        double * rates,
+        double * cumulative_probabilities,
+        const int size);
+};
+
+}
+
+#endif // MYTHICAL_RATE_GRAPH_HPP
@@ -0,0 +1,154 @@
+
+#include <cassert>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "mythical/rate_network.hpp"
+#include "rate_graph.hpp"
+
+using namespace std;
+
+namespace mythical {
+
+  namespace {
+
+    // Resolve the index of every neighbor, a neighbor that does not have a
+    // row of its own is given an empty row at the end so it acts as a drain.
+    // row_of_site returns constants::unassignedId for sites without a row.
+    template<typename RowOf>
+    void resolveNeighborsAddingDrains(RateGraph & rate_graph,
+        vector<int> & site_ids, RowOf row_of_site){
+
+      unordered_map<int,int> row_of_drain;
+      rate_graph.resolveNeighborIndices([&](const int & siteId){
+          const int row = row_of_site(siteId);
+          if(row!=constants::unassignedId) return row;
+          auto drain = row_of_drain.find(siteId);
+          if(drain!=row_of_drain.end()) return drain->second;
+          const int drain_row = static_cast<int>(site_ids.size());
+          site_ids.push_back(siteId);
+          row_of_drain[siteId] = drain_row;
+          return drain_row;
+        });
+      for(size_t drain = 0; drain < row_of_drain.size(); ++drain){
+        rate_graph.addRow(vector<pair<int,double>>());
+      }
+    }
+
+  }
+
+  shared_ptr<const RateNetwork> RateNetwork::create(
+      const unordered_map<int, unordered_map<int, double>> & ratesOfAllSites,
+      const SamplingMethod sampling_method){
+
+    shared_ptr<RateNetwork> network(new RateNetwork);
+    network->sampling_method_ = sampling_method;
+    network->site_ids_.reserve(ratesOfAllSites.size());
+
+    shared_ptr<RateGraph> rate_graph(new RateGraph);
+    rate_graph->setSamplingMethod(sampling_method);
+    unordered_map<int,int> row_of_site;
+    row_of_site.reserve(ratesOfAllSites.size());
+    for (const pair<const int,unordered_map<int,double>> & sites_and_rates : ratesOfAllSites){
+      assert(sites_and_rates.second.size()!=0 && "Sites must have at least one "
+          "rate to a neighbor.");
+      row_of_site[sites_and_rates.first] = rate_graph->addRow(sites_and_rates.second);
+      network->site_ids_.push_back(sites_and_rates.first);
+    }
+
+    resolveNeighborsAddingDrains(*rate_graph,network->site_ids_,
+        [&row_of_site](const int & siteId){
+          auto row = row_of_site.find(siteId);
+          return row==row_of_site.end() ? constants::unassignedId : row->second;
+        });
+
+    network->rate_graph_ = rate_graph;
+    return network;
+  }
+
+  shared_ptr<const RateNetwork> RateNetwork::create(
+      RateTable rate_table,
+      const SamplingMethod sampling_method){
+
+    const int rows = rate_table.row_offsets.empty() ? 0 :
+      static_cast<int>(rate_table.row_offsets.size())-1;
+    unordered_map<int,int> row_of_site;
+    if(!rate_table.site_ids.empty()){
+      if(static_cast<int>(rate_table.site_ids.size())!=rows){
+        throw invalid_argument("Cannot build a rate network from the table, "
+            "there are " + to_string(rate_table.site_ids.size()) + " site ids "
+            "for " + to_string(rows) + " rows.");
+      }
+      row_of_site.reserve(rows);
+      for(int row = 0; row < rows; ++row){
+        if(!row_of_site.emplace(rate_table.site_ids[row],row).second){
+          throw invalid_argument("Cannot build a rate network from the table, "
+              "site " + to_string(rate_table.site_ids[row]) + " has more than "
+              "one row.");
+        }
+      }
+    }
+    return createFromRows_(move(rate_table),row_of_site,sampling_method);
+  }
+
+  shared_ptr<const RateNetwork> RateNetwork::create(
+      const RateGenerator & generate,
+      const SamplingMethod sampling_method){
+
+    RateTable rate_table;
+    rate_table.row_offsets.push_back(0);
+    unordered_map<int,int> row_of_site;
+    generate([&](const int siteId, const int neighId, const double rate){
+        if(rate_table.site_ids.empty() || rate_table.site_ids.back()!=siteId){
+          if(!row_of_site.emplace(siteId,static_cast<int>(rate_table.site_ids.size())).second){
+            throw invalid_argument("Cannot build a rate network, the rates off "
+                "of site " + to_string(siteId) + " were not passed one after "
+                "the other.");
+          }
+          rate_table.site_ids.push_back(siteId);
+          rate_table.row_offsets.push_back(rate_table.row_offsets.back());
+        }
+        rate_table.neighbor_ids.push_back(neighId);
+        rate_table.rates.push_back(rate);
+        ++rate_table.row_offsets.back();
+      });
+    return createFromRows_(move(rate_table),row_of_site,sampling_method);
+  }
+
+  shared_ptr<const RateNetwork> RateNetwork::createFromRows_(
+      RateTable rate_table,
+      const unordered_map<int,int> & row_of_site,
+      const SamplingMethod sampling_method){
+
+    shared_ptr<RateNetwork> network(new RateNetwork);
+    network->sampling_method_ = sampling_method;
+
+    shared_ptr<RateGraph> rate_graph(new RateGraph);
+    rate_graph->setSamplingMethod(sampling_method);
+    rate_graph->assignRows(move(rate_table.row_offsets),
+        move(rate_table.neighbor_ids),move(rate_table.rates));
+    const int rows = rate_graph->getNumberOfRows();
+
+    if(rate_table.site_ids.empty()){
+      // The id of every site is its row
+      network->site_ids_.resize(rows);
+      for(int row = 0; row < rows; ++row) network->site_ids_[row] = row;
+      resolveNeighborsAddingDrains(*rate_graph,network->site_ids_,
+          [rows](const int & siteId){
+            return siteId>=0 && siteId<rows ? siteId : constants::unassignedId;
+          });
+    }else{
+      network->site_ids_ = move(rate_table.site_ids);
+      resolveNeighborsAddingDrains(*rate_graph,network->site_ids_,
+          [&row_of_site](const int & siteId){
+            auto row = row_of_site.find(siteId);
+            return row==row_of_site.end() ? constants::unassignedId : row->second;
+          });
+    }
+
+    network->rate_graph_ = rate_graph;
+    return network;
+  }
+
+}
@@ -0,0 +1,64 @@
+
+#include <limits>
+
+#include "mythical/constants.hpp"
+#include "rate_graph.hpp"
+#include "shortest_paths.hpp"
+
+using namespace std;
+
+namespace mythical {
+
+  double ShortestPaths::maxShortestTime(const RateGraph & graph,
+      const vector<int> & rows){
+
+    const int count = static_cast<int>(rows.size());
+    if(static_cast<int>(position_of_row_.size()) < graph.getNumberOfRows()){
+      position_of_row_.resize(graph.getNumberOfRows(),constants::unassignedId);
+    }
+    for(int position = 0; position < count; ++position){
+      position_of_row_[rows[position]] = position;
+    }
+
+    const double infinity = numeric_limits<double>::infinity();
+    times_.assign(static_cast<size_t>(count)*count,infinity);
+    for(int from = 0; from < count; ++from){
+      double * times_from = &times_[from*count];
+      times_from[from] = 0.0;
+      const int end = graph.getRowEnd(rows[from]);
+      for(int entry = graph.getRowBegin(rows[from]); entry < end; ++entry){
+        const int neighbor_row = graph.getNeighborIndex(entry);
+        if(neighbor_row < 0 || neighbor_row >= static_cast<int>(position_of_row_.size())){
+          continue;
+        }
+        const int to = position_of_row_[neighbor_row];
+        if(to == constants::unassignedId) continue;
+        const double time = 1.0/graph.getRate(entry);
+        if(time < times_from[to]) times_from[to] = time;
+      }
+    }
+
+    for(int via = 0; via < count; ++via){
+      const double * times_via = &times_[via*count];
+      for(int from = 0; from < count; ++from){
+        double * times_from = &times_[from*count];
+        const double time_to_via = times_from[via];
+        if(time_to_via == infinity) continue;
+        for(int to = 0; to < count; ++to){
+          const double time = time_to_via + times_via[to];
+          if(time < times_from[to]) times_from[to] = time;
+        }
+      }
+    }
+
+    double max_time = 0.0;
+    for(size_t index = 0; index < times_.size(); ++index){
+      if(times_[index] != infinity && times_[index] > max_time){
+        max_time = times_[index];
+      }
+    }
+
+    for(const int & row : rows) position_of_row_[row] = constants::unassignedId;
+    return max_time;
+  }
+}
@@ -0,0 +1,47 @@
+#ifndef MYTHICAL_SHORTEST_PATHS_HPP
+#define MYTHICAL_SHORTEST_PATHS_HPP
+
+#include <vector>
+
+namespace mythical {
+
+class RateGraph;
+
+/**
+ * \brief Finds the shortest times between every pair of sites in a subset of
+ * a rate graph
+ *
+ * A hop from one site to another takes the inverse of the rate between them,
+ * only hops between sites in the subset are considered. The times are found
+ * with the Floyd-Warshall algorithm on a dense matrix indexed by the position
+ * of each site in the subset. The matrix and the lookup from rate graph rows
+ * to positions are kept between calls, so once they have grown to the size of
+ * the largest subset no further memory is allocated.
+ **/
+class ShortestPaths {
+  public:
+    /**
+     * \brief Longest of the shortest times between every pair of connected
+     * sites
+     *
+     * The neighbor indices of the rate graph must have been resolved.
+     *
+     * \param[in] graph rates between the sites
+     * \param[in] rows rate graph row of each site in the subset
+     *
+     * \return the time, 0.0 if none of the sites are connected
+     **/
+    double maxShortestTime(const RateGraph & graph, const std::vector<int> & rows);
+
+  private:
+    /// Position of each rate graph row in the subset, unassigned for rows not
+    /// in the subset
+    std::vector<int> position_of_row_;
+
+    /// times_[from*count+to] shortest time between two positions
+    std::vector<double> times_;
+};
+
+}
+
+#endif // MYTHICAL_SHORTEST_PATHS_HPP
@@ -1,15 +1,26 @@
 
+#include <algorithm>
+#include <string>
+
 #include "site_container.hpp"
 
 using namespace std;
 
 namespace mythical {
 
+  void Site_Container::throwSiteMissing_(const int & siteId) const {
+    throw invalid_argument("Site " + to_string(siteId) + " is not stored in "
+        "the container.");
+  }
+
   void Site_Container::addSite(Site& site){
-    if(sites_.count(site.getId())){
+    if(index_of_site_.count(site.getId())){
       throw invalid_argument("Cannot add site it has already been added.");
     }
-    sites_[site.getId()] = site;
+    index_of_site_[site.getId()] = static_cast<int>(sites_.size());
+    sites_.push_back(site);
+    // The lookup table is no longer complete
+    index_lookup_.clear();
   }
 
   void Site_Container::addSites(vector<Site>& sites){
@@ -18,18 +29,39 @@ namespace mythical {
     }
   }
 
-  Site& Site_Container::getSite(const int & siteId){
-    if(sites_.count(siteId)==0){
-      throw invalid_argument("Site is not stored in the container.");
+  bool Site_Container::buildIndexLookupTable(){
+    index_lookup_.clear();
+    if(sites_.size()==0) return false;
+
+    auto min_max = minmax_element(index_of_site_.begin(),index_of_site_.end(),
+        [](const pair<const int,int> & lhs, const pair<const int,int> & rhs){
+          return lhs.first < rhs.first;
+        });
+    const long min_id = min_max.first->first;
+    const long max_id = min_max.second->first;
+    const long range = max_id - min_id + 1;
+
+    // Only worth it if the ids are reasonably compact, this keeps the table
+    // smaller than the hash map it replaces
+    if(range > 4*static_cast<long>(sites_.size()) + 64) return false;
+
+    min_site_id_ = min_id;
+    index_lookup_.assign(static_cast<size_t>(range),constants::unassignedId);
+    for( const pair<const int,int> & id_and_index : index_of_site_ ){
+      index_lookup_[id_and_index.first - min_site_id_] = id_and_index.second;
     }
-    return sites_[siteId];
+    return true;
+  }
+
+  Site& Site_Container::getSite(const int & siteId){
+    return sites_[getIndex(siteId)];
   }
 
   unordered_map<int,Site> Site_Container::getSites(vector<int> siteIds){
     unordered_map<int,Site> sites;
     for( auto siteId : siteIds ){
-      if(sites_.count(siteId)){
-        sites[siteId] = sites_[siteId];
+      if(exist(siteId)){
+        sites[siteId] = sites_[getIndex(siteId)];
       }else{
         throw invalid_argument("Site is not found in the container.");
       }
@@ -38,35 +70,30 @@ namespace mythical {
   }
 
   unordered_map<int,Site> Site_Container::getSites(){
-    return sites_;
-  } 
+    unordered_map<int,Site> sites;
+    for( const Site & site : sites_ ){
+      sites[site.getId()] = site;
+    }
+    return sites;
+  }
 
   void Site_Container::setClusterId(int siteId, int clusterId){
-    if(sites_.count(siteId)==0){
-      throw invalid_argument("Site is not stored in the container.");
-    }
-    sites_[siteId].setClusterId(clusterId);
+    sites_[getIndex(siteId)].setClusterId(clusterId);
   }
 
   int Site_Container::getClusterIdOfSite(int siteId) {
-    if(sites_.count(siteId)==0){
-      throw invalid_argument("Site is not stored in the container.");
-    }
-    return sites_[siteId].getClusterId();
+    return sites_[getIndex(siteId)].getClusterId();
   }
 
   bool Site_Container::partOfCluster(int siteId){
-    if(sites_.count(siteId)==0){
-      throw invalid_argument("Site is not stored in the container.");
-    }
-    return sites_[siteId].partOfCluster();
+    return sites_[getIndex(siteId)].partOfCluster();
   }
 
   int Site_Container::getSmallestClusterId(vector<int> siteIds){
     LOG("Getting the favored cluster Id", 1);
     int favoredClusterId = constants::unassignedId;
     for (auto siteId : siteIds) {
-      int clusterId = sites_[siteId].getClusterId();
+      int clusterId = sites_[getIndex(siteId)].getClusterId();
       if (favoredClusterId == constants::unassignedId) {
         favoredClusterId = clusterId;
       } else if (clusterId != constants::unassignedId &&
@@ -78,35 +105,23 @@ namespace mythical {
   }
 
   bool Site_Container::exist(const int & siteId) const{
-    return sites_.count(siteId)!=0;
+    return index_of_site_.count(siteId)!=0;
   }
-  
+
   bool Site_Container::isOccupied(const int & siteId){
-    if(sites_.count(siteId)==0){
-      throw invalid_argument("Cannot determine if site is occupied as it is not"
-          " stored in the container");
-    }
-    return sites_[siteId].isOccupied();
+    return sites_[getIndex(siteId)].isOccupied();
   }
 
   void Site_Container::vacate(const int & siteId){
-    if(sites_.count(siteId)==0){
-      throw invalid_argument("Cannot vacate as site is not stored in the "
-          "container.");
-    }
-    sites_[siteId].vacate();
+    sites_[getIndex(siteId)].vacate();
   }
 
   void Site_Container::occupy(const int & siteId){
-    if(sites_.count(siteId)==0){
-      throw invalid_argument("Cannot occupy site as it is not stored in the "
-          "container.");
-    }
-    sites_[siteId].occupy();
+    sites_[getIndex(siteId)].occupy();
   }
 /*
   Rate_Map Site_Container::getInternalRates(vector<int> siteIds){
-    
+
   }
 
   Rate_Map Site_Container::getExternalRates(vector<int> siteIds){
@@ -115,8 +130,9 @@ namespace mythical {
 */
   vector<int> Site_Container::getSiteIds(){
     vector<int> siteIds;
-    for(auto site : sites_ ){
-      siteIds.push_back(site.first);
+    siteIds.reserve(sites_.size());
+    for(const Site & site : sites_ ){
+      siteIds.push_back(site.getId());
     }
     return siteIds;
   }
@@ -142,51 +158,30 @@ namespace mythical {
   }
 */
   double Site_Container::getDwellTime(int siteId){
-    if(sites_.count(siteId)==0){
-      throw invalid_argument("Cannot get site dwell time as site is not in the "
-          "container.");
-    }
-    return sites_[siteId].getDwellTime(constants::unassignedId);
+    return sites_[getIndex(siteId)].getDwellTime(constants::unassignedId);
   }
 
   double Site_Container::getTimeConstant(int siteId){
-    if(sites_.count(siteId)==0){
-      throw invalid_argument("Cannot get site time constant as site is not in "
-          "the container.");
-    }
-    return sites_[siteId].getTimeConstant();
+    return sites_[getIndex(siteId)].getTimeConstant();
   }
 
-  Rate_Map Site_Container::getRates(){
-    Rate_Map rate_map;
-    for( auto site : sites_ ){
-      auto rates = site.second.getNeighborsAndRates();
-      rate_map[site.first] = rates;
+  unordered_map<int,unordered_map<int,double>> Site_Container::getRates(){
+    unordered_map<int,unordered_map<int,double>> rate_map;
+    for( const Site & site : sites_ ){
+      rate_map[site.getId()] = site.getNeighborsAndRates();
     }
     return rate_map;
   }
 
   double Site_Container::getFastestRateOffSite(int siteId){
-    if(sites_.count(siteId)==0){
-      throw invalid_argument("Cannot get fastest rate off site as it is not "
-          "stored in the container.");
-    }
-    return sites_[siteId].getFastestRate();
+    return sites_[getIndex(siteId)].getFastestRate();
   }
 
   double Site_Container::getRateToNeighborOfSite(int siteId, int neighId){
-    if(sites_.count(siteId)==0){
-      throw invalid_argument("Cannot get rate from site to neighbor as site is "
-          "not stored in the container");
-    }
-    return sites_[siteId].getRateToNeighbor(neighId);    
+    return sites_[getIndex(siteId)].getRateToNeighbor(neighId);
   }
 
   vector<int> Site_Container::getSiteIdsOfNeighbors(int siteId){
-    if(sites_.count(siteId)==0){
-      throw invalid_argument("Cannot get neighbor site ids from site as site is "
-          "not stored in the container");
-    }
-    return sites_[siteId].getNeighborSiteIds();
+    return sites_[getIndex(siteId)].getNeighborSiteIds();
   }
 }
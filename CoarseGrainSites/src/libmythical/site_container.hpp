@@ -2,6 +2,7 @@
 #define MYTHICAL_SITE_CONTAINER_HPP
 
 #include <unordered_map>
+#include <vector>
 
 #include "log.hpp"
 #include "rate_container.hpp"
@@ -12,15 +13,69 @@ namespace mythical {
 /**
  * \brief Class is designed to store kmc sites
  *
+ * The sites are stored contiguously in a vector, each site is assigned a
+ * dense index, which is simply its position in the vector. The user facing
+ * site ids are mapped to the dense indices with a hash map, once all the sites
+ * have been added `buildIndexLookupTable` can be called. If the site ids are
+ * compact, that is they span a range that is not much larger than the number
+ * of sites, a direct lookup table is created so that converting a site id to
+ * an index no longer requires hashing.
  **/
 class Site_Container {
   public:
-    Site_Container() {};
+    Site_Container() : min_site_id_(0) {};
+
+    /**
+     * \brief Reserve memory for a known number of sites
+     *
+     * Note that adding sites may invalidate references to previously stored
+     * sites unless enough memory has been reserved.
+     **/
+    void reserve(size_t count) { sites_.reserve(count); }
 
     void addSite(Site& site);
     void addSites(std::vector<Site>& sites);
     Site& getSite(const int & siteId);
 
+    /**
+     * \brief Return a site using its dense index
+     *
+     * No bounds checking is done, the index must be between 0 and size()-1
+     **/
+    Site& getSiteByIndex(const int & index) { return sites_[index]; }
+    const Site& getSiteByIndex(const int & index) const { return sites_[index]; }
+
+    /**
+     * \brief Convert a site id to the dense index of the site
+     *
+     * Will throw an error if the site is not stored in the container.
+     **/
+    int getIndex(const int & siteId) const {
+      if(!index_lookup_.empty()){
+        const long offset = static_cast<long>(siteId) - min_site_id_;
+        if(offset >= 0 && offset < static_cast<long>(index_lookup_.size())){
+          const int index = index_lookup_[offset];
+          if(index != constants::unassignedId) return index;
+        }
+        throwSiteMissing_(siteId);
+      }
+      auto it = index_of_site_.find(siteId);
+      if(it == index_of_site_.end()) throwSiteMissing_(siteId);
+      return it->second;
+    }
+
+    /**
+     * \brief Build a direct lookup table from site id to dense index
+     *
+     * This should be called once all the sites have been added. The table is
+     * only built if the site ids are compact enough that the table does not
+     * take up more memory than the sites, otherwise the hash map is used.
+     * Adding another site will discard the table.
+     *
+     * \return true if the direct lookup table was built
+     **/
+    bool buildIndexLookupTable();
+
     std::unordered_map<int,Site> getSites(std::vector<int> siteIds);
     std::unordered_map<int,Site> getSites();
     size_t size() const {return sites_.size();}
@@ -36,18 +91,28 @@ class Site_Container {
     void vacate(const int & siteId);
     void occupy(const int & siteId);
 
-    std::vector<int> getSiteIds(); 
+    std::vector<int> getSiteIds();
     double getDwellTime(int siteId);
     double getTimeConstant(int siteId);
 
-    Rate_Map getRates();
+    std::unordered_map<int,std::unordered_map<int,double>> getRates();
 
     double getFastestRateOffSite(int siteId);
     double getRateToNeighborOfSite(int siteId, int neighId);
     std::vector<int> getSiteIdsOfNeighbors(int siteId);
   private:
-    std::unordered_map<int,Site> sites_;
+    /// Sites stored by their dense index
+    std::vector<Site> sites_;
+
+    /// Maps the site id to the dense index
+    std::unordered_map<int,int> index_of_site_;
+
+    /// Direct lookup table, index_lookup_[siteId - min_site_id_] is the dense
+    /// index or constants::unassignedId if the site does not exist
+    std::vector<int> index_lookup_;
+    long min_site_id_;
 
+    [[noreturn]] void throwSiteMissing_(const int & siteId) const;
 };
 
 }
@@ -1,8 +1,12 @@
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cmath>
+#include <limits>
 #include <random>
+#include <stdexcept>
+#include <string>
 #include <cassert>
 
 #include "cluster.hpp"
@@ -17,52 +21,48 @@ namespace mythical {
  * Constants
  ****************************************************************************/
 
-/// Cluster Id counter is used to ensure that each new cluster has a unique id
-static int clusterIdCounter = 0;
+/// Cluster Id counter is used to give each new cluster a unique id, clusters
+/// may be created on several threads at once. CoarseGrainSystem replaces the
+/// id with one from its own counter.
+static atomic<int> clusterIdCounter(0);
+
+const double Cluster::not_on_cluster_ = -numeric_limits<double>::infinity();
 
 /****************************************************************************
  * Public Facing Functions
  ****************************************************************************/
-void occupyCluster_(TopologyFeature* feature, const int& siteId){
-  Cluster * cluster = static_cast<Cluster *>(feature);
-  
-  Site & site = cluster->sitesInCluster_[siteId];
-  assert(cluster->site_visits_.count(siteId));
-  ++cluster->total_visit_freq_; 
-  site.setToOccupiedStatus(); 
-}
-
-bool isOccupiedCluster_(TopologyFeature* feature,const int& siteId){
-  auto cluster = static_cast<Cluster *>(feature);
-  assert(cluster->sitesInCluster_.count(siteId));
-  return cluster->sitesInCluster_[siteId].isOccupied();
-}
-
-void vacateCluster_(TopologyFeature* feature,const int& siteId){
-  auto cluster = static_cast<Cluster *>(feature);
-  cluster->sitesInCluster_[siteId].vacate();
-  cluster->vacate();
-}
-
-void removeWalkerCluster_(TopologyFeature * feature,const int & walker_id){
-  auto cluster = static_cast<Cluster *>(feature);
-  cluster->remaining_walker_dwell_times_.erase(walker_id);
-}
-
-Cluster::Cluster() : TopologyFeature() {
-  setId(clusterIdCounter);
-  clusterIdCounter++;
+Cluster::Cluster() :
+  TopologyFeature(),
+  remaining_walker_dwell_times_(new vector<double>) {
+  setId(clusterIdCounter++);
   iterations_ = 3;
   resolution_ = 20.0;
   total_visit_freq_ = 0;
   prev_total_visit_freq_ = 0;
   convergenceTolerance_ = 0.01;
   convergence_method_ = converge_by_iterations_per_site;
+  direct_solve_limit_ = 100;
+  method_used_ = convergence_method_;
+  solve_time_ = 0.0;
+  solve_iterations_ = 0;
+  sampling_method_ = SamplingMethod::linear;
+  escape_time_constant_ = 0.0;
+}
+
+void Cluster::occupy(const int & siteId){
+  assert(site_visits_.count(siteId));
+  ++total_visit_freq_; 
+  sitesInCluster_[siteId].setToOccupiedStatus(); 
+}
 
-  occupy_siteId_ptr_ = occupyCluster_;
-  vacate_siteId_ptr_ = vacateCluster_;
-  isOccupied_siteId_ptr_ = isOccupiedCluster_;
+void Cluster::vacate(const int & siteId){
+  sitesInCluster_[siteId].vacate();
+  vacate();
+}
 
+bool Cluster::isOccupied(const int & siteId){
+  assert(sitesInCluster_.count(siteId));
+  return sitesInCluster_[siteId].isOccupied();
 }
 
 void Cluster::addSite(Site& newSite) {
@@ -70,6 +70,7 @@ void Cluster::addSite(Site& newSite) {
       "added to the cluster");
   newSite.setClusterId(this->getId());
   sitesInCluster_[newSite.getId()] = newSite;
+  sites_to_update_.insert(newSite.getId());
 
 }
 
@@ -79,16 +80,21 @@ void Cluster::addSites(vector<Site>& newSites) {
         "added to the cluster");
     site.setClusterId(this->getId());
     sitesInCluster_[site.getId()] = site;
+    sites_to_update_.insert(site.getId());
   }
 }
 
+void Cluster::setSiteToOccupiedStatus(const int siteId) {
+  assert(sitesInCluster_.count(siteId) && "Site is not part of the cluster");
+  sitesInCluster_[siteId].setToOccupiedStatus();
+}
+
 void Cluster::updateProbabilitiesAndTimeConstant() {
 
   unordered_map<int,int> temporary_visit_frequencies = getVisitFrequencies_();
 
+  updateEscapeRatesOfChangedSites_();
   solveMasterEquation_();
-  calculateSumOfEscapeRatesFromSitesToTheirNeighbors_();
-  calculateSumOfEscapeRatesFromSitesToInternalSites_();
   calculateProbabilityHopOffInternalSite_();
   calculateProbabilityHopBetweenInternalSite_();
   calculateEscapeTimeConstant_();
@@ -101,8 +107,6 @@ void Cluster::updateProbabilitiesAndTimeConstant() {
       setVisitFrequency(temporary_visit_frequencies[site.first],site.first);
     }
   }
-  calculateInternalDwellTimes_();
-
 }
 
 unordered_map<int,int> Cluster::getVisitFrequencies_(){
@@ -141,10 +145,25 @@ double Cluster::getProbabilityOfOccupyingInternalSite(const int siteId) {
 
 void Cluster::migrateSitesFrom(Cluster& cluster) {
 
+  // Start the solver from the probabilities of both clusters, each weighted
+  // by how long a walker stays on that cluster
+  const double weight = escape_time_constant_ > constants::unassigned_value ?
+    escape_time_constant_ : 1.0;
+  const double weight_other =
+    cluster.escape_time_constant_ > constants::unassigned_value ?
+    cluster.escape_time_constant_ : 1.0;
+  for (const pair<const int,double> & site_prob : probabilityOnSite_) {
+    warm_start_probabilities_[site_prob.first] = weight*site_prob.second;
+  }
+  for (const pair<const int,double> & site_prob : cluster.probabilityOnSite_) {
+    warm_start_probabilities_[site_prob.first] = weight_other*site_prob.second;
+  }
+
   unordered_map<int,int> visits;
   for (auto& site : cluster.sitesInCluster_) {
     site.second.setClusterId(getId());
     visits[site.first] = cluster.getVisitFrequency(site.first);
+    sites_to_update_.insert(site.first);
   }
 
   move(cluster.sitesInCluster_.begin(),
@@ -154,11 +173,19 @@ void Cluster::migrateSitesFrom(Cluster& cluster) {
   // Change the cluster so that it will not be used unless sites are added 
   cluster.sitesInCluster_.clear();
   cluster.probabilityOnSite_.clear();
+  cluster.master_equation_.clear();
+  cluster.warm_start_probabilities_.clear();
+  cluster.sites_to_update_.clear();
+  cluster.sites_pointing_to_neighbor_.clear();
+  cluster.hops_to_neighbors_.clear();
   cluster.sumOfEscapeRateFromSiteToNeighbor_.clear();
+  cluster.sumOfEscapeRateFromSiteToInternalSite_.clear();
   cluster.site_visits_.clear();
   cluster.internal_dwell_time_.clear();
   cluster.probabilityHopToNeighbor_.clear();
-  cluster.cumulitive_probabilityHopToNeighbor_.clear();
+  cluster.neighbor_sampler_.clear();
+  cluster.probabilityHopToInternalSite_.clear();
+  cluster.internal_site_sampler_.clear();
   cluster.escape_time_constant_ = constants::unassigned_value;
   cluster.internal_time_constant_ = constants::unassigned_value;
 
@@ -173,7 +200,7 @@ void Cluster::migrateSitesFrom(Cluster& cluster) {
 
 int Cluster::pickNewSiteId(const int & walker_id) {
   if (hopWithinCluster_(walker_id)) {
-    return pickInternalSite_();
+    return pickInternalSite_(walker_id);
   }
   return pickClusterNeighbor_(walker_id);
 }
@@ -202,14 +229,29 @@ void Cluster::setConvergenceIterations(long iterations) {
   iterations_ = iterations;
 }
 
+void Cluster::setDirectSolveLimit(const int number_of_sites) {
+  assert(number_of_sites>=0 && "direct solve limit cannot be negative.");
+  direct_solve_limit_ = number_of_sites;
+}
+
 double Cluster::getDwellTime(const int & walker_id) {
   assert(escape_time_constant_!=constants::unassigned_value && "Cannot get "
       "dwell time of the cluster as the escape_time_constant is not defined.");
-  if(remaining_walker_dwell_times_.count(walker_id)==0){
-    remaining_walker_dwell_times_[walker_id]=TopologyFeature::getDwellTime(walker_id);
+  auto & dwell_times = *remaining_walker_dwell_times_;
+  // A negative id converts to a large size and is caught here as well
+  if(static_cast<size_t>(walker_id) >= dwell_times.size()){
+    if(walker_id < 0 || walker_id > constants::max_walker_id){
+      throw invalid_argument("Cannot get the dwell time of walker " +
+          to_string(walker_id) + " walker ids must lie between 0 and " +
+          to_string(constants::max_walker_id) + ".");
+    }
+    dwell_times.resize(walker_id+1,not_on_cluster_);
   }
-  auto dwell_time = remaining_walker_dwell_times_[walker_id];
-  remaining_walker_dwell_times_[walker_id]-=time_increment_;
+  if(dwell_times[walker_id]==not_on_cluster_){
+    dwell_times[walker_id]=TopologyFeature::getDwellTime(walker_id);
+  }
+  auto dwell_time = dwell_times[walker_id];
+  dwell_times[walker_id]-=time_increment_;
 
   if(dwell_time>time_increment_){
     return time_increment_;
@@ -295,11 +337,14 @@ unordered_map<int, unordered_map<int, double>>
 
   unordered_map<int, unordered_map<int, double>> externalRates;
 
-  for (auto site : sitesInCluster_) {
-    for (auto neighId : site.second.getNeighborSiteIds()) {
+  for (const pair<const int,Site> & site : sitesInCluster_) {
+    const RateGraph & graph = site.second.getRateGraph();
+    const int row = site.second.getRateGraphRow();
+    const int end = graph.getRowEnd(row);
+    for (int entry = graph.getRowBegin(row); entry < end; ++entry) {
+      const int neighId = graph.getNeighborId(entry);
       if (!siteIsInCluster(neighId)) {
-        externalRates[site.first][neighId] =
-            site.second.getRateToNeighbor(neighId);
+        externalRates[site.first][neighId] = graph.getRate(entry);
       }
     }
   }
@@ -311,99 +356,126 @@ Cluster::getRatesBetweenInternalSites_() {
 
   unordered_map<int, unordered_map<int,double>> internal_rates;
 
-  for (auto site : sitesInCluster_ ){
-    for( auto neighId : site.second.getNeighborSiteIds()){
+  for (const pair<const int,Site> & site : sitesInCluster_ ){
+    const RateGraph & graph = site.second.getRateGraph();
+    const int row = site.second.getRateGraphRow();
+    const int end = graph.getRowEnd(row);
+    for (int entry = graph.getRowBegin(row); entry < end; ++entry) {
+      const int neighId = graph.getNeighborId(entry);
       if(siteIsInCluster(neighId)){
-        internal_rates[site.first][neighId] = 
-          site.second.getRateToNeighbor(neighId);
+        internal_rates[site.first][neighId] = graph.getRate(entry);
       }
     }
   }
   return internal_rates;
 }
 
-void Cluster::initializeProbabilityOnSites_() {
-  for (auto site : sitesInCluster_) {
-    probabilityOnSite_[site.first] =
-        1.0 / (static_cast<double>(sitesInCluster_.size()));
-  }
-  return;
-}
-
-void Cluster::iterate_() {
+void Cluster::buildMasterEquation_() {
 
-  unordered_map<int, double> temp_probabilityOnSite;
-  // Initialize temporary probabilities
-  for(auto site : sitesInCluster_){
-    temp_probabilityOnSite[site.first] = probabilityOnSite_[site.first];
+  unordered_map<int,int> row_of_site;
+  int row = 0;
+  for (const pair<const int,Site> & site : sitesInCluster_) {
+    row_of_site[site.first] = row;
+    ++row;
   }
-  
-  double total = 0.0;
-  for (auto site : sitesInCluster_) {
-    for (auto neighsite : site.second.getNeighborSiteIds()) {
+
+  master_equation_.clear();
+  vector<pair<int,double>> sources;
+  for (const pair<const int,Site> & site : sitesInCluster_) {
+    const RateGraph & graph = site.second.getRateGraph();
+    const int graph_row = site.second.getRateGraphRow();
+    const int end = graph.getRowEnd(graph_row);
+    sources.clear();
+    double probability_of_leaving = 0.0;
+    for (int entry = graph.getRowBegin(graph_row); entry < end; ++entry) {
+      const int neighsite = graph.getNeighborId(entry);
       if (siteIsInCluster(neighsite)) {
-        temp_probabilityOnSite[site.first] +=
-          sitesInCluster_[neighsite].getProbabilityOfHoppingToNeighboringSite(site.first) *
-          probabilityOnSite_[neighsite];
+        sources.push_back(pair<int,double>(row_of_site[neighsite],
+          sitesInCluster_[neighsite].getProbabilityOfHoppingToNeighboringSite(site.first)));
       }
-      temp_probabilityOnSite[site.first] -=
-        sitesInCluster_[site.first].getProbabilityOfHoppingToNeighboringSite(neighsite) *
-        probabilityOnSite_[site.first];
+      probability_of_leaving += graph.getRate(entry)/graph.getSumOfRates(graph_row);
     }
-    total += temp_probabilityOnSite[site.first];
-  }
-
-  // Combine the former probability with the presently calculated probability
-  double total2 = 0.0;
-  double inverse_total = 1.0/total;
-  for (auto site : sitesInCluster_) {
-    probabilityOnSite_[site.first] =
-        (temp_probabilityOnSite[site.first]*inverse_total +
-         probabilityOnSite_[site.first]) * 0.5;;
-
-    total2 += probabilityOnSite_[site.first];
-  }
-
-  // Normalize the probability
-  double inverse_total2 = 1.0/total2;
-  for (auto site : sitesInCluster_) {
-    probabilityOnSite_[site.first] = probabilityOnSite_[site.first]*inverse_total2;
+    master_equation_.addRow(sources,1.0-probability_of_leaving);
   }
 }
 
 void Cluster::solveMasterEquation_() {
 
-  initializeProbabilityOnSites_();
+  auto start = chrono::steady_clock::now();
+
+  buildMasterEquation_();
+  initializeMasterEquation_();
+
+  method_used_ = convergence_method_;
+  if (method_used_ == converge_automatically) {
+    if (static_cast<int>(sitesInCluster_.size()) <= direct_solve_limit_) {
+      method_used_ = converge_by_direct_solve;
+    } else {
+      method_used_ = converge_by_accelerated_iterations;
+    }
+  }
 
-  if (convergence_method_ == converge_by_iterations_per_cluster) {
+  if (method_used_ == converge_by_iterations_per_cluster) {
     for (long i = 0; i < iterations_; i++) {
-      iterate_();
+      master_equation_.sweep();
     }
-  } else if (convergence_method_ == converge_by_iterations_per_site) {
+    solve_iterations_ = iterations_;
+  } else if (method_used_ == converge_by_iterations_per_site) {
 
     long total_iterations =
         iterations_ * static_cast<long>(sitesInCluster_.size());
 
     for (long i = 0; i < total_iterations; i++) {
-      iterate_();
+      master_equation_.sweep();
     }
+    solve_iterations_ = total_iterations;
+  } else if (method_used_ == converge_by_direct_solve) {
+    solve_iterations_ = master_equation_.solveDirect(convergenceTolerance_);
+  } else if (method_used_ == converge_by_accelerated_iterations) {
+    solve_iterations_ =
+        master_equation_.sweepUntilConvergedAccelerated(convergenceTolerance_);
   } else {
-    double error = convergenceTolerance_ * 1.1;
-
-    while (error > convergenceTolerance_) {
-      auto oldSiteProbs = probabilityOnSite_;
-      iterate_();
-      error = 0.0;
-      for (auto site : oldSiteProbs) {
-        auto diff = oldSiteProbs[site.first] - probabilityOnSite_[site.first];
-        error += pow(diff, 2.0);
-      }
-      error = pow(error, 1.0 / 2.0);
-    }
+    solve_iterations_ = master_equation_.sweepUntilConverged(convergenceTolerance_);
+  }
+
+  solve_time_ = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+
+  const vector<double> & probabilities = master_equation_.getProbabilities();
+  int row = 0;
+  for (const pair<const int,Site> & site : sitesInCluster_) {
+    probabilityOnSite_[site.first] = probabilities[row];
+    ++row;
   }
   calculateProbabilityHopToInternalSite_();
   calculateProbabilityHopToNeighbors_();
-  calculateInternalDwellTimes_();
+}
+
+void Cluster::initializeMasterEquation_() {
+
+  const bool solved_before = escape_time_constant_ > constants::unassigned_value;
+  bool warm = false;
+  vector<double> initial;
+  initial.reserve(sitesInCluster_.size());
+  for (const pair<const int,Site> & site : sitesInCluster_) {
+    auto warm_it = warm_start_probabilities_.find(site.first);
+    auto prob_it = probabilityOnSite_.find(site.first);
+    if (warm_it != warm_start_probabilities_.end()) {
+      initial.push_back(warm_it->second);
+      warm = true;
+    } else if (solved_before && prob_it != probabilityOnSite_.end()) {
+      initial.push_back(escape_time_constant_*prob_it->second);
+      warm = true;
+    } else {
+      initial.push_back(site.second.getTimeConstant());
+    }
+  }
+  warm_start_probabilities_.clear();
+
+  if (warm) {
+    master_equation_.initializeProbabilities(initial);
+  } else {
+    master_equation_.initializeProbabilities();
+  }
 }
 
 
@@ -412,11 +484,14 @@ unordered_map<int, vector<pair<int, double>>>
 
   unordered_map<int, vector<pair<int, double>>> internalRates;
 
-  for (auto site : sitesInCluster_) {
-    for (auto neighId : site.second.getNeighborSiteIds()) {
+  for (const pair<const int,Site> & site : sitesInCluster_) {
+    const RateGraph & graph = site.second.getRateGraph();
+    const int row = site.second.getRateGraphRow();
+    const int end = graph.getRowEnd(row);
+    for (int entry = graph.getRowBegin(row); entry < end; ++entry) {
+      const int neighId = graph.getNeighborId(entry);
       if (siteIsInCluster(neighId)) {
-        auto rateToNeigh = site.second.getRateToNeighbor(neighId);
-        pair<int, double> rateToSite(site.first, rateToNeigh);
+        pair<int, double> rateToSite(site.first, graph.getRate(entry));
         internalRates[neighId].push_back(rateToSite);
       }
     }
@@ -424,36 +499,39 @@ unordered_map<int, vector<pair<int, double>>>
   return internalRates;
 }
 
+void Cluster::forgetWalker_(const int & walker_id) {
+  auto & dwell_times = *remaining_walker_dwell_times_;
+  if(static_cast<size_t>(walker_id) < dwell_times.size()){
+    dwell_times[walker_id] = not_on_cluster_;
+  }
+}
+
 bool Cluster::hopWithinCluster_(const int & walker_id) const {
-  assert(remaining_walker_dwell_times_.count(walker_id) && "Walker is not "
-      "found within the cluster and does not have a dwell time, error in "
-      "hopWithinCluster function call. Make sure you call getDwellTime first.");
-  return remaining_walker_dwell_times_.at(walker_id)>0;
+  assert(walker_id < static_cast<int>(remaining_walker_dwell_times_->size()) &&
+      (*remaining_walker_dwell_times_)[walker_id]!=not_on_cluster_ &&
+      "Walker is not found within the cluster and does not have a dwell time, "
+      "error in hopWithinCluster function call. Make sure you call "
+      "getDwellTime first.");
+  return (*remaining_walker_dwell_times_)[walker_id]>0;
 }
 
 int Cluster::pickClusterNeighbor_(const int & walker_id) {
-  remaining_walker_dwell_times_.erase(walker_id);
+  (*remaining_walker_dwell_times_)[walker_id] = not_on_cluster_;
 
-  double number = random_distribution_(random_engine_);
-  for (const pair<int,double> & pval : cumulitive_probabilityHopToNeighbor_) {
-    if (number < pval.second) return pval.first;
-  }
-  assert("Cummulitive probability distribution is flawed or random "
-      "number is greater than 1");
-  return -1;
+  double number = drawRandomNumber_(walker_id);
+  const int index = neighbor_sampler_.sample(number);
+  assert(index!=-1 && "The cluster does not have any neighbors to hop to");
+  if(index==-1) return -1;
+  return probabilityHopToNeighbor_[index].first;
 }
 
-int Cluster::pickInternalSite_() {
+int Cluster::pickInternalSite_(const int & walker_id) {
 
-  double number = random_distribution_(random_engine_);
-  for (const pair<int,double> & pval : cumulitive_probabilityHopToInternalSite_) {
-    if (number < pval.second) {
-      return pval.first;
-    }
-  }
-  assert("cumulitive probability distribution of sites in the cluster "
-    "is flawed or random number is greater than 1");
-  return -1;
+  double number = drawRandomNumber_(walker_id);
+  const int index = internal_site_sampler_.sample(number);
+  assert(index!=-1 && "The cluster does not contain any sites to hop to");
+  if(index==-1) return -1;
+  return probabilityHopToInternalSite_[index].first;
 }
 
 void Cluster::calculateProbabilityHopOffInternalSite_() {
@@ -461,12 +539,9 @@ void Cluster::calculateProbabilityHopOffInternalSite_() {
   probabilityHopOffInternalSite_.clear();
   assert(sitesInCluster_.size()>1 && "Cannot create a cluster from a single site");
 
-  auto ratesToNeighbors = getRatesToNeighborsOfCluster_();
   auto sum_rates_off = 0.0;
-  for(auto site_to_neigh : ratesToNeighbors){
-    for(auto rate : site_to_neigh.second ){
-      sum_rates_off+=rate.second;
-    }
+  for(auto site_rate : sumOfEscapeRateFromSiteToNeighbor_){
+    sum_rates_off+=site_rate.second;
   }
   auto sum_time_constants = 0.0;
   for(auto site_prob : probabilityOnSite_) {
@@ -490,19 +565,13 @@ void Cluster::calculateProbabilityHopBetweenInternalSite_() {
   probabilityHopBetweenInternalSite_.clear();
   assert(sitesInCluster_.size()>1 && "Cannot create a cluster from a single site");
 
-  auto ratesBetweenSites = getRatesBetweenInternalSites_();
-
   unordered_map<int,double> sum_sites_prob_to_hop;
   double sum_internal = 0.0;
 
   // rate_1 to 2 / sum( rate_1 to j) is the same as rate_1 to 2 * dwell_1
-  for(auto site_to_site : ratesBetweenSites){
-    int site_id = site_to_site.first;
-    double sum_internal_rates = 0.0;
-
-    for(auto internal_neigh : site_to_site.second){
-      sum_internal_rates+=internal_neigh.second;
-    }
+  for(auto site_rate : sumOfEscapeRateFromSiteToInternalSite_){
+    int site_id = site_rate.first;
+    double sum_internal_rates = site_rate.second;
     sum_sites_prob_to_hop[site_id] = sum_internal_rates*sitesInCluster_[site_id].getTimeConstant();
     probabilityHopBetweenInternalSite_[site_id] = sum_sites_prob_to_hop[site_id]*probabilityOnSite_[site_id];
     sum_internal+=probabilityHopBetweenInternalSite_[site_id]; 
@@ -515,48 +584,65 @@ void Cluster::calculateProbabilityHopBetweenInternalSite_() {
   
 }
 
-// Calculates the sum of the rates off of each site that is in the cluster to
-// sites external to the cluster
-void Cluster::calculateSumOfEscapeRatesFromSitesToTheirNeighbors_() {
+void Cluster::updateEscapeRatesOfChangedSites_() {
 
-  auto ratesToNeighbors = getRatesToNeighborsOfCluster_();
-
-  unordered_map<int, double> temp;
+  // Sites already in the cluster that have a rate to one of the added sites
+  unordered_set<int> changed_sites = sites_to_update_;
+  for (const int & siteId : sites_to_update_) {
+    auto it = sites_pointing_to_neighbor_.find(siteId);
+    if (it != sites_pointing_to_neighbor_.end()) {
+      changed_sites.insert(it->second.begin(),it->second.end());
+      sites_pointing_to_neighbor_.erase(it);
+    }
+  }
 
-  for (auto site : ratesToNeighbors) {
-    auto site_id_source = site.first;
-    for (auto neigh_terminate_rate : site.second) {
-      if (temp.count(site_id_source)==0) {
-        temp[site_id_source] = neigh_terminate_rate.second;
+  for (const int & siteId : changed_sites) {
+    const bool added = sites_to_update_.count(siteId)!=0;
+    const Site & site = sitesInCluster_.at(siteId);
+    const RateGraph & graph = site.getRateGraph();
+    const int row = site.getRateGraphRow();
+    const int end = graph.getRowEnd(row);
+    vector<pair<int,double>> & hops = hops_to_neighbors_[siteId];
+    hops.clear();
+    double sum_rates_to_neighbors = 0.0;
+    double sum_rates_to_internal_sites = 0.0;
+    bool has_neighbor = false;
+    bool has_internal_site = false;
+    for (int entry = graph.getRowBegin(row); entry < end; ++entry) {
+      const int neighId = graph.getNeighborId(entry);
+      if (siteIsInCluster(neighId)) {
+        sum_rates_to_internal_sites += graph.getRate(entry);
+        has_internal_site = true;
       } else {
-        temp[site_id_source] += neigh_terminate_rate.second;
+        sum_rates_to_neighbors += graph.getRate(entry);
+        has_neighbor = true;
+        hops.push_back(pair<int,double>(neighId,
+              graph.getRate(entry)/graph.getSumOfRates(row)));
+        if (added) sites_pointing_to_neighbor_[neighId].push_back(siteId);
       }
     }
-  }
-  sumOfEscapeRateFromSiteToNeighbor_ = temp;
-}
-
-// Calculates the sum of the rates off of each site that is in the cluster to
-// sites internal to the cluster
-void Cluster::calculateSumOfEscapeRatesFromSitesToInternalSites_() {
-
-  auto ratesToInternalSites = getRatesBetweenInternalSites_();
 
-  unordered_map<int, double> temp;
-  for (auto site : ratesToInternalSites) {
-    auto site_id_source = site.first;
-    double sum_rates = 0.0;
-    for (auto site_terminate_rate : site.second) {
-      sum_rates+=site_terminate_rate.second;
+    if (has_neighbor) {
+      sumOfEscapeRateFromSiteToNeighbor_[siteId] = sum_rates_to_neighbors;
+    } else {
+      sumOfEscapeRateFromSiteToNeighbor_.erase(siteId);
+      hops_to_neighbors_.erase(siteId);
+    }
+    if (has_internal_site) {
+      sumOfEscapeRateFromSiteToInternalSite_[siteId] = sum_rates_to_internal_sites;
+      internal_dwell_time_[siteId] = 1.0/sum_rates_to_internal_sites;
+    } else {
+      sumOfEscapeRateFromSiteToInternalSite_.erase(siteId);
+      internal_dwell_time_.erase(siteId);
     }
-    temp[site_id_source] += sum_rates;
   }
-  sumOfEscapeRateFromSiteToInternalSite_ = temp;
+  sites_to_update_.clear();
 }
+
 // Requires that calculateProbabilityHopOffInternalSites has first been called
 void Cluster::calculateEscapeTimeConstant_() {
   escape_time_constant_ = 0.0;
-  if(getRatesToNeighborsOfCluster_().size()==0){
+  if(sumOfEscapeRateFromSiteToNeighbor_.empty()){
     escape_time_constant_ = constants::unassigned_value;
   }else{
     for( auto site_prob : probabilityHopOffInternalSite_ ){
@@ -566,11 +652,11 @@ void Cluster::calculateEscapeTimeConstant_() {
       }
     }
   }
-  time_increment_ = TopologyFeature::escape_time_constant_/resolution_;
+  time_increment_ = escape_time_constant_/resolution_;
 }
 void Cluster::calculateInternalTimeConstant_() {
   internal_time_constant_ = 0.0;
-  if(getRatesBetweenInternalSites_().size()==0){
+  if(sumOfEscapeRateFromSiteToInternalSite_.empty()){
     internal_time_constant_ = constants::unassigned_value;
   }else{
     for( auto site_prob : probabilityHopBetweenInternalSite_  ){
@@ -607,12 +693,12 @@ void Cluster::calculateProbabilityHopToInternalSite_() {
         return x.second>y.second;
       });
 
-  total = 0.0;
-  for(pair<int,double> site_and_prob : probabilityHopToInternalSite_){
-    site_and_prob.second+=total;
-    total = site_and_prob.second;
-    cumulitive_probabilityHopToInternalSite_.push_back(site_and_prob);
+  vector<double> probabilities;
+  probabilities.reserve(probabilityHopToInternalSite_.size());
+  for(const pair<int,double> & site_and_prob : probabilityHopToInternalSite_){
+    probabilities.push_back(site_and_prob.second);
   }
+  internal_site_sampler_.build(probabilities,sampling_method_);
 }
 
 // requires master equation convergence as it uses probabilityOnSite_
@@ -621,18 +707,19 @@ void Cluster::calculateProbabilityHopToNeighbors_() {
   probabilityHopToNeighbor_.clear();
   unordered_map<int, double> temp_probabilityHopToNeighbor;
 
-  for (auto site : sitesInCluster_) {
-    for (auto neighsite : site.second.getNeighborSiteIds()) {
-      if (!siteIsInCluster(neighsite)) {
-        if(temp_probabilityHopToNeighbor.count(neighsite)){
-          temp_probabilityHopToNeighbor[neighsite] +=
-            sitesInCluster_[site.first].getProbabilityOfHoppingToNeighboringSite(neighsite) *
-            probabilityOnSite_[site.first];
-        }else{
-          temp_probabilityHopToNeighbor[neighsite] =
-            sitesInCluster_[site.first].getProbabilityOfHoppingToNeighboringSite(neighsite) *
-            probabilityOnSite_[site.first];
-        }
+  // Every probability on a site changes with each solve, but only the hops
+  // off of the cluster are visited rather than the full rows of the sites
+  for (const pair<const int,Site> & site : sitesInCluster_) {
+    auto hops_it = hops_to_neighbors_.find(site.first);
+    if (hops_it == hops_to_neighbors_.end()) continue;
+    const double probability_on_site = probabilityOnSite_[site.first];
+    for (const pair<int,double> & hop : hops_it->second) {
+      if(temp_probabilityHopToNeighbor.count(hop.first)){
+        temp_probabilityHopToNeighbor[hop.first] +=
+          hop.second * probability_on_site;
+      }else{
+        temp_probabilityHopToNeighbor[hop.first] =
+          hop.second * probability_on_site;
       }
     }
   }
@@ -659,24 +746,12 @@ void Cluster::calculateProbabilityHopToNeighbors_() {
         return x.second>y.second;
       });
 
-  total = 0.0;
-  for(pair<int,double>  site_and_prob : probabilityHopToNeighbor_){
-    site_and_prob.second+=total;
-    total = site_and_prob.second;
-    cumulitive_probabilityHopToNeighbor_.push_back(site_and_prob);
-  }
-}
-
-void Cluster::calculateInternalDwellTimes_(){
-  auto internal_rates = getRatesBetweenInternalSites_();
-
-  for (auto rate_to_neigh : internal_rates) {
-    double sum_internal_site_rates = 0.0;
-    for (auto rate : rate_to_neigh.second) {
-      sum_internal_site_rates += rate.second;
-    }
-    internal_dwell_time_[rate_to_neigh.first] = 1.0/sum_internal_site_rates;
+  vector<double> probabilities;
+  probabilities.reserve(probabilityHopToNeighbor_.size());
+  for(const pair<int,double> & site_and_prob : probabilityHopToNeighbor_){
+    probabilities.push_back(site_and_prob.second);
   }
+  neighbor_sampler_.build(probabilities,sampling_method_);
 }
 
 
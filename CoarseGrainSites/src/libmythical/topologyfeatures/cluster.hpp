@@ -7,9 +7,12 @@
 #include <random>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "topology_feature.hpp"
 #include "site.hpp"
+#include "libmythical/discrete_sampler.hpp"
+#include "libmythical/master_equation_solver.hpp"
 
 namespace mythical {
 
@@ -80,11 +83,33 @@ class Cluster : public TopologyFeature {
    * chosen convergence of the master equation continues for an unspecified
    * number of iterations but until the maximum difference of the sites
    * probabilities is less than the tolerance.
+   *
+   * converge_by_direct_solve
+   *
+   * Uses the tolerance. The probabilities are found with dense LU
+   * factorizations of the transition matrix of the cluster, which takes only
+   * a few factorizations regardless of how stiff the rates are, but the cost
+   * of each grows with the cube of the number of sites.
+   *
+   * converge_by_accelerated_iterations
+   *
+   * Uses the tolerance. Same as converge_by_tolerance but the probabilities
+   * are extrapolated every third iteration, reducing the number of
+   * iterations needed when the rates within the cluster differ greatly.
+   *
+   * converge_automatically
+   *
+   * Uses the tolerance. Clusters with up to the direct solve limit of sites
+   * use converge_by_direct_solve, larger clusters use
+   * converge_by_accelerated_iterations.
    **/
   enum Method {
     converge_by_iterations_per_cluster,
     converge_by_iterations_per_site,
-    converge_by_tolerance
+    converge_by_tolerance,
+    converge_by_direct_solve,
+    converge_by_accelerated_iterations,
+    converge_automatically
   };
 
   /**
@@ -99,6 +124,13 @@ class Cluster : public TopologyFeature {
   void addSite(Site& site);
   void addSites(std::vector<Site>& sites);
 
+  /**
+   * \brief Mark a site of the cluster as occupied without counting a visit
+   *
+   * Used when the cluster is formed around a site a walker is sitting on.
+   **/
+  void setSiteToOccupiedStatus(const int siteId);
+
   /**
    * \brief will update the probabilities and time constant stored in the
    * cluster
@@ -179,7 +211,7 @@ class Cluster : public TopologyFeature {
     // Must be greater than 1
     assert(resolution>=2.0); 
     resolution_ = resolution; 
-    time_increment_ = TopologyFeature::escape_time_constant_/static_cast<double>(resolution_);
+    time_increment_ = escape_time_constant_/static_cast<double>(resolution_);
   }
 
   double getResolution() const {
@@ -202,6 +234,18 @@ class Cluster : public TopologyFeature {
   int pickNewSiteId(const int & walker_id);
   //int pickNewSiteId();
 
+  /**
+   * \brief Set how the next site is picked
+   *
+   * Takes effect the next time the probabilities are updated. The method is
+   * resolved separately for the sites inside the cluster and the sites
+   * neighboring it, so automatic may use a different method for each.
+   **/
+  void setSamplingMethod(const SamplingMethod sampling_method) {
+    sampling_method_ = sampling_method;
+  }
+  SamplingMethod getSamplingMethod() const { return sampling_method_; }
+
   /**
    * \brief Set the convergence method
    *
@@ -244,6 +288,32 @@ class Cluster : public TopologyFeature {
    **/
   long getConvergenceIterations() const { return iterations_; }
 
+  /**
+   * \brief Largest cluster, in number of sites, solved directly when the
+   * convergence method is converge_automatically
+   **/
+  void setDirectSolveLimit(const int number_of_sites);
+  int getDirectSolveLimit() const { return direct_solve_limit_; }
+
+  /**
+   * \brief Time in seconds spent solving the master equation the last time
+   * the probabilities were updated
+   **/
+  double getSolveTime() const { return solve_time_; }
+
+  /**
+   * \brief Number of iterations, or factorizations for the direct solve, used
+   * the last time the master equation was solved
+   **/
+  long getSolveIterations() const { return solve_iterations_; }
+
+  /**
+   * \brief Method used the last time the master equation was solved
+   *
+   * Never converge_automatically, it is resolved to the method picked.
+   **/
+  Method getMethodUsed() const { return method_used_; }
+
   /**
    * \brief Returns a probability of a particle moving to a neighbor
    *
@@ -259,8 +329,34 @@ class Cluster : public TopologyFeature {
   double getDwellTime(const int & walker_id);
   //double getDwellTime();
 
+  double getTimeConstant() const override { return escape_time_constant_; }
+
+  /**
+   * \brief Occupy, vacate or check a site within the cluster
+   *
+   * Occupying a site counts as a visit to the cluster, vacating a site also
+   * vacates the cluster.
+   **/
+  using TopologyFeature::occupy;
+  using TopologyFeature::vacate;
+  using TopologyFeature::isOccupied;
+  void occupy(const int & siteId) override;
+  void vacate(const int & siteId) override;
+  bool isOccupied(const int & siteId) override;
+
   double getFastestRateOffCluster();
 
+  /**
+   * \brief Share the table of remaining walker dwell times
+   *
+   * A walker can only occupy a single cluster at a time, so all the clusters
+   * of a system can share one table indexed by the walker id. By default each
+   * cluster creates its own table. Walker ids must be positive.
+   **/
+  void setWalkerDwellTimeTable(std::shared_ptr<std::vector<double>> table) {
+    remaining_walker_dwell_times_ = table;
+  }
+
   void setVisitFrequency(int frequency,const int & siteId);
   int getVisitFrequency(const int & siteId);
 
@@ -289,19 +385,40 @@ class Cluster : public TopologyFeature {
   /// Type of convergence used to solve the master equation
   Method convergence_method_;
 
+  /// Largest cluster solved directly by converge_automatically
+  int direct_solve_limit_;
+
+  /// Timing of the last solve of the master equation
+  Method method_used_;
+  double solve_time_;
+  long solve_iterations_;
+
   /// Time increment of the cluster
   double time_increment_;
 
   double internal_time_constant_;
+
   /**
-   * \brief Stores the particle and its total dwell time on the cluster
+   * \brief The time constant of the cluster, dwell time constant
    *
-   * This is an internal map, the dwell time returned by getDwellTime will 
+   * This value is calcualted by considering the rates off the cluster. If
+   * all the rates off the cluster are very small the time constant will be
+   * large. It has an inverse relation with the rates off.
+   */
+  double escape_time_constant_;
+
+  /**
+   * \brief Stores the remaining dwell time of each walker on the cluster
+   *
+   * Indexed by the walker id, the dwell time returned by getDwellTime will
    * return the actual dwell time if the resolution were 1. Whenever the charge
    * has been on the cluster longer than the dwell time stored by the cluster
-   * it will then be able to hop to a site external to the cluster. 
+   * it will then be able to hop to a site external to the cluster. Walkers
+   * that are not on a cluster are marked with not_on_cluster_.
    **/
-  std::unordered_map<int,double> remaining_walker_dwell_times_;
+  std::shared_ptr<std::vector<double>> remaining_walker_dwell_times_;
+
+  static const double not_on_cluster_;
 
   /**
    * \brief Stores the probability of hopping to each of the neighbors
@@ -310,7 +427,12 @@ class Cluster : public TopologyFeature {
    * probability given as a value between 0 and 1.
    **/
   std::vector<std::pair<int, double>> probabilityHopToNeighbor_;
-  std::vector<std::pair<int, double>> cumulitive_probabilityHopToNeighbor_;
+
+  /// Picks an index of probabilityHopToNeighbor_
+  DiscreteSampler neighbor_sampler_;
+
+  /// Method used to build the samplers
+  SamplingMethod sampling_method_;
 
   /**
    * \brief Stores the internal dwell time of the sites in the cluster
@@ -357,7 +479,44 @@ class Cluster : public TopologyFeature {
   std::unordered_map<int, double> probabilityOnSite_;
 
   std::vector<std::pair<int,double>> probabilityHopToInternalSite_;
-  std::vector<std::pair<int,double>> cumulitive_probabilityHopToInternalSite_;
+
+  /// Transition matrix of the sites in the cluster, rebuilt each time the
+  /// master equation is solved
+  MasterEquationSolver master_equation_;
+
+  /**
+   * \brief Initial guess of the probabilities used the next time the master
+   * equation is solved
+   *
+   * Filled when clusters are merged, each site has the probability it had in
+   * its previous cluster weighted by the escape time constant of that cluster.
+   **/
+  std::unordered_map<int, double> warm_start_probabilities_;
+
+  /// Sites added since the escape rate tables were last updated
+  std::unordered_set<int> sites_to_update_;
+
+  /**
+   * \brief Sites within the cluster that have a rate to each neighbor of the
+   * cluster
+   *
+   * The first int is the site id of the neighbor. When the neighbor joins the
+   * cluster these are the only sites already in the cluster whose escape
+   * rates change.
+   **/
+  std::unordered_map<int, std::vector<int>> sites_pointing_to_neighbor_;
+
+  /**
+   * \brief Hops off of the cluster from each site that has any
+   *
+   * The first int is the site id of an internal site, each pair holds the id
+   * of a neighbor of the cluster and the probability of the site hopping to
+   * it. Kept up to date with the escape rate tables.
+   **/
+  std::unordered_map<int, std::vector<std::pair<int,double>>> hops_to_neighbors_;
+
+  /// Picks an index of probabilityHopToInternalSite_
+  DiscreteSampler internal_site_sampler_;
 
   /************************************************************************
    * Local Cluster Functions
@@ -370,6 +529,15 @@ class Cluster : public TopologyFeature {
   /// Will solve the Master Equation
   void solveMasterEquation_();
 
+  /**
+   * \brief Set the initial probabilities of the master equation
+   *
+   * Sites that were solved before start from their previous probabilities,
+   * new sites from their own time constant. If none of the sites have been
+   * solved before the probabilities start out equal.
+   **/
+  void initializeMasterEquation_();
+
   /**
    * \brief Picks a neighboring site of the cluster
    *
@@ -391,7 +559,7 @@ class Cluster : public TopologyFeature {
    *
    * \return the site id of a site within the cluster
    **/
-  int pickInternalSite_();
+  int pickInternalSite_(const int & walker_id);
 
   /**
      * \brief Calculates the time constant used to calculate the dwell time
@@ -433,17 +601,29 @@ class Cluster : public TopologyFeature {
     std::unordered_map<int, std::unordered_map<int, double>>
         getRatesBetweenInternalSites_();
 
-    void iterate_();
+    /**
+     * \brief Build the transition matrix of the sites in the cluster
+     *
+     * The rows of the matrix follow the order the sites are stored in.
+     **/
+    void buildMasterEquation_();
 
     void calculateProbabilityHopToNeighbors_();
     void calculateProbabilityHopToInternalSite_();
     void calculateProbabilityHopOffInternalSite_();
     void calculateProbabilityHopBetweenInternalSite_();
-    void calculateInternalDwellTimes_();
-    void calculateSumOfEscapeRatesFromSitesToTheirNeighbors_();
-    void calculateSumOfEscapeRatesFromSitesToInternalSites_();
 
-    void initializeProbabilityOnSites_();
+    /**
+     * \brief Updates the escape rates, internal dwell times and hops off of
+     * the cluster of the sites that were added and the sites they neighbor
+     *
+     * Only the rows of the changed sites are visited. The rest of an update
+     * still costs in proportion to the size of the cluster, the master
+     * equation is rebuilt from the rows of every site and the probabilities
+     * of hopping to each neighbor are summed again over every hop off of the
+     * cluster, as the probability on every site changes with each solve.
+     **/
+    void updateEscapeRatesOfChangedSites_();
 
     /**
      * \brief Will grab all the internal rates going to each site in the
@@ -467,10 +647,8 @@ class Cluster : public TopologyFeature {
     std::unordered_map<int, std::vector<std::pair<int, double>>>
         getInternalRatesFromNeighborsComingToSite_();
 
-    friend void occupyCluster_(TopologyFeature*,const int&);
-    friend void vacateCluster_(TopologyFeature*,const int&);
-    friend bool isOccupiedCluster_(TopologyFeature*,const int&);
-    friend void removeWalkerCluster_(TopologyFeature *,const int&);
+    /// Marks the walker as no longer being on the cluster
+    void forgetWalker_(const int & walker_id) override;
   };
 
 
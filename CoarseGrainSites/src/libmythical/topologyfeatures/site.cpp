@@ -1,7 +1,6 @@
 
 #include <algorithm>
 #include <chrono>
-#include <set>
 #include <utility>
 #include <cassert>
 
@@ -12,21 +11,6 @@ using namespace std;
 
 namespace mythical {
 
-  class CustomComparitor
-  {
-    public:
-      int operator()(const pair<double,int>& lhs, const pair<double,int>& rhs)
-      {
-        if(lhs.first==rhs.first){
-          return 0;
-        }
-        if(lhs.second==rhs.second){
-          return lhs.first<rhs.first;
-        }
-        return lhs.second < rhs.second;
-      }
-  };
-
 /*********************************************************************
  * Public Facing Functions
  *********************************************************************/
@@ -35,6 +19,8 @@ Site::Site()
     : TopologyFeature() {
 
   cluster_id_ = constants::unassignedId;
+  rate_graph_ = RateGraph::getEmptyGraph();
+  row_ = 0;
 }
 
 Site::~Site() {}
@@ -42,96 +28,116 @@ Site::~Site() {}
 void Site::setRatesToNeighbors(unordered_map<int, double>& neighRates) {
   assert(neighRates.size()!=0 && "Sites must have at least one rate to a "
     "neighbor. Cannot set rates to neighbors with empty map.");
-  for (auto neighAndRate : neighRates) {
+  unordered_map<int,double> rates = getNeighborsAndRates();
+  for (const pair<const int,double> & neighAndRate : neighRates) {
     assert(neighAndRate.second!=0 && "One of the rates is 0.0. You cannot "
         "set a rate to a value of 0.0 as it is meaningless.");
-    neighRates_[neighAndRate.first] = &(neighRates[neighAndRate.first]);
+    rates[neighAndRate.first] = neighAndRate.second;
   }
-  calculateDwellTimeConstant_();
-  calculateProbabilityHopToNeighbors_();
+  setRatesInOwnGraph_(rates);
 }
 
 void Site::addNeighRate(const pair<int, double*> neighRate) {
 
-  assert(neighRates_.count(neighRate.first)==0 && "That neighbor has already been added.");
-  neighRates_[neighRate.first] = neighRate.second;
-  calculateDwellTimeConstant_();
-  calculateProbabilityHopToNeighbors_();
+  assert(!isNeighbor(neighRate.first) && "That neighbor has already been added.");
+  unordered_map<int,double> rates = getNeighborsAndRates();
+  rates[neighRate.first] = *(neighRate.second);
+  setRatesInOwnGraph_(rates);
 }
 
 void Site::resetNeighRate(const pair<int, double*> neighRate) {
-  neighRates_[neighRate.first] = neighRate.second;
-  calculateDwellTimeConstant_();
-  calculateProbabilityHopToNeighbors_();
+  unordered_map<int,double> rates = getNeighborsAndRates();
+  rates[neighRate.first] = *(neighRate.second);
+  setRatesInOwnGraph_(rates);
+}
+
+void Site::setRateGraph(shared_ptr<const RateGraph> rate_graph, const int row) {
+  assert(rate_graph && row>=0 && row<rate_graph->getNumberOfRows() &&
+      "Row is not stored in the rate graph.");
+  rate_graph_ = rate_graph;
+  row_ = row;
 }
 
 vector<double> Site::getRateToNeighbors() const {
   vector<double> rates;
-  for (auto & rate : neighRates_) rates.push_back(*(rate.second));
+  rates.reserve(rate_graph_->getRowSize(row_));
+  const int end = rate_graph_->getRowEnd(row_);
+  for (int entry = rate_graph_->getRowBegin(row_); entry < end; ++entry){
+    rates.push_back(rate_graph_->getRate(entry));
+  }
   return rates;
 }
 
 double Site::getRateToNeighbor(const int & neighSiteId) const {
-  assert(neighRates_.count(neighSiteId)!=0 && "Error the site Id is not a neighbor of the site ");
-  return *(neighRates_.at(neighSiteId));
+  const int entry = rate_graph_->findEntry(row_,neighSiteId);
+  assert(entry!=constants::unassignedId && "Error the site Id is not a neighbor of the site ");
+  return rate_graph_->getRate(entry);
 }
 
 double Site::getFastestRate(){
   double rate =0.0;
-  for(auto neigh_rate: neighRates_) {
-    if(*(neigh_rate.second)>rate) rate = *(neigh_rate.second);
+  const int end = rate_graph_->getRowEnd(row_);
+  for (int entry = rate_graph_->getRowBegin(row_); entry < end; ++entry){
+    if(rate_graph_->getRate(entry)>rate) rate = rate_graph_->getRate(entry);
   }
   return rate;
 }
 
 vector<int> Site::getNeighborSiteIds() const {
   vector<int> neighborIds;
-  for (auto neighId : neighRates_) neighborIds.push_back(neighId.first);
+  neighborIds.reserve(rate_graph_->getRowSize(row_));
+  const int end = rate_graph_->getRowEnd(row_);
+  for (int entry = rate_graph_->getRowBegin(row_); entry < end; ++entry){
+    neighborIds.push_back(rate_graph_->getNeighborId(entry));
+  }
   return neighborIds;
 }
 
-int Site::pickNewSiteId(const int &) {
-  return pickNewSiteId();
+int Site::pickNewSiteId(const int & walker_id) {
+  return pickNeighbor_(drawRandomNumber_(walker_id));
 }
 
 int Site::pickNewSiteId() {
-  double number = random_distribution_(random_engine_);
-  double threshold = 0.0;
-  for (pair<int,double> & pval : probabilityHopToNeighbor_) {
-    threshold += pval.second;
-    if (number < threshold) return pval.first;
-  }
-  assert("Error cummulitive probability distribution is flawed or "
-      " the random number generator has calculated a value greater than 1, or"
-      " the site has no neighbors");
-  return -1;
+  return pickNewSiteId(0);
 }
 
-unordered_map<int,double *> Site::getNeighborsAndRates(){
-  return neighRates_;
+int Site::pickNeighbor_(const double number) const {
+  const int entry = rate_graph_->sampleRow(row_,number);
+  // Sites without any neighbors, such as drains, have nowhere to hop to
+  if(entry==constants::unassignedId) return -1;
+  return rate_graph_->getNeighborId(entry);
 }
 
-const unordered_map<int,double *> & Site::getNeighborsAndRatesConst() const{
-  return neighRates_;
+unordered_map<int,double> Site::getNeighborsAndRates() const {
+  unordered_map<int,double> rates;
+  const int end = rate_graph_->getRowEnd(row_);
+  for (int entry = rate_graph_->getRowBegin(row_); entry < end; ++entry){
+    rates[rate_graph_->getNeighborId(entry)] = rate_graph_->getRate(entry);
+  }
+  return rates;
 }
 
 double Site::getProbabilityOfHoppingToNeighboringSite(
     const int & neighSiteId) 
 {
-  assert(neighRates_.count(neighSiteId) != 0 && "Error site "
+  const int entry = rate_graph_->findEntry(row_,neighSiteId);
+  assert(entry!=constants::unassignedId && "Error site "
       " is not a neighbor ");
 
-  auto it = find_if(
-      probabilityHopToNeighbor_.begin(),
-      probabilityHopToNeighbor_.end(),
-      [&neighSiteId](const pair<int,double>& neigh_and_prob)
-      { return neighSiteId==neigh_and_prob.first; }); 
-
-  return it->second;
+  return rate_graph_->getRate(entry)/rate_graph_->getSumOfRates(row_);
 }
 
 vector<pair<int, double>> Site::getProbabilitiesAndIdsOfNeighbors() const {
-  return probabilityHopToNeighbor_;
+  vector<pair<int,double>> probabilities;
+  probabilities.reserve(rate_graph_->getRowSize(row_));
+  const double sum = rate_graph_->getSumOfRates(row_);
+  const int end = rate_graph_->getRowEnd(row_);
+  for (int entry = rate_graph_->getRowBegin(row_); entry < end; ++entry){
+    probabilities.push_back(pair<int,double>(
+          rate_graph_->getNeighborId(entry),
+          rate_graph_->getRate(entry)/sum));
+  }
+  return probabilities;
 }
 
 std::ostream& operator<<(std::ostream& os,
@@ -139,13 +145,15 @@ std::ostream& operator<<(std::ostream& os,
   os << "Site Id: " << site.getId() << endl;
   os << "Cluster Id: " << site.cluster_id_ << endl;
   os << "Total Visit Frequency: " << site.total_visit_freq_ << endl;
-  os << "Escape Time Constant: " << site.escape_time_constant_ << endl;
+  os << "Escape Time Constant: " << site.getTimeConstant() << endl;
   os << "Neighbors:Rates" << endl;
-  for (auto rate_ptr : site.neighRates_) {
-    os << "\t" << rate_ptr.first << ":" << *(rate_ptr.second) << endl;
+  const RateGraph & graph = *(site.rate_graph_);
+  const int end = graph.getRowEnd(site.row_);
+  for (int entry = graph.getRowBegin(site.row_); entry < end; ++entry) {
+    os << "\t" << graph.getNeighborId(entry) << ":" << graph.getRate(entry) << endl;
   }
   os << "Neighbors:Probability hop to them" << endl;
-  for (auto probability : site.probabilityHopToNeighbor_) {
+  for (auto probability : site.getProbabilitiesAndIdsOfNeighbors()) {
     os << "\t" << probability.first << ":" << probability.second << endl;
   }
   return os;
@@ -154,29 +162,10 @@ std::ostream& operator<<(std::ostream& os,
 /*********************************************************************
  * Private Internal Functions
  *********************************************************************/
-void Site::calculateProbabilityHopToNeighbors_() {
-  double sumRates = getSumOfRates_();
-  set<pair<int,double>,CustomComparitor> neigh_and_prob;
-  for (auto rateToNeigh : neighRates_) {
-    auto values = pair<int,double> (rateToNeigh.first,(*rateToNeigh.second) / sumRates);
-    neigh_and_prob.insert(values);
-  }
-
-  probabilityHopToNeighbor_.clear();
-  copy(neigh_and_prob.begin(),neigh_and_prob.end(),back_inserter(probabilityHopToNeighbor_));
-}
-
-void Site::calculateDwellTimeConstant_() {
-  auto sumRates = getSumOfRates_();
-  escape_time_constant_ = 1.0 / sumRates;
-}
-
-double Site::getSumOfRates_() {
-  double sum = 0.0;
-  for (auto rate : neighRates_) {
-    sum += *(rate.second);
-  }
-  return sum;
+void Site::setRatesInOwnGraph_(const unordered_map<int,double> & neighRates) {
+  shared_ptr<RateGraph> rate_graph(new RateGraph);
+  rate_graph->addRow(neighRates);
+  setRateGraph(rate_graph,0);
 }
 
 }
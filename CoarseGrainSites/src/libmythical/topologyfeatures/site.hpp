@@ -8,6 +8,7 @@
 #include <vector>
 
 #include "topology_feature.hpp"
+#include "libmythical/rate_graph.hpp"
 
 namespace mythical {
 
@@ -16,9 +17,10 @@ namespace mythical {
  *
  * This class keeps track of all information related to a site and it's
  * neighbors. It is an internal class meaning it is not meant to be used by
- * the public. It does not store rates to the neighboring sites locally, this
- * is to make it possible for an end user to alter the rates externally
- * without having to touch this class.
+ * the public. It does not store rates to the neighboring sites locally,
+ * instead it reads them from a row of a RateGraph. Within a coarse grained
+ * system every site shares the same graph. A site that is created on its own
+ * is given its own single row graph whenever rates are added to it.
  **/
 class Site : public TopologyFeature {
  public:
@@ -30,10 +32,10 @@ class Site : public TopologyFeature {
    *
    * This function does not remove any of the previously stored rates
    * however, it may very well overwrite a rate to a previously stored
-   * neighboring site.
+   * neighboring site. The rates are copied.
    *
-   * \param[in] neighRates Stores the site id of the neighbor with a pointer
-   * to the rate going to the neighboring site.
+   * \param[in] neighRates Stores the site id of the neighbor with the rate
+   * going to the neighboring site.
    **/
   void setRatesToNeighbors(std::unordered_map<int, double>& neighRates);
 
@@ -45,7 +47,8 @@ class Site : public TopologyFeature {
    * In such a case you should call resetNeighRate instead.
    *
    * \param[in] neighborRate The first int is the site id of neighboring
-   * site, this is followed by a pointer to actual rate.
+   * site, this is followed by a pointer to actual rate. The value of the rate
+   * is copied.
    **/
   void addNeighRate(const std::pair<int, double*> neighRate);
 
@@ -60,6 +63,31 @@ class Site : public TopologyFeature {
    **/
   void resetNeighRate(const std::pair<int, double*> neighRate);
 
+  /**
+   * \brief Read the rates to the neighboring sites from a row of a graph
+   *
+   * Any rates previously set on the site are discarded.
+   *
+   * \param[in] rate_graph graph shared between the sites
+   * \param[in] row the row of the graph containing the rates off this site
+   **/
+  void setRateGraph(std::shared_ptr<const RateGraph> rate_graph, const int row);
+
+  const RateGraph & getRateGraph() const { return *rate_graph_; }
+  int getRateGraphRow() const { return row_; }
+  int getNumberOfNeighbors() const { return rate_graph_->getRowSize(row_); }
+
+  /**
+   * \brief Inverse of the sum of the rates off the site, 0 if there are
+   * none
+   *
+   * Read from the graph rather than stored so the site stays small.
+   **/
+  double getTimeConstant() const override {
+    return rate_graph_->getRowSize(row_)>0 ?
+      1.0 / rate_graph_->getSumOfRates(row_) : 0.0;
+  }
+
   /**
    * \brief Is the site a neighbor
    *
@@ -70,7 +98,7 @@ class Site : public TopologyFeature {
    * \return True if it is a neighbor and False if it is not
    **/
   bool isNeighbor(const int neighSiteId) const {
-    return neighRates_.count(neighSiteId);
+    return rate_graph_->findEntry(row_,neighSiteId)!=constants::unassignedId;
   }
 
   /**
@@ -119,6 +147,7 @@ class Site : public TopologyFeature {
    * \return site id of a neigboring site
    **/
   int pickNewSiteId(const int & ) override;
+  /// Draws the number as walker 0 would
   int pickNewSiteId() override;
 
   /**
@@ -148,8 +177,7 @@ class Site : public TopologyFeature {
    **/
   double getProbabilityOfHoppingToNeighboringSite(const int & neighSiteId);
 
-  std::unordered_map<int,double *> getNeighborsAndRates();
-  const std::unordered_map<int,double *>& getNeighborsAndRatesConst() const;
+  std::unordered_map<int,double> getNeighborsAndRates() const;
 
   /**
    * \brief Gets the ids and the probabilities of hopping to neighbors
@@ -168,14 +196,15 @@ class Site : public TopologyFeature {
 
    private:
   /**
-   * \brief Contains the probability of hopping to each neighbor
+   * \brief Graph storing the rates and the cumulative probabilities of
+   * hopping to each of the neighboring sites
    **/
-  std::vector<std::pair<int, double>> probabilityHopToNeighbor_;
+  std::shared_ptr<const RateGraph> rate_graph_;
 
   /**
-   * \brief Stores pointers to the rates to each of the neighboring sites
+   * \brief Row of the rate graph belonging to this site
    **/
-  std::unordered_map<int, double*> neighRates_;
+  int row_;
 
   /**
    * \brief Stores the id of the cluster the site is a part of
@@ -183,24 +212,23 @@ class Site : public TopologyFeature {
   int cluster_id_;
 
   /**
-   * \brief Distribution to be used when picking random numbers
-   **/
-  std::uniform_real_distribution<double> randomDistribution_;
-
-  /**
-   * \brief This function calculates the probability of hopping to each
-   * neighboring site
+   * \brief Replace the rates off the site with a new single row graph
    *
-   * The probabilities are stored in the probHopToNeighbor_ map
+   * The probabilities of hopping to each neighbor are calculated by the
+   * graph.
    **/
-  void calculateProbabilityHopToNeighbors_();
+  void setRatesInOwnGraph_(const std::unordered_map<int,double> & neighRates);
 
   /**
-   * \brief Calculates the escapeTimeConstant_
+   * \brief Neighbor picked by a uniform random number, -1 if the site has
+   * no neighbors
    **/
-  void calculateDwellTimeConstant_();
+  int pickNeighbor_(const double number) const;
 
-  double getSumOfRates_();
+  /// Sites sharing seeds are seeded in the order of their rows
+  unsigned long getSeedOffset_() const override {
+    return static_cast<unsigned long>(row_);
+  }
 
 };
 
@@ -1,70 +1,128 @@
 
 #include <chrono>
+#include <utility>
 
 #include "topology_feature.hpp"
+#include "libmythical/random_numbers.hpp"
+#include "libmythical/walker_random_streams.hpp"
 
 using namespace std;
 
 namespace mythical {
 
-  void occupyTopology_(TopologyFeature* feature) {
-    ++(feature->occupied_);
-    ++(feature->total_visit_freq_);
+  TopologyFeature::TopologyFeature(){
+    owns_random_numbers_ = false;
+    seeds_engine_ = false;
+    occupied_ = 0;
+    total_visit_freq_ = 0;
+    random_numbers_ = nullptr;
   }
 
-  void occupyTopology_(TopologyFeature* feature,const int&) {
-    ++(feature->occupied_);
-    ++(feature->total_visit_freq_);
+  TopologyFeature::TopologyFeature(const TopologyFeature & feature) :
+    Identity(feature),
+    owns_random_numbers_(feature.owns_random_numbers_),
+    seeds_engine_(feature.seeds_engine_),
+    total_visit_freq_(feature.total_visit_freq_),
+    occupied_(feature.occupied_),
+    random_numbers_(feature.random_numbers_) {
+    // The copy continues from the same state of the engine
+    if(owns_random_numbers_){
+      random_numbers_ = new FeatureRandomNumbers(
+          *static_cast<FeatureRandomNumbers *>(feature.random_numbers_));
+    }
   }
 
-  void vacateTopology_(TopologyFeature* feature){
-    --(feature->occupied_);
+  TopologyFeature::TopologyFeature(TopologyFeature && feature) noexcept :
+    Identity(feature),
+    owns_random_numbers_(feature.owns_random_numbers_),
+    seeds_engine_(feature.seeds_engine_),
+    total_visit_freq_(feature.total_visit_freq_),
+    occupied_(feature.occupied_),
+    random_numbers_(feature.random_numbers_) {
+    feature.owns_random_numbers_ = false;
+    feature.seeds_engine_ = false;
+    feature.random_numbers_ = nullptr;
   }
 
-  void vacateTopology_(TopologyFeature* feature,const int&){
-    --(feature->occupied_);
+  TopologyFeature & TopologyFeature::operator=(const TopologyFeature & feature){
+    if(this != &feature){
+      Identity::operator=(feature);
+      RandomNumbers * random_numbers = feature.random_numbers_;
+      if(feature.owns_random_numbers_){
+        random_numbers = new FeatureRandomNumbers(
+            *static_cast<FeatureRandomNumbers *>(feature.random_numbers_));
+      }
+      if(owns_random_numbers_) delete random_numbers_;
+      owns_random_numbers_ = feature.owns_random_numbers_;
+      seeds_engine_ = feature.seeds_engine_;
+      total_visit_freq_ = feature.total_visit_freq_;
+      occupied_ = feature.occupied_;
+      random_numbers_ = random_numbers;
+    }
+    return *this;
   }
 
-  bool isOccupiedTopology_(TopologyFeature* feature){
-    return feature->occupied_>0;
+  TopologyFeature & TopologyFeature::operator=(TopologyFeature && feature) noexcept {
+    if(this != &feature){
+      Identity::operator=(feature);
+      if(owns_random_numbers_) delete random_numbers_;
+      owns_random_numbers_ = feature.owns_random_numbers_;
+      seeds_engine_ = feature.seeds_engine_;
+      total_visit_freq_ = feature.total_visit_freq_;
+      occupied_ = feature.occupied_;
+      random_numbers_ = feature.random_numbers_;
+      feature.owns_random_numbers_ = false;
+      feature.seeds_engine_ = false;
+      feature.random_numbers_ = nullptr;
+    }
+    return *this;
   }
 
-  bool isOccupiedTopology_(TopologyFeature* feature,const int&){
-    return feature->occupied_>0;
+  TopologyFeature::~TopologyFeature(){
+    if(owns_random_numbers_) delete random_numbers_;
   }
 
-  void removeWalker_(TopologyFeature*,const int&){
-    return;
+  void TopologyFeature::setRandomSeed(const unsigned long seed){
+    if(owns_random_numbers_) delete random_numbers_;
+    random_numbers_ = new FeatureRandomNumbers(seed);
+    owns_random_numbers_ = true;
+    seeds_engine_ = false;
   }
 
-  TopologyFeature::TopologyFeature(){
-    auto seed = chrono::system_clock::now().time_since_epoch().count();
-    random_engine_ = mt19937(seed);
-    random_distribution_ = uniform_real_distribution<double>(0.0, 1.0);
-    occupied_ = 0;
-    escape_time_constant_ = 0.0;
-    total_visit_freq_ = 0;
-  
-    occupy_ptr_ = &occupyTopology_;
-    occupy_siteId_ptr_ = &occupyTopology_;
-
-    vacate_ptr_ = &vacateTopology_;
-    vacate_siteId_ptr_ = &vacateTopology_;
-
-    isOccupied_ptr_ = &isOccupiedTopology_;
-    isOccupied_siteId_ptr_ = &isOccupiedTopology_;
+  void TopologyFeature::setFeatureSeeds(FeatureSeeds * seeds){
+    if(owns_random_numbers_) delete random_numbers_;
+    random_numbers_ = seeds;
+    owns_random_numbers_ = false;
+    seeds_engine_ = seeds != nullptr;
+  }
 
-    remove_ptr_ = &removeWalker_;
+  void TopologyFeature::setWalkerRandomStreams(WalkerRandomStreams * streams){
+    if(streams == nullptr){
+      if(!owns_random_numbers_ && !seeds_engine_) random_numbers_ = nullptr;
+      return;
+    }
+    if(owns_random_numbers_) delete random_numbers_;
+    random_numbers_ = streams;
+    owns_random_numbers_ = false;
+    seeds_engine_ = false;
   }
 
-  void TopologyFeature::setRandomSeed(const unsigned long seed){
-    random_engine_ = mt19937(seed);
+  double TopologyFeature::drawRandomNumber_(const int & walker_id){
+    if(seeds_engine_){
+      random_numbers_ = static_cast<FeatureSeeds *>(random_numbers_)->
+        createEngine(getSeedOffset_());
+      owns_random_numbers_ = true;
+      seeds_engine_ = false;
+    }else if(random_numbers_ == nullptr){
+      auto seed = chrono::system_clock::now().time_since_epoch().count();
+      setRandomSeed(static_cast<unsigned long>(seed));
+    }
+    return random_numbers_->draw(walker_id);
   }
 
-  double TopologyFeature::getDwellTime(const int & ){
-    double number = random_distribution_(random_engine_);
-    return (-1.0)*log(number) * escape_time_constant_;
+  double TopologyFeature::getDwellTime(const int & walker_id){
+    double number = drawRandomNumber_(walker_id);
+    return (-1.0)*log(number) * getTimeConstant();
   }
 
 }
-
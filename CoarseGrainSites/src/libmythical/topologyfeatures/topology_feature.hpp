@@ -13,17 +13,38 @@
 
 namespace mythical {
 
+class FeatureSeeds;
+class RandomNumbers;
+class WalkerRandomStreams;
+
 /**
  * \brief TopologyFeature Class
  *
  * This class keeps track of all information related to a feature and it's
  * neighbors. It is an internal class meaning it is not meant to be used by
  * the public. 
+ *
+ * A system can hold millions of sites so the feature is kept small, the
+ * random number engine is only created once a number is drawn, from the
+ * shared seeds if they are set, and is not created at all if the walkers
+ * draw from their own streams.
  **/
-class TopologyFeature : public virtual Identity {
+class TopologyFeature : public Identity {
 
   protected:
 
+  /**
+   * \brief Whether random_numbers_ is the engine of the feature and has to
+   * be deleted with it
+   **/
+  bool owns_random_numbers_;
+
+  /**
+   * \brief Whether random_numbers_ are the FeatureSeeds the engine of the
+   * feature is created from when it first draws
+   **/
+  bool seeds_engine_;
+
   /**
    * \brief Keeps track of the total number of time the feature has been
    * visited by a particle
@@ -38,81 +59,75 @@ class TopologyFeature : public virtual Identity {
   int occupied_;
 
   /**
-   * \brief The time constant of the feature, dwell time constant
-   *
-   * This value is calcualted by considering the rates off the feature. If all
-   * the rates off the feature are very small the time constant will be large.
-   * If the rates off are fast than the time constant will be small. It has
-   * an inverse relation with the rates off.
-   */
-  double escape_time_constant_;
-
-  /**
-   * \brief This is the random number engine
+   * \brief Where the random numbers are drawn from
    *
-   * This engine creates pseudo random numbers, it has been initialized
-   * from the time.
+   * Either a Mersenne Twister owned by the feature, seeded from the time
+   * unless a seed is set, the seeds it is created from or the streams of the
+   * walkers shared by the system.
    **/
-  std::mt19937 random_engine_;
+  RandomNumbers * random_numbers_;
+
+  /// Uniform number in [0,1) for a hop of the walker
+  double drawRandomNumber_(const int & walker_id);
 
   /**
-   * \brief Distribution to be used when picking random numbers
+   * \brief Called when a walker is removed from the system while on the
+   * feature, so that anything tracking the walker can be reset
    **/
-  std::uniform_real_distribution<double> random_distribution_;
-
-  /// Create function pointer variables
-
-  void (*occupy_ptr_)(TopologyFeature *);
-  void (*occupy_siteId_ptr_)(TopologyFeature*,const int&);
- 
-  void (*vacate_ptr_)(TopologyFeature *);
-  void (*vacate_siteId_ptr_)(TopologyFeature *,const int&);
+  virtual void forgetWalker_(const int &) {}
 
-  bool (*isOccupied_ptr_)(TopologyFeature *);
-  bool (*isOccupied_siteId_ptr_)(TopologyFeature *,const int&);
-
-  void (*remove_ptr_)(TopologyFeature *,const int &);
-
-  friend void occupyTopology_(TopologyFeature*);
-  friend void occupyTopology_(TopologyFeature*,const int&);
-
-  friend void vacateTopology_(TopologyFeature*);
-  friend void vacateTopology_(TopologyFeature*,const int&);
-
-  friend bool isOccupiedTopology_(TopologyFeature*);
-  friend bool isOccupiedTopology_(TopologyFeature*,const int&);
-
-  friend void removeWalker_(TopologyFeature*,const int&);
+  /// Added to the shared seed to seed the engine of the feature
+  virtual unsigned long getSeedOffset_() const { return 0; }
 
  public:
   TopologyFeature();
+  TopologyFeature(const TopologyFeature & feature);
+  TopologyFeature(TopologyFeature && feature) noexcept;
+  TopologyFeature & operator=(const TopologyFeature & feature);
+  TopologyFeature & operator=(TopologyFeature && feature) noexcept;
 
-  virtual ~TopologyFeature() {};
+  virtual ~TopologyFeature();
   /**
    * \brief Set the seed for the random number generator
    *
-   * By default this is initialized in the constructor from the time.
-   * However, having the ability to set it allows to reproducably test the
-   * class.
+   * By default the engine is seeded from the time when the first number is
+   * drawn. However, having the ability to set it allows to reproducably test
+   * the class. The feature stops drawing from the streams of the walkers.
    *
    * \param[in] seed a random number seed
    **/
   void setRandomSeed(const unsigned long seed);
 
+  /**
+   * \brief Seed the engine from seeds shared with other features
+   *
+   * The engine is created the first time a number is drawn, seeded with the
+   * shared seed plus the offset of the feature, a site uses its row. The
+   * seeds are owned by the caller and must outlive the feature.
+   **/
+  void setFeatureSeeds(FeatureSeeds * seeds);
+
+  /**
+   * \brief Draw the random numbers of each walker from its own stream
+   *
+   * The streams are owned by the caller and must outlive the feature, pass
+   * nullptr to go back to an engine of the feature seeded from the time.
+   **/
+  void setWalkerRandomStreams(WalkerRandomStreams * streams);
+
   /**
    * \brief Determine if site is occupied by a particle
    *
    * \return True if it is occupied, False if it is not occupied
    **/
-  bool isOccupied() { return isOccupied_ptr_(this); }
-  bool isOccupied(const int& siteId)  
-  { return isOccupied_siteId_ptr_(this,siteId); }
+  bool isOccupied() const { return occupied_>0; }
+  virtual bool isOccupied(const int&) { return isOccupied(); }
 
   /**
    * \brief Indicate that the site is no longer occupied by a particle
    **/
-  void vacate() { vacate_ptr_(this); }
-  void vacate(const int& siteId) { vacate_siteId_ptr_(this,siteId); }
+  void vacate() { --occupied_; }
+  virtual void vacate(const int&) { vacate(); }
 
   /**
    * \brief Remove a random walker from the site 
@@ -123,7 +138,7 @@ class TopologyFeature : public virtual Identity {
    **/
   void removeWalker(const int & walker_id,const int & site_id) { 
     vacate(site_id);
-    remove_ptr_(this,walker_id);
+    forgetWalker_(walker_id);
   }
 
   /**
@@ -134,10 +149,11 @@ class TopologyFeature : public virtual Identity {
    **/
 
   void occupy() { 
-    occupy_ptr_(this); 
+    ++occupied_;
+    ++total_visit_freq_;
   }
-  void occupy(const int& siteId) { 
-    occupy_siteId_ptr_(this,siteId); 
+  virtual void occupy(const int&) { 
+    occupy();
   }
 
   /**
@@ -153,7 +169,7 @@ class TopologyFeature : public virtual Identity {
    *
    * \return A double which is the dwell time
    **/
-  double getTimeConstant() const { return escape_time_constant_; }
+  virtual double getTimeConstant() const = 0;
 
   /**
    * \brief Return the hop time of the site
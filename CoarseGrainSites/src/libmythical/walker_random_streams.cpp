@@ -0,0 +1,94 @@
+
+#include <stdexcept>
+#include <string>
+
+#include "mythical/constants.hpp"
+#include "walker_random_streams.hpp"
+
+using namespace std;
+
+namespace mythical {
+
+  namespace {
+    // Constants of Philox4x32 from Salmon et al., "Parallel random numbers:
+    // as easy as 1, 2, 3", SC11
+    const uint32_t philox_multiplier_0 = 0xD2511F53;
+    const uint32_t philox_multiplier_1 = 0xCD9E8D57;
+    const uint32_t philox_key_increment_0 = 0x9E3779B9;
+    const uint32_t philox_key_increment_1 = 0xBB67AE85;
+    const int philox_rounds = 10;
+  }
+
+  double WalkerRandomStreams::draw(const int walker_id) {
+    // A negative id converts to a large size and is caught here as well
+    if(static_cast<size_t>(walker_id) >= draws_.size()){
+      if(walker_id < 0 || walker_id > constants::max_walker_id){
+        throw invalid_argument("Cannot draw a random number for walker " +
+            to_string(walker_id) + " walker ids must lie between 0 and " +
+            to_string(constants::max_walker_id) + ".");
+      }
+      draws_.resize(walker_id+1,0);
+      generations_.resize(walker_id+1,0);
+    }
+    return uniform(seed_,walker_id,draws_[walker_id]++,generations_[walker_id]);
+  }
+
+  // An id that has not drawn yet keeps its generation, nothing can repeat
+  void WalkerRandomStreams::reset(const int walker_id) {
+    if(static_cast<size_t>(walker_id) < draws_.size() && draws_[walker_id] > 0){
+      draws_[walker_id] = 0;
+      ++generations_[walker_id];
+    }
+  }
+
+  uint64_t WalkerRandomStreams::getDrawCount(const int walker_id) const {
+    if(static_cast<size_t>(walker_id) >= draws_.size()) return 0;
+    return draws_[walker_id];
+  }
+
+  uint32_t WalkerRandomStreams::getGeneration(const int walker_id) const {
+    if(static_cast<size_t>(walker_id) >= generations_.size()) return 0;
+    return generations_[walker_id];
+  }
+
+  double WalkerRandomStreams::uniform(
+      const unsigned long seed,
+      const int walker_id,
+      const uint64_t draw,
+      const uint32_t generation) {
+
+    const uint64_t seed_bits = static_cast<uint64_t>(seed);
+    const array<uint32_t,4> bits = philox(
+        {static_cast<uint32_t>(walker_id),
+         static_cast<uint32_t>(draw),
+         static_cast<uint32_t>(draw >> 32),
+         generation},
+        {static_cast<uint32_t>(seed_bits),
+         static_cast<uint32_t>(seed_bits >> 32)});
+    // The top 53 bits fill the mantissa of the double
+    const uint64_t mantissa =
+      ((static_cast<uint64_t>(bits[0]) << 32) | bits[1]) >> 11;
+    return static_cast<double>(mantissa) * (1.0 / 9007199254740992.0);
+  }
+
+  array<uint32_t,4> WalkerRandomStreams::philox(
+      array<uint32_t,4> counter,
+      array<uint32_t,2> key) {
+
+    for(int round = 0; round < philox_rounds; ++round){
+      if(round > 0){
+        key[0] += philox_key_increment_0;
+        key[1] += philox_key_increment_1;
+      }
+      const uint64_t product_0 = static_cast<uint64_t>(philox_multiplier_0) * counter[0];
+      const uint64_t product_1 = static_cast<uint64_t>(philox_multiplier_1) * counter[2];
+      counter = {
+        static_cast<uint32_t>(product_1 >> 32) ^ counter[1] ^ key[0],
+        static_cast<uint32_t>(product_1),
+        static_cast<uint32_t>(product_0 >> 32) ^ counter[3] ^ key[1],
+        static_cast<uint32_t>(product_0)};
+    }
+    return counter;
+  }
+
+}
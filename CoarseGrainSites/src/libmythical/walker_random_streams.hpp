@@ -0,0 +1,70 @@
+#ifndef MYTHICAL_WALKER_RANDOM_STREAMS_HPP
+#define MYTHICAL_WALKER_RANDOM_STREAMS_HPP
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "random_numbers.hpp"
+
+namespace mythical {
+
+/**
+ * \brief A stream of random numbers for each walker, drawn from a counter
+ * based generator
+ *
+ * Each number is the Philox4x32-10 block cipher applied to the id of the
+ * walker, the number of draws it has made and the generation of its stream,
+ * keyed on the seed. The numbers a walker gets therefore only depend on the
+ * seed, its id, the generation and how many numbers it has drawn, not on
+ * which site or cluster it draws them on or the order the walkers hop in.
+ * The only state kept is a count and a generation per walker.
+ **/
+class WalkerRandomStreams : public RandomNumbers {
+  public:
+    explicit WalkerRandomStreams(const unsigned long seed) : seed_(seed) {};
+
+    /// Next uniform number in [0,1) of the walker, throws invalid_argument if
+    /// the id is negative or larger than constants::max_walker_id
+    double draw(const int walker_id) override;
+
+    /**
+     * \brief Start a new stream for the walker id
+     *
+     * If the id has drawn numbers before the stream moves on to the next
+     * generation, so a walker reusing the id of one that has left does not
+     * repeat its numbers. The draw count starts over from 0.
+     **/
+    void reset(const int walker_id);
+
+    std::uint64_t getDrawCount(const int walker_id) const;
+    std::uint32_t getGeneration(const int walker_id) const;
+
+    unsigned long getSeed() const noexcept { return seed_; }
+
+    /**
+     * \brief Uniform number in [0,1) a walker gets on one of its draws,
+     * without changing any counts
+     **/
+    static double uniform(
+        const unsigned long seed,
+        const int walker_id,
+        const std::uint64_t draw,
+        const std::uint32_t generation = 0);
+
+    /// The Philox4x32 block cipher with 10 rounds
+    static std::array<std::uint32_t,4> philox(
+        std::array<std::uint32_t,4> counter,
+        std::array<std::uint32_t,2> key);
+
+  private:
+    unsigned long seed_;
+    /// Number of draws made by each walker indexed by the walker id
+    std::vector<std::uint64_t> draws_;
+    /// Number of streams each walker id has moved past
+    std::vector<std::uint32_t> generations_;
+};
+
+}
+
+#endif // MYTHICAL_WALKER_RANDOM_STREAMS_HPP
@@ -0,0 +1,68 @@
+#include "mythical/walker_store.hpp"
+
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace mythical {
+
+  void WalkerStore::add(const int walker_index, const int siteId) {
+    if(walker_index < 0 || walker_index > constants::max_walker_id){
+      throw invalid_argument("Walker index " + to_string(walker_index) +
+          " is not valid, walker indices must lie between 0 and " +
+          to_string(constants::max_walker_id) + ".");
+    }
+    if(siteId == constants::unassignedId){
+      throw invalid_argument("Cannot add walker " + to_string(walker_index) +
+          " to an unassigned site.");
+    }
+    if(exist(walker_index)){
+      throw invalid_argument("Walker " + to_string(walker_index) +
+          " is already stored.");
+    }
+    if(walker_index >= static_cast<int>(site_ids_.size())){
+      const size_t count = static_cast<size_t>(walker_index)+1;
+      site_ids_.resize(count,constants::unassignedId);
+      potential_site_ids_.resize(count,constants::unassignedId);
+      dwell_times_.resize(count,0.0);
+      global_times_.resize(count,0.0);
+    }
+    site_ids_[walker_index] = siteId;
+    potential_site_ids_[walker_index] = constants::unassignedId;
+    dwell_times_[walker_index] = 0.0;
+    global_times_[walker_index] = 0.0;
+    ++count_;
+  }
+
+  void WalkerStore::remove(const int walker_index) {
+    if(!exist(walker_index)){
+      throw invalid_argument("Cannot remove walker " + to_string(walker_index) +
+          " it is not stored.");
+    }
+    site_ids_[walker_index] = constants::unassignedId;
+    potential_site_ids_[walker_index] = constants::unassignedId;
+    --count_;
+  }
+
+  void WalkerStore::reserve(const size_t count) {
+    site_ids_.reserve(count);
+    potential_site_ids_.reserve(count);
+    dwell_times_.reserve(count);
+    global_times_.reserve(count);
+  }
+
+  Walker WalkerStore::getWalker(const int walker_index) const {
+    if(!exist(walker_index)){
+      throw invalid_argument("Cannot get walker " + to_string(walker_index) +
+          " it is not stored.");
+    }
+    Walker walker;
+    walker.occupySite(site_ids_[walker_index]);
+    if(potential_site_ids_[walker_index] != constants::unassignedId){
+      walker.setPotentialSite(potential_site_ids_[walker_index]);
+    }
+    walker.setDwellTime(dwell_times_[walker_index]);
+    return walker;
+  }
+}
@@ -0,0 +1,76 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "mythical/queue.hpp"
+#include "mythical/calendar_queue.hpp"
+
+using namespace std;
+using namespace std::chrono;
+using namespace mythical;
+
+// Classic hold model, pop the earliest walker and add it back a dwell time
+// later, with dwell times spanning several orders of magnitude
+template<typename EventQueue>
+double timeHolds(EventQueue & kmc_queue, const vector<double> & dwells, const int walkers){
+  for(int walker_id = 0; walker_id < walkers; ++walker_id){
+    kmc_queue.sortedAdd({walker_id,dwells.at(walker_id)});
+  }
+  double last_time = 0.0;
+  high_resolution_clock::time_point start = high_resolution_clock::now();
+  for(size_t hop = walkers; hop < dwells.size(); ++hop){
+    auto walker = kmc_queue.pop();
+    assert(walker.second >= last_time);
+    last_time = walker.second;
+    kmc_queue.sortedAdd({walker.first,walker.second+dwells.at(hop)});
+  }
+  high_resolution_clock::time_point end = high_resolution_clock::now();
+  return static_cast<double>(duration_cast<nanoseconds>(end-start).count())/
+    (dwells.size()-walkers);
+}
+
+// Pop every walker of a queue that was filled without sorting, in the order
+// they were added
+double timeUnsortedPops(const vector<double> & dwells, const int walkers){
+  Queue kmc_queue;
+  for(int walker_id = 0; walker_id < walkers; ++walker_id){
+    kmc_queue.add({walker_id,dwells.at(walker_id)});
+  }
+  high_resolution_clock::time_point start = high_resolution_clock::now();
+  for(int walker_id = 0; walker_id < walkers; ++walker_id){
+    auto walker = kmc_queue.pop_current();
+    assert(walker.first == walker_id);
+  }
+  high_resolution_clock::time_point end = high_resolution_clock::now();
+  return static_cast<double>(duration_cast<nanoseconds>(end-start).count())/walkers;
+}
+
+int main(void){
+
+  cout << "Testing: event queues" << endl;
+  cout << "This executable compares the time it takes to pop and add back " << endl;
+  cout << "a walker with the binary heap queue and the calendar queue." << endl;
+
+  vector<int> walker_counts = { 10, 100, 1000, 10000, 100000 };
+  const int hops = 2000000;
+  mt19937 random_engine(1);
+  uniform_real_distribution<double> distribution(-6.0,6.0);
+
+  for( const int & walkers : walker_counts ){
+    vector<double> dwells(walkers+hops);
+    for(double & dwell : dwells ) dwell = pow(10.0,distribution(random_engine));
+
+    Queue heap_queue;
+    CalendarQueue calendar_queue;
+    double heap_time = timeHolds(heap_queue,dwells,walkers);
+    double calendar_time = timeHolds(calendar_queue,dwells,walkers);
+    cout << "walkers " << walkers;
+    cout << " heap per hop [ns] " << heap_time;
+    cout << " calendar per hop [ns] " << calendar_time;
+    cout << " unsorted pop [ns] " << timeUnsortedPops(dwells,walkers) << endl;
+  }
+  return 0;
+}
@@ -0,0 +1,105 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "mythical/charge_transport/cuboid_lattice.hpp"
+#include "mythical/charge_transport/marcus.hpp"
+#include "mythical/charge_transport/rate_model.hpp"
+
+using namespace std;
+using namespace std::chrono;
+using namespace mythical;
+using namespace mythical::charge_transport;
+
+int main(void){
+
+  cout << "Testing: Marcus rates" << endl;
+  cout << "This executable compares the time it takes to calculate rates " << endl;
+  cout << "one at a time with getRate and in a batch with getRates, using " << endl;
+  cout << "the exact and the fast exponential." << endl;
+
+  const size_t pairs = 4000000;
+  mt19937 random_engine(1);
+  normal_distribution<double> energy(0.0,0.1);
+  uniform_real_distribution<double> coupling(0.001,0.01);
+  vector<double> E_i(pairs);
+  vector<double> E_j(pairs);
+  vector<double> H_AB(pairs);
+  for(size_t pair = 0; pair < pairs; ++pair){
+    E_i[pair] = energy(random_engine);
+    E_j[pair] = energy(random_engine);
+    H_AB[pair] = coupling(random_engine);
+  }
+
+  Marcus marcus(0.2,300.0);
+  vector<double> single_rates(pairs);
+  vector<double> exact_rates(pairs);
+  vector<double> fast_rates(pairs);
+
+  high_resolution_clock::time_point start = high_resolution_clock::now();
+  for(size_t pair = 0; pair < pairs; ++pair){
+    single_rates[pair] = marcus.getRate(E_i[pair],E_j[pair],H_AB[pair]);
+  }
+  high_resolution_clock::time_point end = high_resolution_clock::now();
+  double single_time = static_cast<double>(duration_cast<nanoseconds>(end-start).count())/pairs;
+
+  start = high_resolution_clock::now();
+  marcus.getRates(pairs,E_i.data(),E_j.data(),H_AB.data(),exact_rates.data());
+  end = high_resolution_clock::now();
+  double exact_time = static_cast<double>(duration_cast<nanoseconds>(end-start).count())/pairs;
+
+  start = high_resolution_clock::now();
+  marcus.getRates(pairs,E_i.data(),E_j.data(),H_AB.data(),fast_rates.data(),
+      ExpPrecision::fast);
+  end = high_resolution_clock::now();
+  double fast_time = static_cast<double>(duration_cast<nanoseconds>(end-start).count())/pairs;
+
+  double largest_error = 0.0;
+  for(size_t pair = 0; pair < pairs; ++pair){
+    assert(exact_rates[pair]==single_rates[pair]);
+    largest_error = max(largest_error,abs(fast_rates[pair]-single_rates[pair])/single_rates[pair]);
+  }
+  assert(largest_error < 1e-8);
+
+  cout << "pairs " << pairs << endl;
+  cout << "getRate per pair [ns]        " << single_time << endl;
+  cout << "getRates exact per pair [ns] " << exact_time << endl;
+  cout << "getRates fast per pair [ns]  " << fast_time << endl;
+  cout << "largest relative error fast  " << largest_error << endl;
+
+  // The rate table of a lattice, each row of rates is evaluated with a single
+  // call to MarcusModel::getRates
+  const int length = 40;
+  Cuboid lattice(length,length,length,1.0);
+  vector<double> energies(length*length*length);
+  for(double & site_energy : energies) site_energy = energy(random_engine);
+  MarcusModel exact_model(0.2,300.0,0.01,0.5);
+  MarcusModel fast_model(0.2,300.0,0.01,0.5,ExpPrecision::fast);
+
+  start = high_resolution_clock::now();
+  RateTable exact_table = buildRateTable(lattice,2.0,energies,exact_model,1);
+  end = high_resolution_clock::now();
+  const size_t table_pairs = exact_table.rates.size();
+  double exact_table_time = static_cast<double>(duration_cast<nanoseconds>(end-start).count())/table_pairs;
+
+  start = high_resolution_clock::now();
+  RateTable fast_table = buildRateTable(lattice,2.0,energies,fast_model,1);
+  end = high_resolution_clock::now();
+  double fast_table_time = static_cast<double>(duration_cast<nanoseconds>(end-start).count())/table_pairs;
+
+  largest_error = 0.0;
+  for(size_t pair = 0; pair < table_pairs; ++pair){
+    largest_error = max(largest_error,
+        abs(fast_table.rates[pair]-exact_table.rates[pair])/exact_table.rates[pair]);
+  }
+  assert(largest_error < 4e-8);
+
+  cout << "rate table pairs " << table_pairs << endl;
+  cout << "buildRateTable exact per pair [ns] " << exact_table_time << endl;
+  cout << "buildRateTable fast per pair [ns]  " << fast_table_time << endl;
+  cout << "largest relative error fast        " << largest_error << endl;
+  return 0;
+}
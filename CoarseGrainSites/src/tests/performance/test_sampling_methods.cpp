@@ -0,0 +1,80 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "mythical/sampling_method.hpp"
+#include "libmythical/discrete_sampler.hpp"
+
+using namespace std;
+using namespace std::chrono;
+using namespace mythical;
+
+int main(void){
+
+  cout << "Testing: sampling methods" << endl;
+  cout << "This executable compares the time it takes to pick an outcome " << endl;
+  cout << "with linear, binary search and alias sampling for different " << endl;
+  cout << "numbers of outcomes. The probabilities span several orders of " << endl;
+  cout << "magnitude as is typical of the rates off a site." << endl;
+
+  vector<int> sizes = { 4, 16, 64, 256, 1024 };
+  vector<SamplingMethod> methods = { SamplingMethod::linear,
+    SamplingMethod::binary_search, SamplingMethod::alias };
+  vector<string> names = { "linear", "binary_search", "alias" };
+
+  const int samples = 2000000;
+  mt19937 random_engine(1);
+  uniform_real_distribution<double> distribution(0.0,1.0);
+
+  for( const int & size : sizes ){
+    vector<double> probabilities;
+    double total = 0.0;
+    for(int index = 0; index < size; ++index){
+      probabilities.push_back(exp(-10.0*distribution(random_engine)));
+      total += probabilities.back();
+    }
+    for(double & probability : probabilities) probability /= total;
+
+    vector<double> numbers(samples);
+    for(double & number : numbers ) number = distribution(random_engine);
+
+    for(size_t method = 0; method < methods.size(); ++method){
+      DiscreteSampler sampler;
+
+      high_resolution_clock::time_point build_start = high_resolution_clock::now();
+      sampler.build(probabilities,methods.at(method));
+      high_resolution_clock::time_point build_end = high_resolution_clock::now();
+
+      long checksum = 0;
+      high_resolution_clock::time_point sample_start = high_resolution_clock::now();
+      for(const double & number : numbers){
+        checksum += sampler.sample(number);
+      }
+      high_resolution_clock::time_point sample_end = high_resolution_clock::now();
+
+      // Check the frequency of the most likely outcome
+      size_t most_likely = 0;
+      for(size_t index = 0; index < probabilities.size(); ++index){
+        if(probabilities.at(index)>probabilities.at(most_likely)) most_likely = index;
+      }
+      int count = 0;
+      for(const double & number : numbers){
+        if(sampler.sample(number)==static_cast<int>(most_likely)) ++count;
+      }
+      double frequency = static_cast<double>(count)/samples;
+      assert(fabs(frequency-probabilities.at(most_likely))<0.01);
+
+      auto build_time = duration_cast<nanoseconds>(build_end-build_start).count();
+      auto sample_time = duration_cast<nanoseconds>(sample_end-sample_start).count();
+      cout << "outcomes " << size << " method " << names.at(method);
+      cout << " build [ns] " << build_time;
+      cout << " per sample [ns] " << static_cast<double>(sample_time)/samples;
+      cout << " checksum " << checksum << endl;
+    }
+  }
+  return 0;
+}
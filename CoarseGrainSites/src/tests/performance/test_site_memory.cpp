@@ -0,0 +1,152 @@
+#include <iostream>
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+#include "mythical/coarsegrainsystem.hpp"
+#include "mythical/constants.hpp"
+#include "mythical/rate_network.hpp"
+#include "libmythical/random_numbers.hpp"
+#include "libmythical/rate_graph.hpp"
+#include "libmythical/walker_random_streams.hpp"
+#include "libmythical/topologyfeatures/site.hpp"
+
+using namespace std;
+using namespace mythical;
+
+// Every allocation of the executable and the library goes through these, the
+// size of each block is stored in front of it so the bytes still allocated
+// are known at any time
+namespace {
+  size_t allocated_bytes = 0;
+  const size_t header_bytes = alignof(max_align_t);
+}
+
+void * operator new(size_t size){
+  void * block = malloc(size+header_bytes);
+  if(block == nullptr) throw bad_alloc();
+  *static_cast<size_t *>(block) = size;
+  allocated_bytes += size;
+  return static_cast<char *>(block)+header_bytes;
+}
+
+void operator delete(void * pointer) noexcept {
+  if(pointer == nullptr) return;
+  char * block = static_cast<char *>(pointer)-header_bytes;
+  allocated_bytes -= *reinterpret_cast<size_t *>(block);
+  free(block);
+}
+
+void operator delete(void * pointer, size_t) noexcept {
+  operator delete(pointer);
+}
+
+struct SiteBytes {
+  size_t initialized;
+  size_t hopped;
+};
+
+// Bytes allocated by a system for its sites, not counting the rates shared
+// through the network, once it is initialized and once its walkers have
+// hopped over part of the sites
+SiteBytes measureSystem(shared_ptr<const RateNetwork> rate_network,
+    const CoarseGrainSystem::RandomStreams streams,
+    const int number_of_walkers,
+    const int hops){
+
+  const size_t before = allocated_bytes;
+  CoarseGrainSystem CGsystem;
+  CGsystem.setRandomSeed(1);
+  CGsystem.setRandomStreams(streams);
+  CGsystem.setTimeResolution(1.0);
+  CGsystem.setMinCoarseGrainIterationThreshold(constants::inf_iterations);
+  CGsystem.initializeSystem(rate_network);
+  SiteBytes bytes;
+  bytes.initialized = allocated_bytes-before;
+
+  const int number_of_sites = rate_network->getNumberOfSites();
+  for(int walker_id = 0; walker_id < number_of_walkers; ++walker_id){
+    CGsystem.addWalker(walker_id,walker_id*(number_of_sites/number_of_walkers));
+  }
+  CGsystem.step(hops);
+  bytes.hopped = allocated_bytes-before;
+  return bytes;
+}
+
+int main(void){
+
+  cout << "Testing: site memory" << endl;
+  cout << "This executable reports the memory taken by each site, not " << endl;
+  cout << "counting the rates to its neighbors which are stored in the " << endl;
+  cout << "rate graph shared by all the sites." << endl;
+
+  const int number_of_sites = 100000;
+
+  // A chain of sites, each hopping to the next one
+  auto rate_graph = make_shared<RateGraph>();
+  for(int siteId = 0; siteId < number_of_sites; ++siteId){
+    unordered_map<int,double> neighbors_and_rates;
+    neighbors_and_rates[(siteId+1)%number_of_sites] = 1.0;
+    rate_graph->addRow(neighbors_and_rates);
+  }
+  shared_ptr<const RateGraph> shared_graph = rate_graph;
+
+  vector<Site> sites(number_of_sites);
+  for(int siteId = 0; siteId < number_of_sites; ++siteId){
+    sites.at(siteId).setId(siteId);
+    sites.at(siteId).setRateGraph(shared_graph,siteId);
+  }
+
+  const size_t site_bytes = sizeof(Site);
+  const size_t engine_bytes = sizeof(FeatureRandomNumbers);
+  cout << endl;
+  cout << "Sites                                " << number_of_sites << endl;
+  cout << "Bytes per site                       " << site_bytes << endl;
+  cout << "Bytes of an engine                   " << engine_bytes << endl;
+
+  // Only sites that draw from their own engine pay for one, walkers drawing
+  // from counter based streams add nothing to the sites
+  WalkerRandomStreams streams(1);
+  for(Site & site : sites) site.setWalkerRandomStreams(&streams);
+  for(int siteId = 0; siteId < number_of_sites; ++siteId){
+    assert(sites.at(siteId).pickNewSiteId(siteId)==(siteId+1)%number_of_sites);
+  }
+
+  // Ring of sites hopped over by a few walkers, so only part of the sites
+  // are ever hopped off of
+  unordered_map<int,unordered_map<int,double>> rates;
+  for(int siteId = 0; siteId < number_of_sites; ++siteId){
+    rates[siteId][(siteId+1)%number_of_sites] = 1.0;
+    rates[siteId][(siteId+number_of_sites-1)%number_of_sites] = 1.0;
+  }
+  shared_ptr<const RateNetwork> rate_network = RateNetwork::create(rates);
+
+  const int number_of_walkers = 10;
+  const int hops = 100000;
+  const SiteBytes per_feature = measureSystem(rate_network,
+      CoarseGrainSystem::RandomStreams::per_feature,number_of_walkers,hops);
+  const SiteBytes per_walker = measureSystem(rate_network,
+      CoarseGrainSystem::RandomStreams::per_walker,number_of_walkers,hops);
+
+  cout << endl;
+  cout << "Bytes allocated per site by a seeded system, " << number_of_walkers;
+  cout << " walkers making " << hops << " hops" << endl;
+  cout << "                         initialized     hopped" << endl;
+  cout << "per_feature              ";
+  cout << static_cast<double>(per_feature.initialized)/number_of_sites << "     ";
+  cout << static_cast<double>(per_feature.hopped)/number_of_sites << endl;
+  cout << "per_walker               ";
+  cout << static_cast<double>(per_walker.initialized)/number_of_sites << "     ";
+  cout << static_cast<double>(per_walker.hopped)/number_of_sites << endl;
+
+  assert(site_bytes < 64);
+  // No site has an engine before it is hopped off of
+  assert(per_feature.initialized < per_walker.initialized+number_of_sites);
+  assert(per_feature.hopped > per_feature.initialized);
+  assert(per_feature.hopped < per_feature.initialized+number_of_sites*engine_bytes/2);
+  return 0;
+}
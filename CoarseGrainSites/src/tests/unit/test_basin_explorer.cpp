@@ -84,6 +84,20 @@ TEST_CASE("Testing: findBasin","[unit]"){
     assert(found2);
     assert(found3);
 
+    // The same explorer is reused, the basin is the same from site3 and is
+    // abandoned once it grows larger than the max exploration count
+    vertices = basin_explorer.findBasin(site_container,clusters,3);
+    assert(vertices.size()==2);
+    assert(vertices.at(0)==3);
+    assert(vertices.at(1)==2);
+
+    basin_explorer.setMaxExplorationCount(1);
+    vertices = basin_explorer.findBasin(site_container,clusters,2);
+    assert(vertices.size()==0);
+
+    basin_explorer.setMaxExplorationCount(5);
+    vertices = basin_explorer.findBasin(site_container,clusters,2);
+    assert(vertices.size()==2);
   }
 
   cout << "Test 2" << endl;
@@ -0,0 +1,123 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "mythical/calendar_queue.hpp"
+
+using namespace std;
+using namespace mythical;
+
+TEST_CASE("Testing: CalendarQueue","[unit]"){
+
+  cout << "Testing: CalendarQueue constructor" << endl;
+  {
+    CalendarQueue kmc_queue;
+    assert(kmc_queue.size()==0);
+    assert(kmc_queue.empty());
+  }
+
+  cout << "Testing: CalendarQueue sortedAdd and pop" << endl;
+  {
+    CalendarQueue kmc_queue;
+    kmc_queue.sortedAdd({ 1, 23.1});
+    kmc_queue.sortedAdd({ 3, 10.3});
+    kmc_queue.sortedAdd({ 2, 0.13});
+    assert(kmc_queue.size()==3);
+    assert(kmc_queue.peek().first == 2 );
+    assert(kmc_queue.pop().first == 2 );
+    assert(kmc_queue.pop_current().first == 3 );
+    auto walker = kmc_queue.pop();
+    assert(walker.first == 1 );
+    assert(walker.second == 23.1 );
+    assert(kmc_queue.empty());
+
+    bool throw_error = false;
+    try {
+      kmc_queue.pop();
+    }catch(const out_of_range & e){
+      throw_error = true;
+    }
+    assert(throw_error);
+  }
+
+  cout << "Testing: CalendarQueue times spanning many orders of magnitude" << endl;
+  {
+    CalendarQueue kmc_queue;
+    vector<pair<int,double>> walkers;
+    for(int walker_id = 0; walker_id < 1000; ++walker_id){
+      double exponent = static_cast<double>((walker_id*7919)%1201)/100.0-6.0;
+      walkers.push_back({walker_id,pow(10.0,exponent)});
+      kmc_queue.sortedAdd(walkers.back());
+    }
+    assert(kmc_queue.size()==1000);
+    assert(kmc_queue.getNumberOfBuckets()>2);
+
+    // Hop the earliest walkers forward in time as a simulation would
+    double last_time = 0.0;
+    for(int hop = 0; hop < 5000; ++hop){
+      auto walker = kmc_queue.pop();
+      assert(walker.second >= last_time);
+      last_time = walker.second;
+      double dwell = pow(10.0,static_cast<double>((hop*104729)%1201)/100.0-6.0);
+      kmc_queue.sortedAdd({walker.first,walker.second+dwell});
+    }
+
+    vector<pair<int,double>> reference;
+    while(!kmc_queue.empty()) reference.push_back(kmc_queue.pop());
+    assert(reference.size()==1000);
+    for(size_t index = 1; index < reference.size(); ++index){
+      assert(reference.at(index).second >= reference.at(index-1).second);
+    }
+    assert(reference.front().second >= last_time);
+    assert(kmc_queue.getNumberOfBuckets()==2);
+  }
+
+  cout << "Testing: CalendarQueue update" << endl;
+  {
+    CalendarQueue kmc_queue;
+    kmc_queue.sortedAdd({ 1, 23.1});
+    kmc_queue.sortedAdd({ 3, 10.3});
+    kmc_queue.sortedAdd({ 2, 0.13});
+    kmc_queue.update({ 1, 0.01});
+    assert(kmc_queue.peek().first == 1 );
+    kmc_queue.update({ 1, 1.0E6});
+    assert(kmc_queue.pop().first == 2 );
+    assert(kmc_queue.pop().first == 3 );
+    assert(kmc_queue.pop().second == 1.0E6 );
+
+    bool throw_error = false;
+    try {
+      kmc_queue.update({ 1, 1.0});
+    }catch(const invalid_argument & e){
+      throw_error = true;
+    }
+    assert(throw_error);
+  }
+
+  cout << "Testing: CalendarQueue erase and contains" << endl;
+  {
+    CalendarQueue kmc_queue;
+    kmc_queue.sortedAdd({ 1, 23.1});
+    kmc_queue.sortedAdd({ 3, 10.3});
+    kmc_queue.sortedAdd({ 2, 0.13});
+    assert(kmc_queue.contains(2));
+    kmc_queue.erase(2);
+    assert(kmc_queue.contains(2) == false);
+    assert(kmc_queue.contains(-4) == false);
+    assert(kmc_queue.size()==2);
+    assert(kmc_queue.pop().first == 3 );
+
+    bool throw_error = false;
+    try {
+      kmc_queue.sortedAdd({ 1, 2.0});
+    }catch(const invalid_argument & e){
+      throw_error = true;
+    }
+    assert(throw_error);
+  }
+}
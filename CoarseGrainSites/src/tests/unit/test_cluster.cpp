@@ -5,6 +5,7 @@
 #include <vector>
 #include <memory>
 #include <cmath>
+#include <stdexcept>
 
 #include "../../libmythical/topologyfeatures/cluster.hpp"
 #include "../../libmythical/topologyfeatures/site.hpp"
@@ -336,6 +337,17 @@ TEST_CASE("Testing: Cluster","[unit]"){
     // Setting the seed will ensure that the results are reproducable
 
     cluster.setRandomSeed(1);
+
+    // The dwell time table is indexed by the walker id
+    for(const int walker_id : {-1, constants::max_walker_id+1}){
+      bool throw_error = false;
+      try {
+        cluster.getDwellTime(walker_id);
+      }catch(const invalid_argument & e){
+        throw_error = true;
+      }
+      assert(throw_error);
+    }
    
     int total = 1000000;
     int site1_id = 1;
@@ -509,4 +521,144 @@ TEST_CASE("Testing: Cluster","[unit]"){
     assert(visit_prob.at(2) < baseline_visit_prob.at(2)*1.2);
     assert(visit_prob.at(2) > baseline_visit_prob.at(2)*0.8);
   }
+
+  cout << "Testing: setWalkerDwellTimeTable" << endl;
+  {
+    Site site;
+    site.setId(1);
+    double rate = 1;
+    double rate_off = 0.001;
+    site.addNeighRate(pair<int, double *>(2,&rate));
+    site.addNeighRate(pair<int, double *>(3,&rate_off));
+
+    Site site2;
+    site2.setId(2);
+    site2.addNeighRate(pair<int, double *>(1,&rate));
+
+    Cluster cluster;
+    cluster.setConvergenceIterations(50);
+    cluster.setResolution(2);
+    cluster.addSite(site);
+    cluster.addSite(site2);
+    cluster.updateProbabilitiesAndTimeConstant();
+    cluster.setRandomSeed(1);
+
+    auto table = make_shared<vector<double>>();
+    cluster.setWalkerDwellTimeTable(table);
+
+    int walker_id = 4;
+    cluster.occupy(1);
+    double dwell_time = cluster.getDwellTime(walker_id);
+    assert(dwell_time <= cluster.getTimeIncrement());
+    assert(table->size() == 5);
+    // Walkers not on the cluster are marked with negative infinity
+    assert(std::isinf(table->at(0)) && table->at(0) < 0.0);
+    assert(std::isfinite(table->at(walker_id)));
+
+    cluster.removeWalker(walker_id,1);
+    assert(std::isinf(table->at(walker_id)) && table->at(walker_id) < 0.0);
+  }
+
+  cout << "Testing: converge_automatically" << endl;
+  {
+    // site1 - site2 - site3 -> site4, the rate off of the cluster is small
+    // enough that the walker should be on site2 half the time
+    Site site;
+    site.setId(1);
+    double rate = 1;
+    site.addNeighRate(pair<int, double *>(2,&rate));
+
+    Site site2;
+    site2.setId(2);
+    site2.addNeighRate(pair<int, double *>(1,&rate));
+    site2.addNeighRate(pair<int, double *>(3,&rate));
+
+    Site site3;
+    site3.setId(3);
+    site3.addNeighRate(pair<int, double *>(2,&rate));
+    double rate_off = 1E-6;
+    site3.addNeighRate(pair<int, double *>(4,&rate_off));
+
+    Cluster cluster;
+    cluster.setConvergenceMethod(Cluster::Method::converge_automatically);
+    cluster.setConvergenceTolerance(1E-9);
+    cluster.addSite(site);
+    cluster.addSite(site2);
+    cluster.addSite(site3);
+    cluster.updateProbabilitiesAndTimeConstant();
+
+    assert(cluster.getMethodUsed()==Cluster::Method::converge_by_direct_solve);
+    assert(cluster.getSolveIterations()>0);
+    assert(cluster.getSolveTime()>=0.0);
+    assert(fabs(cluster.getProbabilityOfOccupyingInternalSite(2)-0.5)<1E-4);
+
+    cluster.setDirectSolveLimit(2);
+    assert(cluster.getDirectSolveLimit()==2);
+    cluster.updateProbabilitiesAndTimeConstant();
+    assert(cluster.getMethodUsed()==Cluster::Method::converge_by_accelerated_iterations);
+    assert(cluster.getSolveIterations()>0);
+    assert(fabs(cluster.getProbabilityOfOccupyingInternalSite(2)-0.5)<1E-4);
+  }
+
+  cout << "Testing: migrateSitesFrom and growing a cluster" << endl;
+  {
+    // site1 - site2 - site3 - site4 -> site5
+    //
+    // Merging {1,2} with {3,4} or adding site4 to {1,2,3} should give the
+    // same cluster as creating {1,2,3,4} from scratch
+    double rate = 1;
+    double rate_slow = 0.2;
+    double rate_off = 0.01;
+    vector<Site> sites(4);
+    for(int index = 0; index < 4; ++index) sites.at(index).setId(index+1);
+    sites.at(0).addNeighRate(pair<int, double *>(2,&rate));
+    sites.at(1).addNeighRate(pair<int, double *>(1,&rate));
+    sites.at(1).addNeighRate(pair<int, double *>(3,&rate_slow));
+    sites.at(2).addNeighRate(pair<int, double *>(2,&rate_slow));
+    sites.at(2).addNeighRate(pair<int, double *>(4,&rate));
+    sites.at(3).addNeighRate(pair<int, double *>(3,&rate));
+    sites.at(3).addNeighRate(pair<int, double *>(5,&rate_off));
+
+    auto make_cluster = [](){
+      Cluster cluster;
+      cluster.setConvergenceMethod(Cluster::Method::converge_by_tolerance);
+      cluster.setConvergenceTolerance(1E-12);
+      return cluster;
+    };
+
+    Cluster reference = make_cluster();
+    reference.addSites(sites);
+    reference.updateProbabilitiesAndTimeConstant();
+
+    Cluster cluster = make_cluster();
+    vector<Site> first_sites = {sites.at(0), sites.at(1)};
+    cluster.addSites(first_sites);
+    cluster.updateProbabilitiesAndTimeConstant();
+    Cluster cluster2 = make_cluster();
+    vector<Site> second_sites = {sites.at(2), sites.at(3)};
+    cluster2.addSites(second_sites);
+    cluster2.updateProbabilitiesAndTimeConstant();
+
+    cluster.migrateSitesFrom(cluster2);
+    assert(cluster2.getSiteIdsInCluster().size()==0);
+    assert(cluster.getSiteIdsInCluster().size()==4);
+
+    Cluster grown = make_cluster();
+    vector<Site> three_sites = {sites.at(0), sites.at(1), sites.at(2)};
+    grown.addSites(three_sites);
+    grown.updateProbabilitiesAndTimeConstant();
+    grown.addSite(sites.at(3));
+    grown.updateProbabilitiesAndTimeConstant();
+
+    for(int siteId = 1; siteId <= 4; ++siteId){
+      double expected = reference.getProbabilityOfOccupyingInternalSite(siteId);
+      assert(fabs(cluster.getProbabilityOfOccupyingInternalSite(siteId)-expected)<1E-8);
+      assert(fabs(grown.getProbabilityOfOccupyingInternalSite(siteId)-expected)<1E-8);
+    }
+    assert(fabs(cluster.getTimeConstant()-reference.getTimeConstant())<1E-8*reference.getTimeConstant());
+    assert(fabs(grown.getTimeConstant()-reference.getTimeConstant())<1E-8*reference.getTimeConstant());
+    assert(cluster.getSiteIdsNeighboringCluster().size()==1);
+    assert(grown.getSiteIdsNeighboringCluster().size()==1);
+    assert(fabs(grown.getProbabilityOfHoppingToNeighborOfCluster(5)-1.0)<1E-12);
+  }
 }
@@ -1,13 +1,17 @@
 #include <catch2/catch.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <cassert>
 #include <vector>
 #include <memory>
+#include <stdexcept>
 
 #include "mythical/constants.hpp"
 #include "mythical/coarsegrainsystem.hpp"
 #include "mythical/walker.hpp"
+#include "../../libmythical/walker_random_streams.hpp"
 
 using namespace std;
 using namespace mythical;
@@ -136,6 +140,16 @@ TEST_CASE("Testing: CoarseGrainSystem","[unit]"){
     CoarseGrainSystem CGsystem;
     CGsystem.setTimeResolution(10.0);
     CGsystem.initializeSystem(ratesToNeighbors);
+
+    // The sites of the first call would be left behind with the new rates
+    bool throw_error = false;
+    try {
+      CGsystem.initializeSystem(ratesToNeighbors);
+    }catch(const runtime_error & e){
+      throw_error = true;
+    }
+    assert(throw_error);
+    assert(CGsystem.getRateNetwork()->getSiteIds().size()==12);
   }
 
   cout << "Testing: hop" << endl;
@@ -369,6 +383,276 @@ TEST_CASE("Testing: CoarseGrainSystem","[unit]"){
       }
 
     } // With cluster formation
+
+    cout << "Running with Cluster using each crossing time method" << endl;
+    {
+      auto clusters_found_with = [&](CoarseGrainSystem::CrossingTimeMethod method){
+        CoarseGrainSystem CGsystem;
+        CGsystem.setRandomSeed(1);
+        CGsystem.setTimeResolution(time_limit/10.0);
+        CGsystem.setPerformanceRatio(1.0);
+        CGsystem.setMinCoarseGrainIterationThreshold(1000);
+        CGsystem.setCrossingTimeMethod(method);
+        assert(CGsystem.getCrossingTimeMethod()==method);
+        CGsystem.initializeSystem(ratesToNeighbors);
+
+        vector<pair<int,std::shared_ptr<Walker>>> electrons;
+        electrons.emplace_back(1,std::shared_ptr<Walker>(new Walker));
+        electrons.back().second->occupySite(1);
+        CGsystem.initializeWalkers(electrons);
+
+        double time = 0.0;
+        while(time<time_limit){
+          CGsystem.hop(1,electrons.at(0).second);
+          time += electrons.at(0).second->getDwellTime();
+        }
+        return CGsystem.getClusters();
+      };
+
+      auto clusters = clusters_found_with(
+          CoarseGrainSystem::CrossingTimeMethod::native);
+      auto reference_clusters = clusters_found_with(
+          CoarseGrainSystem::CrossingTimeMethod::graph_library);
+      // Cluster ids differ between systems, only the sites are compared
+      assert(clusters.size()==1);
+      assert(reference_clusters.size()==1);
+      vector<int> siteIds = clusters.begin()->second;
+      vector<int> reference_siteIds = reference_clusters.begin()->second;
+      sort(siteIds.begin(),siteIds.end());
+      sort(reference_siteIds.begin(),reference_siteIds.end());
+      assert(siteIds==reference_siteIds);
+    }
+
+    cout << "Running with Cluster recording coarse grain attempts" << endl;
+    {
+      CoarseGrainSystem CGsystem;
+      CGsystem.setRandomSeed(1);
+      CGsystem.setTimeResolution(time_limit/10.0);
+      CGsystem.setPerformanceRatio(1.0);
+      CGsystem.setMinCoarseGrainIterationThreshold(1000);
+
+      CGsystem.setBasinThreshold(0.9);
+      assert(CGsystem.getBasinThreshold()==0.9);
+      CGsystem.setMaxExplorationCount(4);
+      assert(CGsystem.getMaxExplorationCount()==4);
+      CGsystem.setAdaptiveExplorationCount(2,8);
+      assert(CGsystem.getMaxExplorationCount()==4);
+      bool threw = false;
+      try{
+        CGsystem.setAdaptiveExplorationCount(3,2);
+      }catch(invalid_argument & e){
+        threw = true;
+      }
+      assert(threw);
+      CGsystem.initializeSystem(ratesToNeighbors);
+
+      long observed = 0;
+      int sites_coarse_grained = 0;
+      CGsystem.setCoarseGrainAttemptObserver(
+          [&](const CoarseGrainAttempt & attempt){
+            ++observed;
+            assert(attempt.seconds>=0.0);
+            assert(attempt.sites_explored>=0);
+            if(attempt.coarse_grained){
+              assert(!attempt.limit_reached);
+              sites_coarse_grained += attempt.sites_explored;
+            }
+          });
+
+      vector<pair<int,std::shared_ptr<Walker>>> electrons;
+      electrons.emplace_back(1,std::shared_ptr<Walker>(new Walker));
+      electrons.back().second->occupySite(1);
+      CGsystem.initializeWalkers(electrons);
+
+      double time = 0.0;
+      while(time<time_limit){
+        CGsystem.hop(1,electrons.at(0).second);
+        time += electrons.at(0).second->getDwellTime();
+      }
+
+      const CoarseGrainStatistics & statistics = CGsystem.getCoarseGrainStatistics();
+      assert(statistics.attempts==observed);
+      assert(statistics.attempts==statistics.abandoned+statistics.rejected+
+          statistics.coarse_grained);
+      assert(statistics.coarse_grained>=1);
+      assert(sites_coarse_grained>=2);
+      assert(CGsystem.getClusters().size()==1);
+      assert(CGsystem.getMaxExplorationCount()>=2);
+      assert(CGsystem.getMaxExplorationCount()<=8);
+
+      CGsystem.resetCoarseGrainStatistics();
+      assert(CGsystem.getCoarseGrainStatistics().attempts==0);
+      assert(CGsystem.getCoarseGrainStatistics().seconds_rejected==0.0);
+    }
+
+    cout << "Running with Cluster triggered by hot spots" << endl;
+    {
+      CoarseGrainSystem CGsystem;
+      CGsystem.setRandomSeed(1);
+      CGsystem.setTimeResolution(time_limit/10.0);
+      CGsystem.setPerformanceRatio(1.0);
+      CGsystem.setMinCoarseGrainIterationThreshold(1000);
+      CGsystem.setCoarseGrainTrigger(CoarseGrainSystem::CoarseGrainTrigger::hot_spots);
+      assert(CGsystem.getCoarseGrainTrigger()==
+          CoarseGrainSystem::CoarseGrainTrigger::hot_spots);
+      CGsystem.setHotSpotsPerAttempt(2);
+      assert(CGsystem.getHotSpotsPerAttempt()==2);
+      bool threw = false;
+      try{
+        CGsystem.setHotSpotsPerAttempt(0);
+      }catch(invalid_argument & e){
+        threw = true;
+      }
+      assert(threw);
+      CGsystem.initializeSystem(ratesToNeighbors);
+
+      vector<int> sites_tried;
+      CGsystem.setCoarseGrainAttemptObserver(
+          [&](const CoarseGrainAttempt & attempt){
+            sites_tried.push_back(attempt.site_id);
+          });
+
+      vector<pair<int,std::shared_ptr<Walker>>> electrons;
+      electrons.emplace_back(1,std::shared_ptr<Walker>(new Walker));
+      electrons.back().second->occupySite(1);
+      CGsystem.initializeWalkers(electrons);
+
+      double time = 0.0;
+      while(time<time_limit){
+        CGsystem.hop(1,electrons.at(0).second);
+        time += electrons.at(0).second->getDwellTime();
+      }
+
+      // The walker spends most of its hops going back and forth between
+      // sites 6 and 7 so they are the first sites tried
+      assert(sites_tried.size()>=1);
+      assert(sites_tried.at(0)==6 || sites_tried.at(0)==7);
+      auto clusters = CGsystem.getClusters();
+      assert(clusters.size()==1);
+      vector<int> siteIds = clusters.begin()->second;
+      assert(find(siteIds.begin(),siteIds.end(),6)!=siteIds.end());
+      assert(find(siteIds.begin(),siteIds.end(),7)!=siteIds.end());
+    }
+
+    cout << "Running with Cluster found in the background" << endl;
+    {
+      // Returns the sites visited by the walker
+      auto run_in_background = [&](vector<int> & siteIds){
+        CoarseGrainSystem CGsystem;
+        CGsystem.setRandomSeed(1);
+        CGsystem.setTimeResolution(time_limit/10.0);
+        CGsystem.setPerformanceRatio(1.0);
+        CGsystem.setMinCoarseGrainIterationThreshold(1000);
+        CGsystem.setBackgroundCoarseGraining(true);
+        assert(CGsystem.getBackgroundCoarseGraining());
+        CGsystem.initializeSystem(ratesToNeighbors);
+
+        vector<pair<int,std::shared_ptr<Walker>>> electrons;
+        electrons.emplace_back(1,std::shared_ptr<Walker>(new Walker));
+        electrons.back().second->occupySite(1);
+        CGsystem.initializeWalkers(electrons);
+
+        vector<int> visited;
+        double time = 0.0;
+        while(time<time_limit){
+          CGsystem.hop(1,electrons.at(0).second);
+          time += electrons.at(0).second->getDwellTime();
+          visited.push_back(electrons.at(0).second->getIdOfSiteCurrentlyOccupying());
+          // The helper may still be reading the time resolution
+          if(visited.size()==1500) CGsystem.setTimeResolution(time_limit/10.0);
+        }
+        CGsystem.setBackgroundCoarseGraining(false);
+        auto clusters = CGsystem.getClusters();
+        assert(clusters.size()==1);
+        siteIds = clusters.begin()->second;
+        sort(siteIds.begin(),siteIds.end());
+        return visited;
+      };
+
+      vector<int> siteIds;
+      vector<int> other_siteIds;
+      vector<int> visited = run_in_background(siteIds);
+      vector<int> other_visited = run_in_background(other_siteIds);
+      assert(find(siteIds.begin(),siteIds.end(),6)!=siteIds.end());
+      assert(find(siteIds.begin(),siteIds.end(),7)!=siteIds.end());
+      // The clusters are put in place after the same number of hops however
+      // long the helper thread takes, so the runs are identical
+      assert(siteIds==other_siteIds);
+      assert(visited==other_visited);
+    }
+
+    cout << "Running with random numbers drawn per walker" << endl;
+    {
+      // Returns the sites visited by the walker
+      auto run_per_walker = [&](vector<int> & siteIds){
+        CoarseGrainSystem CGsystem;
+        CGsystem.setRandomSeed(1);
+        CGsystem.setRandomStreams(CoarseGrainSystem::RandomStreams::per_walker);
+        assert(CGsystem.getRandomStreams()==CoarseGrainSystem::RandomStreams::per_walker);
+        CGsystem.setTimeResolution(time_limit/10.0);
+        CGsystem.setPerformanceRatio(1.0);
+        CGsystem.setMinCoarseGrainIterationThreshold(1000);
+        CGsystem.initializeSystem(ratesToNeighbors);
+
+        bool throw_error = false;
+        try {
+          CGsystem.setRandomStreams(CoarseGrainSystem::RandomStreams::per_feature);
+        }catch(...){
+          throw_error = true;
+        }
+        assert(throw_error);
+
+        vector<pair<int,std::shared_ptr<Walker>>> electrons;
+        electrons.emplace_back(1,std::shared_ptr<Walker>(new Walker));
+        electrons.back().second->occupySite(1);
+        CGsystem.initializeWalkers(electrons);
+
+        vector<int> visited;
+        double time = 0.0;
+        while(time<time_limit){
+          CGsystem.hop(1,electrons.at(0).second);
+          time += electrons.at(0).second->getDwellTime();
+          visited.push_back(electrons.at(0).second->getIdOfSiteCurrentlyOccupying());
+        }
+        auto clusters = CGsystem.getClusters();
+        assert(clusters.size()==1);
+        siteIds = clusters.begin()->second;
+        sort(siteIds.begin(),siteIds.end());
+        return visited;
+      };
+
+      vector<int> siteIds;
+      vector<int> other_siteIds;
+      vector<int> visited = run_per_walker(siteIds);
+      assert(visited==run_per_walker(other_siteIds));
+      assert(siteIds==other_siteIds);
+      assert(find(siteIds.begin(),siteIds.end(),6)!=siteIds.end());
+      assert(find(siteIds.begin(),siteIds.end(),7)!=siteIds.end());
+
+      // Walkers sharing a site get the numbers of their own streams whatever
+      // order they are initialized in
+      for(const bool reversed : {false, true}){
+        CoarseGrainSystem CGsystem;
+        CGsystem.setRandomSeed(3);
+        CGsystem.setRandomStreams(CoarseGrainSystem::RandomStreams::per_walker);
+        CGsystem.setTimeResolution(time_limit/10.0);
+        CGsystem.initializeSystem(ratesToNeighbors);
+
+        vector<pair<int,std::shared_ptr<Walker>>> electrons;
+        electrons.emplace_back(2,std::shared_ptr<Walker>(new Walker));
+        electrons.emplace_back(5,std::shared_ptr<Walker>(new Walker));
+        if(reversed) swap(electrons.at(0),electrons.at(1));
+        for(auto & electron : electrons) electron.second->occupySite(1);
+        CGsystem.initializeWalkers(electrons);
+
+        // Site 1 has two slow rates off of it
+        for(auto & electron : electrons){
+          const double number = WalkerRandomStreams::uniform(3,electron.first,0);
+          assert(electron.second->getDwellTime()==
+              (-1.0)*log(number)*(1.0/(2.0*rate_slow)));
+        }
+      }
+    }
   }
 
   cout << "Testing: hop 2" << endl;
@@ -850,4 +1134,164 @@ TEST_CASE("Testing: CoarseGrainSystem","[unit]"){
 
     }// With cluster formation
   }
+
+  cout << "Testing: run and step" << endl;
+  {
+    // Ring of 6 sites with the same rate between each neighbor
+    //
+    // site0 - site1 - site2 - site3 - site4 - site5 - site0
+    unordered_map<int,unordered_map<int,double>> ratesToNeighbors;
+    for(int siteId = 0; siteId < 6; ++siteId){
+      ratesToNeighbors[siteId][(siteId+1)%6] = 1.0;
+      ratesToNeighbors[siteId][(siteId+5)%6] = 1.0;
+    }
+
+    CoarseGrainSystem CGsystem;
+    CGsystem.setRandomSeed(2);
+    CGsystem.setTimeResolution(0.5);
+    CGsystem.setMinCoarseGrainIterationThreshold(constants::inf_iterations);
+
+    bool throw_error = false;
+    try {
+      CGsystem.addWalker(0,0);
+    }catch(...){
+      throw_error = true;
+    }
+    assert(throw_error);
+
+    CGsystem.initializeSystem(ratesToNeighbors);
+    CGsystem.addWalker(0,0);
+    CGsystem.addWalker(1,3);
+    assert(CGsystem.getNumberOfWalkers()==2);
+    assert(CGsystem.getSiteIdOfWalker(1)==3);
+    assert(CGsystem.getWalkerStore().getSiteId(1)==3);
+    assert(CGsystem.getWalkerStore().getGlobalTime(1)==
+        CGsystem.getWalkerStore().getDwellTime(1));
+
+    throw_error = false;
+    try {
+      CGsystem.addWalker(1,2);
+    }catch(const invalid_argument & e){
+      throw_error = true;
+    }
+    assert(throw_error);
+
+    // Walker ids index the walker tables, ids outside of them are rejected
+    for(const int walker_id : {-1, constants::max_walker_id+1}){
+      throw_error = false;
+      try {
+        CGsystem.addWalker(walker_id,2);
+      }catch(const invalid_argument & e){
+        throw_error = true;
+      }
+      assert(throw_error);
+
+      shared_ptr<Walker> walker = make_shared<Walker>();
+      walker->occupySite(2);
+      vector<pair<int,shared_ptr<Walker>>> walkers = {{walker_id,walker}};
+      throw_error = false;
+      try {
+        CGsystem.initializeWalkers(walkers);
+      }catch(const invalid_argument & e){
+        throw_error = true;
+      }
+      assert(throw_error);
+
+      throw_error = false;
+      try {
+        CGsystem.hop(walker_id,walker);
+      }catch(const invalid_argument & e){
+        throw_error = true;
+      }
+      assert(throw_error);
+    }
+    assert(CGsystem.getNumberOfWalkers()==2);
+
+    int samples = 0;
+    int hop_count = 0;
+    double last_time = 0.0;
+    auto observer = [&](const double sample_time, const vector<HopEvent> & hops){
+      ++samples;
+      assert(sample_time == 0.5*samples);
+      for(const HopEvent & hop : hops){
+        assert(hop.time >= last_time);
+        assert(hop.time < sample_time);
+        assert(hop.time >= sample_time-0.5);
+        assert(hop.walker_id == 0 || hop.walker_id == 1);
+        last_time = hop.time;
+        ++hop_count;
+      }
+    };
+    CGsystem.run(10.0,observer);
+    assert(samples == 20);
+    assert(hop_count > 0);
+    assert(CGsystem.getTime() == 10.0);
+
+    // Walkers removed while running are no longer hopped
+    bool removed = false;
+    auto remove_walker = [&](const double, const vector<HopEvent> & hops){
+      for(const HopEvent & hop : hops) assert(!removed || hop.walker_id == 0);
+      if(!removed) CGsystem.removeWalker(1);
+      removed = true;
+    };
+    CGsystem.run(20.0,remove_walker);
+    CGsystem.run(30.0,remove_walker);
+    assert(CGsystem.getNumberOfWalkers()==1);
+
+    CGsystem.step(5);
+    assert(CGsystem.getTime() > 30.0);
+    const WalkerStore & walkers = CGsystem.getWalkerStore();
+    assert(walkers.exist(1) == false);
+    assert(walkers.getGlobalTime(0) ==
+        CGsystem.getTime()+walkers.getDwellTime(0));
+  }
+
+  cout << "Testing: run with a drain" << endl;
+  {
+    // Chain of 3 sites ending in a drain, site 3 has no rates off of it
+    //
+    // site0 - site1 - site2 -> site3
+    RateTable rate_table;
+    rate_table.site_ids = {0, 1, 2};
+    rate_table.row_offsets = {0, 1, 3, 5};
+    rate_table.neighbor_ids = {1, 0, 2, 1, 3};
+    rate_table.rates = {1.0, 1.0, 1.0, 1.0, 1.0};
+
+    CoarseGrainSystem CGsystem;
+    CGsystem.setRandomSeed(4);
+    CGsystem.setTimeResolution(0.5);
+    CGsystem.setMinCoarseGrainIterationThreshold(constants::inf_iterations);
+    CGsystem.initializeSystem(rate_table);
+
+    bool throw_error = false;
+    try {
+      CGsystem.addWalker(0,3);
+    }catch(const invalid_argument & e){
+      throw_error = true;
+    }
+    assert(throw_error);
+
+    CGsystem.addWalker(0,0);
+    CGsystem.addWalker(1,2);
+    int drained = 0;
+    auto observer = [&](const double, const vector<HopEvent> & hops){
+      for(const HopEvent & hop : hops){
+        if(hop.to_site_id == 3){
+          assert(hop.from_site_id == 2);
+          ++drained;
+        }
+      }
+    };
+    CGsystem.run(1000.0,observer);
+    assert(drained == 2);
+    assert(CGsystem.getNumberOfDrainedWalkers() == 2);
+    assert(CGsystem.getNumberOfWalkers() == 0);
+    assert(CGsystem.getWalkerStore().exist(0) == false);
+
+    // The drain is left empty so the next walker can reach it too
+    CGsystem.addWalker(0,2);
+    CGsystem.step(1000);
+    assert(CGsystem.getNumberOfDrainedWalkers() == 3);
+    assert(CGsystem.getNumberOfWalkers() == 0);
+  }
 }
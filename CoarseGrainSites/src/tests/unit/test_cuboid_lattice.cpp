@@ -147,3 +147,61 @@ TEST_CASE("Testing: Cuboid lattice neighbors and distances","[unit]") {
     }
   }
 }
+
+TEST_CASE("Testing: Cuboid lattice neighbor list","[unit]") {
+  GIVEN("A cubic lattice of size 6, 7, 8, periodic in x and z") {
+    Cuboid lattice(6,7,8, 1.0, BoundarySetting::Periodic,
+        BoundarySetting::Fixed, BoundarySetting::Periodic);
+    auto neigh_distances = lattice.getNeighborDistances(2.0);
+    THEN("check that the map agrees with the neighbors of each site") {
+      for ( int index = 0; index < 6*7*8; ++index ) {
+        std::vector<std::pair<int,double>> neigh_dists = lattice.getNeighborDistances(index, 2.0);
+        REQUIRE( neigh_dists.size() == neigh_distances[index].size() );
+        for ( auto neigh_dist : neigh_dists ) {
+          REQUIRE( neigh_distances[index].count(neigh_dist.first) == 1 );
+          CHECK( neigh_distances[index][neigh_dist.first] == neigh_dist.second );
+        }
+      }
+    }
+    THEN("check that every thread count gives the same rows as the map") {
+      for ( int thread_count : {1, 4} ) {
+        NeighborList neighbor_list = lattice.getNeighborList(2.0, thread_count);
+        REQUIRE( neighbor_list.row_offsets.size() == 6*7*8+1 );
+        CHECK( neighbor_list.neighbor_indices.size() == neighbor_list.row_offsets.back() );
+        for ( int index = 0; index < 6*7*8; ++index ) {
+          const size_t begin = neighbor_list.row_offsets.at(index);
+          const size_t end = neighbor_list.row_offsets.at(index+1);
+          REQUIRE( end - begin == neigh_distances[index].size() );
+          for ( size_t entry = begin; entry < end; ++entry ) {
+            int neigh_index = neighbor_list.neighbor_indices.at(entry);
+            REQUIRE( neigh_distances[index].count(neigh_index) == 1 );
+            CHECK( neighbor_list.distances.at(entry) == neigh_distances[index][neigh_index] );
+          }
+        }
+      }
+    }
+  }
+
+  GIVEN("A 1D lattice of size 3, periodic in x direction") {
+    Cuboid lattice(3,1,1, 1.0, BoundarySetting::Periodic,
+        BoundarySetting::Fixed, BoundarySetting::Fixed);
+    THEN("check that the closest image of each neighbor is kept") {
+      NeighborList neighbor_list = lattice.getNeighborList(2.0);
+      CHECK( neighbor_list.row_offsets.at(1) == 2 );
+      CHECK( neighbor_list.neighbor_indices.at(0) == 1 );
+      CHECK( neighbor_list.neighbor_indices.at(1) == 2 );
+      CHECK( neighbor_list.distances.at(0) == Approx(1.0) );
+      CHECK( neighbor_list.distances.at(1) == Approx(1.0) );
+    }
+  }
+
+  GIVEN("A cubic lattice of size 4, 4, 4") {
+    Cuboid lattice(4,4,4);
+    THEN("check that an error from the visitor reaches the caller") {
+      CHECK_THROWS_AS( lattice.visitNeighborDistances(1.0,
+            [](const int index, const std::vector<int> &, const std::vector<double> &) {
+              if ( index == 63 ) throw std::invalid_argument("stop");
+            }, 2), std::invalid_argument );
+    }
+  }
+}
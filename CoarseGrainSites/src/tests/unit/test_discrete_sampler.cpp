@@ -0,0 +1,88 @@
+#include <catch2/catch.hpp>
+
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "../../libmythical/discrete_sampler.hpp"
+
+using namespace std;
+using namespace mythical;
+
+TEST_CASE("Testing: Discrete Sampler","[unit]"){
+
+  cout << "Testing: resolveSamplingMethod" << endl;
+  {
+    assert(resolveSamplingMethod(SamplingMethod::alias,1)==SamplingMethod::alias);
+    assert(resolveSamplingMethod(SamplingMethod::automatic,
+          sampling_limits::linear)==SamplingMethod::linear);
+    assert(resolveSamplingMethod(SamplingMethod::automatic,
+          sampling_limits::linear+1)==SamplingMethod::binary_search);
+    assert(resolveSamplingMethod(SamplingMethod::automatic,
+          sampling_limits::binary_search+1)==SamplingMethod::alias);
+  }
+
+  cout << "Testing: empty sampler" << endl;
+  {
+    DiscreteSampler sampler;
+    assert(sampler.size()==0);
+    assert(sampler.sample(0.5)==-1);
+  }
+
+  cout << "Testing: linear and binary search pick the same outcome" << endl;
+  {
+    vector<double> probabilities = { 0.1, 0.4, 0.2, 0.3 };
+    DiscreteSampler linear;
+    linear.build(probabilities,SamplingMethod::linear);
+    DiscreteSampler binary;
+    binary.build(probabilities,SamplingMethod::binary_search);
+
+    assert(linear.sample(0.05)==0);
+    assert(linear.sample(0.1)==1);
+    assert(linear.sample(0.65)==2);
+    assert(linear.sample(0.999)==3);
+    for(int step = 0; step < 1000; ++step){
+      double number = static_cast<double>(step)/1000.0;
+      assert(linear.sample(number)==binary.sample(number));
+    }
+  }
+
+  cout << "Testing: alias sampling frequencies" << endl;
+  {
+    vector<double> probabilities = { 0.05, 0.5, 0.0, 0.15, 0.3 };
+    DiscreteSampler sampler;
+    sampler.build(probabilities,SamplingMethod::alias);
+    assert(sampler.getMethod()==SamplingMethod::alias);
+
+    mt19937 random_engine(3);
+    uniform_real_distribution<double> distribution(0.0,1.0);
+    vector<int> counts(probabilities.size(),0);
+    const int samples = 200000;
+    for(int sample = 0; sample < samples; ++sample){
+      ++counts.at(sampler.sample(distribution(random_engine)));
+    }
+    // An outcome with no probability must never be picked
+    assert(counts.at(2)==0);
+    for(size_t index = 0; index < probabilities.size(); ++index){
+      double frequency = static_cast<double>(counts.at(index))/samples;
+      assert(fabs(frequency-probabilities.at(index))<0.01);
+    }
+  }
+
+  cout << "Testing: buildAliasTable" << endl;
+  {
+    // Weights do not need to be normalized, a uniform distribution should
+    // keep every column
+    vector<double> weights = { 2.0, 2.0, 2.0, 2.0 };
+    vector<double> alias_probabilities(4);
+    vector<int> aliases(4);
+    buildAliasTable(weights.data(),4,alias_probabilities.data(),aliases.data());
+    for(int index = 0; index < 4; ++index){
+      assert(alias_probabilities.at(index)==1.0);
+      assert(sampleAliasTable(alias_probabilities.data(),aliases.data(),4,
+            (index+0.5)/4.0)==index);
+    }
+  }
+}
@@ -0,0 +1,166 @@
+#include <catch2/catch.hpp>
+
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "mythical/charge_transport/boundarysettings.hpp"
+#include "mythical/charge_transport/cuboid_lattice.hpp"
+#include "mythical/constants.hpp"
+#include "mythical/domain_decomposed_system.hpp"
+#include "mythical/rate_network.hpp"
+
+using namespace std;
+using namespace mythical;
+using namespace mythical::charge_transport;
+
+TEST_CASE("Testing: Domain Decomposed System","[unit]"){
+
+  // Hops of the same rate between nearest neighbors
+  auto nearest_neighbor_network = [](const Cuboid & lattice){
+    unordered_map<int,unordered_map<int,double>> rates;
+    for(const auto & site_and_neighbors : lattice.getNeighborDistances(1.0)){
+      for(const auto & neighbor_and_distance : site_and_neighbors.second){
+        rates[site_and_neighbors.first][neighbor_and_distance.first] = 1.0;
+      }
+    }
+    return RateNetwork::create(rates);
+  };
+
+  cout << "Testing: slabsAlongX" << endl;
+  {
+    Cuboid lattice(8,1,1);
+    auto network = nearest_neighbor_network(lattice);
+
+    DomainDecomposedSystem system;
+    system.initializeSystem(network,DomainDecomposedSystem::slabsAlongX(lattice,2));
+    assert(system.getNumberOfDomains()==2);
+    assert(system.getDomainOfSite(lattice.getIndex(1,0,0))==make_pair(0,0));
+    assert(system.getDomainOfSite(lattice.getIndex(2,0,0))==make_pair(0,1));
+    assert(system.getDomainOfSite(lattice.getIndex(4,0,0))==make_pair(1,0));
+    assert(system.getDomainOfSite(lattice.getIndex(7,0,0))==make_pair(1,1));
+
+    // Sublattices of a single site cannot keep the domains apart
+    bool threw = false;
+    try{
+      DomainDecomposedSystem thin_system;
+      thin_system.initializeSystem(network,DomainDecomposedSystem::slabsAlongX(lattice,4));
+    }catch(invalid_argument & e){
+      threw = true;
+    }
+    assert(threw);
+  }
+
+  Cuboid lattice(8,4,4,1.0,BoundarySetting::Periodic,
+      BoundarySetting::Fixed,BoundarySetting::Fixed);
+  auto network = nearest_neighbor_network(lattice);
+
+  // Crowd the lattice so many hops are blocked, returns all the hops
+  auto run_system = [&](const unsigned long seed){
+    DomainDecomposedSystem system;
+    system.setRandomSeed(seed);
+    system.setTimeResolution(1.0);
+    system.setWindowsPerSample(4);
+    system.initializeSystem(network,DomainDecomposedSystem::slabsAlongX(lattice,2));
+    for(int walker_id = 0; walker_id < 96; ++walker_id){
+      system.addWalker(walker_id,walker_id);
+    }
+
+    vector<int> sites_of_walkers(96);
+    for(int walker_id = 0; walker_id < 96; ++walker_id) sites_of_walkers[walker_id] = walker_id;
+    vector<HopEvent> all_hops;
+    int samples = 0;
+    system.run(10.0,[&](const double sample_time, const vector<HopEvent> & hops){
+        ++samples;
+        assert(sample_time==samples*1.0);
+        for(const HopEvent & hop : hops){
+          assert(sites_of_walkers.at(hop.walker_id)==hop.from_site_id);
+          sites_of_walkers.at(hop.walker_id) = hop.to_site_id;
+        }
+        // No two walkers are ever on the same site
+        unordered_set<int> occupied(sites_of_walkers.begin(),sites_of_walkers.end());
+        assert(occupied.size()==sites_of_walkers.size());
+        all_hops.insert(all_hops.end(),hops.begin(),hops.end());
+      });
+    assert(samples==10);
+    assert(system.getTime()==10.0);
+    assert(system.getNumberOfWalkers()==96);
+    for(int walker_id = 0; walker_id < 96; ++walker_id){
+      assert(system.getSiteIdOfWalker(walker_id)==sites_of_walkers[walker_id]);
+    }
+    return all_hops;
+  };
+
+  cout << "Testing: run" << endl;
+  {
+    vector<HopEvent> hops = run_system(4);
+    assert(hops.size()>500);
+    int blocked = 0;
+    for(const HopEvent & hop : hops){
+      if(hop.from_site_id==hop.to_site_id) ++blocked;
+    }
+    assert(blocked>0);
+
+    // The same seed gives the same hops no matter how the threads run
+    vector<HopEvent> repeated_hops = run_system(4);
+    assert(repeated_hops.size()==hops.size());
+    for(size_t hop = 0; hop < hops.size(); ++hop){
+      assert(repeated_hops[hop].walker_id==hops[hop].walker_id);
+      assert(repeated_hops[hop].to_site_id==hops[hop].to_site_id);
+      assert(repeated_hops[hop].time==hops[hop].time);
+    }
+  }
+
+  cout << "Testing: drains" << endl;
+  {
+    // site1 -> site2 -> site3 -> site4 which is a drain
+    unordered_map<int,unordered_map<int,double>> rates;
+    rates[1][2] = 1.0;
+    rates[2][3] = 1.0;
+    rates[3][4] = 1.0;
+    DomainDecomposedSystem system;
+    system.setRandomSeed(2);
+    system.setTimeResolution(10.0);
+    system.initializeSystem(RateNetwork::create(rates),
+        [](const int siteId){ return make_pair(0,siteId%2); });
+
+    bool threw = false;
+    try{
+      system.addWalker(0,4);
+    }catch(invalid_argument & e){
+      threw = true;
+    }
+    assert(threw);
+
+    system.addWalker(0,1);
+    system.addWalker(1,3);
+    threw = false;
+    try{
+      system.addWalker(2,3);
+    }catch(invalid_argument & e){
+      threw = true;
+    }
+    assert(threw);
+
+    // 0 is a valid id, negative ids and ids past the tables are not
+    for(const int walker_id : {-1, constants::max_walker_id+1}){
+      threw = false;
+      try{
+        system.addWalker(walker_id,2);
+      }catch(invalid_argument & e){
+        threw = true;
+      }
+      assert(threw);
+    }
+    assert(system.getNumberOfWalkers()==2);
+
+    system.run(1000.0,SampleObserver());
+    assert(system.getNumberOfWalkers()==0);
+    assert(!system.walkerExists(0));
+    assert(!system.walkerExists(1));
+  }
+}
@@ -99,5 +99,22 @@ TEST_CASE("Testing: graph library adapter","[unit]"){
       assert(found_edge2_1);
       assert(found_edge2_3);
     }
+
+    cout << "Testing: getOutgoingRates" << endl;
+    {
+      const Site_Container & const_container = site_container;
+      OutgoingRates rates = getOutgoingRates(const_container,2);
+      assert(rates.size()==2);
+      // Neighbors are sorted by their id
+      assert(rates.getNeighborId(0)==1);
+      assert(rates.getRate(0)==rate2);
+      assert(rates.getNeighborId(1)==3);
+      assert(rates.getRate(1)==rate3);
+
+      rates = getOutgoingRates(const_container,3);
+      assert(rates.size()==1);
+      assert(rates.getNeighborId(0)==2);
+      assert(rates.getRate(0)==rate4);
+    }
   }
 }
@@ -0,0 +1,106 @@
+#include <catch2/catch.hpp>
+
+#include <iostream>
+#include <cassert>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "../../libmythical/hot_site_sketch.hpp"
+
+using namespace std;
+using namespace mythical;
+
+TEST_CASE("Testing: Hot Site Sketch","[unit]"){
+
+  cout << "Testing: constructor" << endl;
+  {
+    HotSiteSketch sketch(4);
+    assert(sketch.getCapacity()==4);
+    assert(sketch.getHottestSites(4).empty());
+
+    bool threw = false;
+    try{
+      HotSiteSketch empty_sketch(0);
+    }catch(invalid_argument & e){
+      threw = true;
+    }
+    assert(threw);
+  }
+
+  cout << "Testing: visit" << endl;
+  {
+    HotSiteSketch sketch(3);
+    sketch.visit(5);
+    sketch.visit(5);
+    sketch.visit(7);
+    assert(sketch.getVisits(5)==2);
+    assert(sketch.getVisits(7)==1);
+    assert(sketch.getVisits(9)==0);
+
+    sketch.visit(9);
+    // All the counters are in use so site 11 takes over the counter of a
+    // site with the fewest visits, 7 or 9, and counts one more visit
+    sketch.visit(11);
+    assert(sketch.getVisits(11)==2);
+    assert(sketch.getVisits(5)==2);
+    assert(sketch.getVisits(7)+sketch.getVisits(9)==1);
+  }
+
+  cout << "Testing: getHottestSites" << endl;
+  {
+    HotSiteSketch sketch(4);
+    // Sites 3 and 4 are visited far more often than the other sites, they
+    // keep their counters while the cold sites take over each other's
+    for(int visit = 0; visit < 100; ++visit){
+      sketch.visit(3);
+      sketch.visit(3);
+      sketch.visit(4);
+      if(visit%2==0) sketch.visit(100+visit);
+    }
+    vector<int> hottest = sketch.getHottestSites(2);
+    assert(hottest.size()==2);
+    assert(hottest.at(0)==3);
+    assert(hottest.at(1)==4);
+    assert(sketch.getVisits(3)==200);
+    assert(sketch.getVisits(4)==100);
+    assert(sketch.getHottestSites(10).size()==4);
+
+    sketch.clear();
+    assert(sketch.getVisits(3)==0);
+    assert(sketch.getHottestSites(2).empty());
+  }
+
+  cout << "Testing: counts bound the visits" << endl;
+  {
+    // Skewed visits to 50 sites, site k is visited about 1/(k+1) as often
+    // as site 0
+    HotSiteSketch sketch(8);
+    unordered_map<int,long> visits;
+    unsigned long state = 12345;
+    long total = 0;
+    for(int visit = 0; visit < 20000; ++visit){
+      state = state*6364136223846793005UL + 1442695040888963407UL;
+      const double number = static_cast<double>(state >> 11)/9007199254740992.0;
+      const int siteId = static_cast<int>(1.0/(number*0.98+0.02))-1;
+      ++visits[siteId];
+      sketch.visit(siteId);
+      ++total;
+    }
+    // Each visit is added to exactly one counter
+    long counted = 0;
+    for(const int siteId : sketch.getHottestSites(8)){
+      counted += sketch.getVisits(siteId);
+      assert(sketch.getVisits(siteId) >= visits[siteId]);
+    }
+    assert(counted==total);
+
+    vector<int> hottest = sketch.getHottestSites(8);
+    assert(hottest.size()==8);
+    for(size_t site = 1; site < hottest.size(); ++site){
+      assert(sketch.getVisits(hottest[site-1]) >= sketch.getVisits(hottest[site]));
+    }
+    assert(hottest.at(0)==0);
+    assert(hottest.at(1)==1);
+  }
+}
@@ -0,0 +1,62 @@
+
+#include <catch2/catch.hpp>
+
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "mythical/charge_transport/fast_exp.hpp"
+#include "mythical/charge_transport/marcus.hpp"
+
+using namespace std;
+using namespace mythical;
+using namespace mythical::charge_transport;
+
+TEST_CASE("Testing: Marcus rates","[unit]") {
+  GIVEN("Random energies and couplings") {
+    mt19937 random_engine(3);
+    normal_distribution<double> energy(0.0, 0.1);
+    uniform_real_distribution<double> coupling(0.001, 0.01);
+    const size_t count = 1000;
+    vector<double> E_i(count);
+    vector<double> E_j(count);
+    vector<double> H_AB(count);
+    for ( size_t hop = 0; hop < count; ++hop ) {
+      E_i[hop] = energy(random_engine);
+      E_j[hop] = energy(random_engine);
+      H_AB[hop] = coupling(random_engine);
+    }
+    Marcus marcus(0.2, 300.0);
+
+    THEN("check that the exact batch matches getRate") {
+      vector<double> rates(count);
+      marcus.getRates(count, E_i.data(), E_j.data(), H_AB.data(), rates.data());
+      for ( size_t hop = 0; hop < count; ++hop ) {
+        CHECK( rates[hop] == Approx(marcus.getRate(E_i[hop], E_j[hop], H_AB[hop])).epsilon(1e-14) );
+      }
+    }
+
+    THEN("check the error of the fast batch") {
+      vector<double> rates(count);
+      marcus.getRates(count, E_i.data(), E_j.data(), H_AB.data(), rates.data(),
+          ExpPrecision::fast);
+      for ( size_t hop = 0; hop < count; ++hop ) {
+        double rate = marcus.getRate(E_i[hop], E_j[hop], H_AB[hop]);
+        CHECK( std::abs(rates[hop] - rate) <= 1e-8 * rate );
+      }
+    }
+  }
+
+  GIVEN("The fast exponential") {
+    THEN("check the relative error across the range") {
+      for ( double x = -700.0; x <= 700.0; x += 0.0137 ) {
+        double exact = std::exp(x);
+        CHECK( std::abs(fastExp(x) - exact) <= 1e-8 * exact );
+      }
+      CHECK( fastExp(0.0) == 1.0 );
+      CHECK( fastExp(-800.0) == 0.0 );
+    }
+  }
+}
@@ -0,0 +1,155 @@
+#include <catch2/catch.hpp>
+
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "../../libmythical/master_equation_solver.hpp"
+
+using namespace std;
+using namespace mythical;
+
+TEST_CASE("Testing: Master Equation Solver","[unit]"){
+
+  cout << "Testing: Constructor" << endl;
+  {
+    MasterEquationSolver solver;
+    assert(solver.size()==0);
+  }
+
+  // Three sites in a chain with equal rates between them and no rates off
+  // of the chain
+  //
+  // site0 - site1 - site2
+  //
+  // The walker should be on the middle site half the time
+  cout << "Testing: addRow and initializeProbabilities" << endl;
+  {
+    MasterEquationSolver solver;
+    assert(solver.addRow({{1,0.5}},0.0)==0);
+    assert(solver.addRow({{0,1.0},{2,1.0}},0.0)==1);
+    assert(solver.addRow({{1,0.5}},0.0)==2);
+    assert(solver.size()==3);
+    solver.initializeProbabilities();
+    for(const double & probability : solver.getProbabilities()){
+      assert(fabs(probability-1.0/3.0)<1E-12);
+    }
+  }
+
+  cout << "Testing: initializeProbabilities from a guess" << endl;
+  {
+    MasterEquationSolver solver;
+    solver.addRow({{1,0.5}},0.0);
+    solver.addRow({{0,1.0},{2,1.0}},0.0);
+    solver.addRow({{1,0.5}},0.0);
+    solver.initializeProbabilities({1.0,2.0,1.0});
+    assert(fabs(solver.getProbabilities().at(0)-0.25)<1E-12);
+    assert(fabs(solver.getProbabilities().at(1)-0.5)<1E-12);
+    // Already converged so a single sweep is enough
+    assert(solver.sweepUntilConverged(1E-10)==1);
+
+    // Falls back on equal probabilities if the guess is empty
+    solver.initializeProbabilities({0.0,0.0,0.0});
+    assert(fabs(solver.getProbabilities().at(1)-1.0/3.0)<1E-12);
+  }
+
+  cout << "Testing: sweep" << endl;
+  {
+    MasterEquationSolver solver;
+    solver.addRow({{1,0.5}},0.0);
+    solver.addRow({{0,1.0},{2,1.0}},0.0);
+    solver.addRow({{1,0.5}},0.0);
+    solver.initializeProbabilities();
+    double error = solver.sweep();
+    assert(error>0.0);
+    double total = 0.0;
+    for(const double & probability : solver.getProbabilities()){
+      total += probability;
+    }
+    assert(fabs(total-1.0)<1E-12);
+    // Probability should move to the middle site
+    assert(solver.getProbabilities().at(1)>1.0/3.0);
+  }
+
+  cout << "Testing: sweepUntilConverged" << endl;
+  {
+    MasterEquationSolver solver;
+    solver.addRow({{1,0.5}},0.0);
+    solver.addRow({{0,1.0},{2,1.0}},0.0);
+    solver.addRow({{1,0.5}},0.0);
+    solver.initializeProbabilities();
+    long sweeps = solver.sweepUntilConverged(1E-10);
+    assert(sweeps>1);
+    const vector<double> & probabilities = solver.getProbabilities();
+    assert(fabs(probabilities.at(0)-0.25)<1E-8);
+    assert(fabs(probabilities.at(1)-0.5)<1E-8);
+    assert(fabs(probabilities.at(2)-0.25)<1E-8);
+
+    solver.clear();
+    assert(solver.size()==0);
+  }
+
+  // Same chain but the hops between site1 and site2 are a thousand times
+  // less likely than the hops between site0 and site1, some of the
+  // probability also leaks off of site0
+  //
+  // site0 = site1 - site2
+  //
+  // Every method should find the same probabilities
+  auto build_stiff_chain = [](MasterEquationSolver & solver){
+    solver.addRow({{1,0.999}},0.1);
+    solver.addRow({{0,0.9},{2,1.0}},0.0);
+    solver.addRow({{1,0.001}},0.0);
+    solver.initializeProbabilities();
+  };
+
+  MasterEquationSolver reference;
+  build_stiff_chain(reference);
+  long reference_sweeps = reference.sweepUntilConverged(1E-12);
+
+  cout << "Testing: sweepUntilConvergedAccelerated" << endl;
+  {
+    MasterEquationSolver solver;
+    build_stiff_chain(solver);
+    long sweeps = solver.sweepUntilConvergedAccelerated(1E-12);
+    assert(sweeps>0);
+    assert(sweeps<reference_sweeps);
+    double total = 0.0;
+    for(int row = 0; row < solver.size(); ++row){
+      total += solver.getProbabilities().at(row);
+      assert(fabs(solver.getProbabilities().at(row)-reference.getProbabilities().at(row))<1E-8);
+    }
+    assert(fabs(total-1.0)<1E-12);
+  }
+
+  cout << "Testing: solveDirect" << endl;
+  {
+    MasterEquationSolver solver;
+    build_stiff_chain(solver);
+    long factorizations = solver.solveDirect(1E-12);
+    assert(factorizations>0);
+    assert(factorizations<reference_sweeps);
+    for(int row = 0; row < solver.size(); ++row){
+      assert(fabs(solver.getProbabilities().at(row)-reference.getProbabilities().at(row))<1E-8);
+    }
+
+    // A single site has all the probability
+    solver.clear();
+    solver.addRow({},0.0);
+    solver.initializeProbabilities();
+    solver.solveDirect(1E-12);
+    assert(fabs(solver.getProbabilities().at(0)-1.0)<1E-12);
+
+    // Chain without leaks
+    solver.clear();
+    solver.addRow({{1,0.5}},0.0);
+    solver.addRow({{0,1.0},{2,1.0}},0.0);
+    solver.addRow({{1,0.5}},0.0);
+    solver.initializeProbabilities();
+    solver.solveDirect(1E-12);
+    assert(fabs(solver.getProbabilities().at(0)-0.25)<1E-8);
+    assert(fabs(solver.getProbabilities().at(1)-0.5)<1E-8);
+    assert(fabs(solver.getProbabilities().at(2)-0.25)<1E-8);
+  }
+}
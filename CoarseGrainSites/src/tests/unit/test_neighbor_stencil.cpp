@@ -0,0 +1,82 @@
+
+#include <catch2/catch.hpp>
+
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "mythical/charge_transport/cuboid_lattice.hpp"
+#include "mythical/charge_transport/neighbor_stencil.hpp"
+
+using namespace std;
+using namespace mythical;
+using namespace mythical::charge_transport;
+
+TEST_CASE("Testing: Neighbor stencil","[unit]") {
+  GIVEN("A cubic lattice of size 4, 5, 7 with spacing 2.0 and a cutoff of 3.0") {
+    Cuboid lattice(4,5,7, 2.0);
+    NeighborStencil stencil(lattice, 3.0);
+    THEN("check the offsets and distances") {
+      CHECK( stencil.getReach() == 1 );
+      // 6 faces and 12 edges of the surrounding cube
+      CHECK( stencil.size() == 18 );
+      CHECK( stencil.repeatsImages() == false );
+      for ( size_t offset = 0; offset < stencil.size(); ++offset ) {
+        int x = stencil.getOffsetX(offset);
+        int y = stencil.getOffsetY(offset);
+        int z = stencil.getOffsetZ(offset);
+        CHECK( stencil.getIndexDelta(offset) == z*4*5 + y*4 + x );
+        CHECK( stencil.getDistance(offset) == Approx(2.0*std::sqrt(x*x+y*y+z*z)) );
+      }
+    }
+    THEN("check interior and edge sites") {
+      CHECK( stencil.isInterior(lattice.getIndex(1,1,1)) );
+      CHECK( stencil.isInterior(lattice.getIndex(2,3,5)) );
+      CHECK_FALSE( stencil.isInterior(lattice.getIndex(0,1,1)) );
+      CHECK_FALSE( stencil.isInterior(lattice.getIndex(2,4,3)) );
+    }
+  }
+
+  GIVEN("Lattices with fixed and periodic boundaries") {
+    vector<Cuboid> lattices{
+      Cuboid(6,7,8, 1.0),
+      Cuboid(6,7,8, 1.0, BoundarySetting::Periodic,
+          BoundarySetting::Fixed, BoundarySetting::Periodic),
+      Cuboid(6,7,8, 1.0, BoundarySetting::Periodic,
+          BoundarySetting::Periodic, BoundarySetting::Periodic)};
+    THEN("check that every site has the neighbors of the site query") {
+      vector<int> neighbor_indices;
+      vector<double> distances;
+      for ( const Cuboid & lattice : lattices ) {
+        NeighborStencil stencil(lattice, 2.0);
+        for ( int index = 0; index < 6*7*8; ++index ) {
+          vector<pair<int,double>> neigh_dists = lattice.getNeighborDistances(index, 2.0);
+          REQUIRE( stencil.getNeighbors(index, neighbor_indices, distances) == neigh_dists.size() );
+          map<int,double> neighbors;
+          for ( size_t neigh = 0; neigh < neighbor_indices.size(); ++neigh ) {
+            neighbors[neighbor_indices.at(neigh)] = distances.at(neigh);
+          }
+          REQUIRE( neighbors.size() == neigh_dists.size() );
+          for ( auto neigh_dist : neigh_dists ) {
+            REQUIRE( neighbors.count(neigh_dist.first) == 1 );
+            CHECK( neighbors[neigh_dist.first] == neigh_dist.second );
+          }
+        }
+      }
+    }
+  }
+
+  GIVEN("A 1D lattice of size 3, periodic in x direction") {
+    Cuboid lattice(3,1,1, 1.0, BoundarySetting::Periodic,
+        BoundarySetting::Fixed, BoundarySetting::Fixed);
+    NeighborStencil stencil(lattice, 2.0);
+    THEN("check that every image of a neighbor is visited") {
+      CHECK( stencil.repeatsImages() );
+      vector<int> neighbor_indices;
+      vector<double> distances;
+      CHECK( stencil.getNeighbors(0, neighbor_indices, distances) == 4 );
+      CHECK( neighbor_indices == vector<int>({1, 2, 1, 2}) );
+    }
+  }
+}
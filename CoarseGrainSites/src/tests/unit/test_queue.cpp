@@ -3,6 +3,8 @@
 
 #include <cassert>
 #include <iostream>
+#include <stdexcept>
+#include <vector>
 
 #include "mythical/queue.hpp"
 
@@ -107,4 +109,179 @@ TEST_CASE("Testing: Queue","[unit]"){
     assert(pr==pr1);
     assert(kmc_queue.size()==0);
   }
+
+  cout << "Testing: Queue pop and peek" << endl;
+  {
+    Queue kmc_queue;
+    kmc_queue.add({ 1, 23.1});
+    kmc_queue.add({ 3, 10.3});
+    kmc_queue.add({ 2, 0.13});
+    kmc_queue.add({ 0, 5.0});
+    // peek and pop sort the queue first
+    assert(kmc_queue.peek().first == 2 );
+    assert(kmc_queue.isSorted());
+    assert(kmc_queue.pop().first == 2 );
+    assert(kmc_queue.pop().first == 0 );
+    assert(kmc_queue.pop().first == 3 );
+    assert(kmc_queue.pop().first == 1 );
+    assert(kmc_queue.empty());
+  }
+
+  cout << "Testing: Queue update" << endl;
+  {
+    Queue kmc_queue;
+    kmc_queue.sortedAdd({ 1, 23.1});
+    kmc_queue.sortedAdd({ 3, 10.3});
+    kmc_queue.sortedAdd({ 2, 0.13});
+    // Decrease the time of a walker
+    kmc_queue.update({ 1, 0.01});
+    assert(kmc_queue.peek().first == 1 );
+    // Increase the time of a walker
+    kmc_queue.update({ 1, 50.0});
+    assert(kmc_queue.peek().first == 2 );
+    assert(kmc_queue.at(2).first == 1 );
+    assert(kmc_queue.at(2).second == 50.0 );
+
+    bool throw_error = false;
+    try {
+      kmc_queue.update({ 7, 1.0});
+    }catch(const invalid_argument & e){
+      throw_error = true;
+    }
+    assert(throw_error);
+  }
+
+  cout << "Testing: Queue erase and contains" << endl;
+  {
+    Queue kmc_queue;
+    kmc_queue.sortedAdd({ 1, 23.1});
+    kmc_queue.sortedAdd({ 3, 10.3});
+    kmc_queue.sortedAdd({ 2, 0.13});
+    assert(kmc_queue.contains(3));
+    kmc_queue.erase(3);
+    assert(kmc_queue.contains(3) == false);
+    assert(kmc_queue.contains(8) == false);
+    assert(kmc_queue.size()==2);
+    assert(kmc_queue.pop().first == 2 );
+    assert(kmc_queue.pop().first == 1 );
+
+    // Erasing from an unsorted queue keeps the order walkers were added in
+    kmc_queue.add({ 4, 2.0});
+    kmc_queue.add({ 5, 1.0});
+    kmc_queue.add({ 6, 3.0});
+    kmc_queue.erase(5);
+    assert(kmc_queue.pop_current().first == 4 );
+    assert(kmc_queue.pop_current().first == 6 );
+  }
+
+  cout << "Testing: Queue invalid walkers" << endl;
+  {
+    Queue kmc_queue;
+    kmc_queue.add({ 1, 23.1});
+    bool throw_error = false;
+    try {
+      kmc_queue.add({ 1, 2.0});
+    }catch(const invalid_argument & e){
+      throw_error = true;
+    }
+    assert(throw_error);
+
+    throw_error = false;
+    try {
+      kmc_queue.sortedAdd({ -1, 2.0});
+    }catch(const invalid_argument & e){
+      throw_error = true;
+    }
+    assert(throw_error);
+  }
+
+  cout << "Testing: Queue equal times" << endl;
+  {
+    // Walkers with the same time come out in the order they were added or
+    // last updated
+    Queue kmc_queue;
+    for(int walker_id = 0; walker_id < 10; ++walker_id){
+      kmc_queue.sortedAdd({walker_id,1.0});
+    }
+    kmc_queue.update({4,1.0});
+    vector<int> order;
+    while(!kmc_queue.empty()) order.push_back(kmc_queue.pop().first);
+    assert((order==vector<int>{0,1,2,3,5,6,7,8,9,4}));
+
+    kmc_queue.add({3,2.0});
+    kmc_queue.add({1,1.0});
+    kmc_queue.add({2,2.0});
+    kmc_queue.add({0,1.0});
+    assert(kmc_queue.pop().first == 1 );
+    assert(kmc_queue.pop().first == 0 );
+    assert(kmc_queue.pop().first == 3 );
+    assert(kmc_queue.pop().first == 2 );
+  }
+
+  cout << "Testing: Queue pops from the front" << endl;
+  {
+    Queue kmc_queue;
+    for(int walker_id = 0; walker_id < 8; ++walker_id){
+      kmc_queue.add({walker_id,static_cast<double>(8-walker_id)});
+    }
+    // Unsorted walkers are popped in the order they were added
+    assert(kmc_queue.pop_current().first == 0 );
+    assert(kmc_queue.pop_current().first == 1 );
+    assert(kmc_queue.size()==6);
+    assert(kmc_queue.at(0).first == 2 );
+    kmc_queue.erase(4);
+    assert(kmc_queue.at(2).first == 5 );
+
+    // Popping a sorted queue keeps the rest of it sorted
+    kmc_queue.sort();
+    assert(kmc_queue.pop().first == 7 );
+    assert(kmc_queue.at(1).first == 5 );
+    assert(kmc_queue.at(2).first == 3 );
+    kmc_queue.sortedAdd({0,3.5});
+    kmc_queue.update({6,10.0});
+    assert(kmc_queue.pop().first == 5 );
+    assert(kmc_queue.pop().first == 0 );
+    assert(kmc_queue.pop().first == 3 );
+    assert(kmc_queue.pop().first == 2 );
+    assert(kmc_queue.pop().first == 6 );
+    assert(kmc_queue.empty());
+  }
+
+  cout << "Testing: Queue matches sorted order" << endl;
+  {
+    Queue kmc_queue;
+    vector<pair<int,double>> walkers;
+    for(int walker_id = 0; walker_id < 200; ++walker_id){
+      double time = static_cast<double>((walker_id*7919)%211);
+      walkers.push_back({walker_id,time});
+      kmc_queue.sortedAdd(walkers.back());
+    }
+    // Move some of the walkers
+    for(int walker_id = 0; walker_id < 200; walker_id+=3){
+      walkers.at(walker_id).second += 100.5;
+      kmc_queue.update(walkers.at(walker_id));
+    }
+    // Pop half of them, then keep moving the walker at the front
+    double last_time = -1.0;
+    for(int hop = 0; hop < 100; ++hop){
+      auto walker = kmc_queue.pop();
+      assert(walker.second >= last_time);
+      assert(walkers.at(walker.first).second == walker.second);
+      last_time = walker.second;
+    }
+    for(int hop = 0; hop < 300; ++hop){
+      auto walker = kmc_queue.peek();
+      assert(walker.second >= last_time);
+      last_time = walker.second;
+      walkers.at(walker.first).second += static_cast<double>((hop*31)%17);
+      kmc_queue.update(walkers.at(walker.first));
+      assert(kmc_queue.at(1).second >= kmc_queue.at(0).second);
+    }
+    while(!kmc_queue.empty()){
+      auto walker = kmc_queue.pop();
+      assert(walker.second >= last_time);
+      assert(walkers.at(walker.first).second == walker.second);
+      last_time = walker.second;
+    }
+  }
 }
@@ -0,0 +1,140 @@
+#include <catch2/catch.hpp>
+
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <unordered_map>
+
+#include "../../libmythical/rate_graph.hpp"
+
+using namespace std;
+using namespace mythical;
+
+TEST_CASE("Testing: Rate Graph","[unit]"){
+
+  cout << "Testing: Constructor" << endl;
+  {
+    RateGraph rate_graph;
+    assert(rate_graph.getNumberOfRows()==0);
+    assert(rate_graph.getNumberOfEntries()==0);
+  }
+
+  cout << "Testing: addRow" << endl;
+  {
+    RateGraph rate_graph;
+
+    unordered_map<int,double> rates;
+    rates[5] = 1.0;
+    rates[2] = 3.0;
+    rates[9] = 4.0;
+
+    int row = rate_graph.addRow(rates);
+    assert(row==0);
+    row = rate_graph.addRow(vector<pair<int,double>>());
+    assert(row==1);
+
+    assert(rate_graph.getNumberOfRows()==2);
+    assert(rate_graph.getNumberOfEntries()==3);
+    assert(rate_graph.getRowSize(0)==3);
+    assert(rate_graph.getRowSize(1)==0);
+    assert(rate_graph.getSumOfRates(0)==8.0);
+
+    // Entries within a row are sorted by neighbor id
+    assert(rate_graph.getNeighborId(0)==2);
+    assert(rate_graph.getNeighborId(1)==5);
+    assert(rate_graph.getNeighborId(2)==9);
+    assert(rate_graph.getRate(1)==1.0);
+
+    assert(fabs(rate_graph.getCumulativeProbability(0)-0.375)<1E-12);
+    assert(fabs(rate_graph.getCumulativeProbability(1)-0.5)<1E-12);
+    assert(rate_graph.getCumulativeProbability(2)==1.0);
+  }
+
+  cout << "Testing: findEntry" << endl;
+  {
+    RateGraph rate_graph;
+    unordered_map<int,double> rates;
+    rates[1] = 1.0;
+    rates[3] = 1.0;
+    rate_graph.addRow(rates);
+    rates.clear();
+    rates[0] = 2.0;
+    rate_graph.addRow(rates);
+
+    assert(rate_graph.findEntry(0,3)==1);
+    assert(rate_graph.findEntry(1,0)==2);
+    assert(rate_graph.findEntry(0,0)==constants::unassignedId);
+    assert(rate_graph.findEntry(1,3)==constants::unassignedId);
+  }
+
+  cout << "Testing: sampleRow" << endl;
+  {
+    RateGraph rate_graph;
+    unordered_map<int,double> rates;
+    rates[1] = 1.0;
+    rates[2] = 3.0;
+    rate_graph.addRow(rates);
+    rate_graph.addRow(vector<pair<int,double>>());
+
+    assert(rate_graph.sampleRow(0,0.0)==0);
+    assert(rate_graph.sampleRow(0,0.2)==0);
+    assert(rate_graph.sampleRow(0,0.25)==1);
+    assert(rate_graph.sampleRow(0,0.99)==1);
+    assert(rate_graph.sampleRow(1,0.5)==constants::unassignedId);
+  }
+
+  cout << "Testing: resolveNeighborIndices" << endl;
+  {
+    RateGraph rate_graph;
+    unordered_map<int,double> rates;
+    rates[10] = 1.0;
+    rates[20] = 1.0;
+    rate_graph.addRow(rates);
+
+    assert(rate_graph.getNeighborIndex(0)==constants::unassignedId);
+    rate_graph.resolveNeighborIndices([](const int & siteId){ return siteId/10; });
+    assert(rate_graph.getNeighborIndex(0)==1);
+    assert(rate_graph.getNeighborIndex(1)==2);
+  }
+
+  cout << "Testing: getEmptyGraph" << endl;
+  {
+    auto empty_graph = RateGraph::getEmptyGraph();
+    assert(empty_graph->getNumberOfRows()==1);
+    assert(empty_graph->getRowSize(0)==0);
+  }
+
+  cout << "Testing: setSamplingMethod" << endl;
+  {
+    RateGraph rate_graph;
+    unordered_map<int,double> rates;
+    rates[1] = 1.0;
+    rates[2] = 3.0;
+    rate_graph.addRow(rates);
+    rate_graph.setSamplingMethod(SamplingMethod::alias);
+    // Rows added afterwards also get alias tables
+    rates[7] = 4.0;
+    rate_graph.addRow(rates);
+
+    vector<int> counts(rate_graph.getNumberOfEntries(),0);
+    const int samples = 1000;
+    for(int sample = 0; sample < samples; ++sample){
+      double number = (sample+0.5)/samples;
+      int entry = rate_graph.sampleRow(0,number);
+      assert(entry>=0 && entry<2);
+      ++counts.at(entry);
+      entry = rate_graph.sampleRow(1,number);
+      assert(entry>=2 && entry<5);
+      ++counts.at(entry);
+    }
+    assert(abs(counts.at(0)-250)<=2);
+    assert(abs(counts.at(1)-750)<=2);
+    assert(abs(counts.at(2)-125)<=2);
+    assert(abs(counts.at(3)-375)<=2);
+    assert(abs(counts.at(4)-500)<=2);
+
+    rate_graph.setSamplingMethod(SamplingMethod::binary_search);
+    assert(rate_graph.sampleRow(0,0.2)==0);
+    assert(rate_graph.sampleRow(0,0.3)==1);
+  }
+}
@@ -0,0 +1,162 @@
+#include <catch2/catch.hpp>
+
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "mythical/charge_transport/cuboid_lattice.hpp"
+#include "mythical/charge_transport/rate_model.hpp"
+#include "mythical/constants.hpp"
+#include "mythical/rate_network.hpp"
+#include "../../libmythical/rate_graph.hpp"
+
+using namespace std;
+using namespace mythical;
+using namespace mythical::charge_transport;
+
+TEST_CASE("Testing: Rate models","[unit]"){
+
+  cout << "Testing: MillerAbrahams" << endl;
+  {
+    MillerAbrahams miller_abrahams(1.0e12,0.5,300.0);
+    const double kT = constants::k_B*300.0;
+    // Downhill hops are only limited by the distance
+    assert(std::abs(miller_abrahams.getRate(0.1,0.0,1.0)-1.0e12*std::exp(-4.0))<1.0e-3);
+    assert(std::abs(miller_abrahams.getRate(0.0,0.1,1.0)-
+          1.0e12*std::exp(-4.0-0.1/kT))<1.0e-3);
+  }
+
+  cout << "Testing: MarcusModel" << endl;
+  {
+    MarcusModel marcus_model(0.2,300.0,0.01,0.5);
+    Marcus marcus(0.2,300.0);
+    const double rate = marcus.getRate(0.05,-0.02,0.01*std::exp(-2.0));
+    assert(std::abs(marcus_model.getRate(0.05,-0.02,1.0)-rate)<=1.0e-12*rate);
+
+    // More hops than fit in a block
+    const size_t count = 150;
+    vector<double> E_j(count);
+    vector<double> distances(count);
+    for(size_t hop = 0; hop < count; ++hop){
+      E_j.at(hop) = -0.1+0.2*static_cast<double>(hop)/count;
+      distances.at(hop) = 0.5+0.02*static_cast<double>(hop);
+    }
+    vector<double> rates(count);
+    marcus_model.getRates(count,0.05,E_j.data(),distances.data(),rates.data());
+    for(size_t hop = 0; hop < count; ++hop){
+      assert(rates.at(hop)==marcus_model.getRate(0.05,E_j.at(hop),distances.at(hop)));
+    }
+
+    // Both exponentials of the coupling squared are approximated
+    MarcusModel fast_model(0.2,300.0,0.01,0.5,ExpPrecision::fast);
+    assert(fast_model.getPrecision()==ExpPrecision::fast);
+    fast_model.getRates(count,0.05,E_j.data(),distances.data(),rates.data());
+    for(size_t hop = 0; hop < count; ++hop){
+      const double exact = marcus_model.getRate(0.05,E_j.at(hop),distances.at(hop));
+      assert(std::abs(rates.at(hop)-exact)<=4.0e-8*exact);
+    }
+  }
+
+  Cuboid lattice(5,4,6,1.0,BoundarySetting::Periodic,
+      BoundarySetting::Fixed,BoundarySetting::Periodic);
+  mt19937 random_engine(5);
+  normal_distribution<double> distribution(0.0,0.05);
+  vector<double> energies(5*4*6);
+  for(double & energy : energies) energy = distribution(random_engine);
+  MillerAbrahams miller_abrahams(1.0e12,0.5,300.0);
+
+  cout << "Testing: buildRateTable" << endl;
+  {
+    RateTable rate_table = buildRateTable(lattice,1.5,energies,miller_abrahams,3);
+    assert(rate_table.row_offsets.size()==energies.size()+1);
+
+    // Matches the rates built from the map of neighbors
+    auto neigh_distances = lattice.getNeighborDistances(1.5);
+    for(int index = 0; index < 5*4*6; ++index){
+      const int begin = rate_table.row_offsets.at(index);
+      const int end = rate_table.row_offsets.at(index+1);
+      assert(end-begin==static_cast<int>(neigh_distances[index].size()));
+      for(int entry = begin; entry < end; ++entry){
+        const int neigh = rate_table.neighbor_ids.at(entry);
+        assert(rate_table.rates.at(entry)==miller_abrahams.getRate(
+              energies.at(index),energies.at(neigh),neigh_distances[index].at(neigh)));
+      }
+    }
+
+    // A network built from the table is the same as one built from the map
+    unordered_map<int,unordered_map<int,double>> rates;
+    for(int index = 0; index < 5*4*6; ++index){
+      for(int entry = rate_table.row_offsets.at(index);
+          entry < rate_table.row_offsets.at(index+1); ++entry){
+        rates[index][rate_table.neighbor_ids.at(entry)] = rate_table.rates.at(entry);
+      }
+    }
+    auto map_network = RateNetwork::create(rates);
+    auto table_network = RateNetwork::create(rate_table);
+    const RateGraph & map_graph = *map_network->getRateGraph();
+    const RateGraph & table_graph = *table_network->getRateGraph();
+    assert(table_network->getNumberOfSites()==map_network->getNumberOfSites());
+    for(int map_row = 0; map_row < map_graph.getNumberOfRows(); ++map_row){
+      const int row = map_network->getSiteIds().at(map_row);
+      assert(table_graph.getRowSize(row)==map_graph.getRowSize(map_row));
+      assert(table_graph.getSumOfRates(row)==map_graph.getSumOfRates(map_row));
+      for(int entry = 0; entry < table_graph.getRowSize(row); ++entry){
+        const int table_entry = table_graph.getRowBegin(row)+entry;
+        const int map_entry = map_graph.getRowBegin(map_row)+entry;
+        assert(table_graph.getNeighborId(table_entry)==map_graph.getNeighborId(map_entry));
+        assert(table_graph.getCumulativeProbability(table_entry)==
+            map_graph.getCumulativeProbability(map_entry));
+      }
+    }
+
+    bool threw = false;
+    try{
+      buildRateTable(lattice,1.5,vector<double>(3,0.0),miller_abrahams);
+    }catch(invalid_argument & e){
+      threw = true;
+    }
+    assert(threw);
+  }
+
+  cout << "Testing: FunctionModel" << endl;
+  {
+    auto function_model = makeFunctionModel(
+        [](const double E_i, const double E_j, const double distance){
+          return (1.0 + E_i - E_j)/distance;
+        });
+    RateTable serial = buildRateTable(lattice,1.0,energies,function_model);
+    RateTable parallel = buildRateTable(lattice,1.0,energies,function_model,0);
+    assert(serial.row_offsets==parallel.row_offsets);
+    assert(serial.neighbor_ids==parallel.neighbor_ids);
+    assert(serial.rates==parallel.rates);
+    // Nearest neighbors only, y is fixed
+    assert(serial.row_offsets.at(1)==5);
+    assert(serial.rates.at(0)==function_model.getRate(energies.at(0),
+          energies.at(serial.neighbor_ids.at(0)),1.0));
+  }
+
+  cout << "Testing: buildRateTable with MarcusModel" << endl;
+  {
+    MarcusModel marcus_model(0.2,300.0,0.01,0.5);
+    MarcusModel fast_model(0.2,300.0,0.01,0.5,ExpPrecision::fast);
+    RateTable exact = buildRateTable(lattice,2.0,energies,marcus_model,2);
+    RateTable fast = buildRateTable(lattice,2.0,energies,fast_model,2);
+    assert(fast.row_offsets==exact.row_offsets);
+    assert(fast.neighbor_ids==exact.neighbor_ids);
+    auto neigh_distances = lattice.getNeighborDistances(2.0);
+    for(int index = 0; index < 5*4*6; ++index){
+      for(int entry = exact.row_offsets.at(index);
+          entry < exact.row_offsets.at(index+1); ++entry){
+        const int neigh = exact.neighbor_ids.at(entry);
+        const double rate = marcus_model.getRate(energies.at(index),
+            energies.at(neigh),neigh_distances[index].at(neigh));
+        assert(exact.rates.at(entry)==rate);
+        assert(std::abs(fast.rates.at(entry)-rate)<=4.0e-8*rate);
+      }
+    }
+  }
+}
@@ -0,0 +1,361 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <cassert>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "mythical/coarsegrainsystem.hpp"
+#include "mythical/rate_network.hpp"
+#include "mythical/replicas.hpp"
+#include "mythical/walker.hpp"
+#include "../../libmythical/rate_graph.hpp"
+
+using namespace std;
+using namespace mythical;
+
+TEST_CASE("Testing: Rate Network","[unit]"){
+
+  // site1 <-> site2 <-> site3
+  //   ^                   ^
+  //   +-------------------+
+  unordered_map<int,unordered_map<int,double>> rates;
+  rates[1][2] = 1.0;
+  rates[1][3] = 0.5;
+  rates[2][1] = 1.0;
+  rates[2][3] = 2.0;
+  rates[3][1] = 0.5;
+  rates[3][2] = 2.0;
+
+  // Returns the sites visited by a walker starting on site 1
+  auto visit_sites = [](shared_ptr<const RateNetwork> network,
+      const unsigned long seed, const int hops){
+    CoarseGrainSystem system;
+    system.setRandomSeed(seed);
+    system.setTimeResolution(1.0);
+    system.setMinCoarseGrainIterationThreshold(constants::inf_iterations);
+    system.initializeSystem(network);
+
+    vector<pair<int,shared_ptr<Walker>>> walkers;
+    walkers.emplace_back(0,shared_ptr<Walker>(new Walker));
+    walkers.back().second->occupySite(1);
+    system.initializeWalkers(walkers);
+
+    vector<int> visited;
+    for(int hop = 0; hop < hops; ++hop){
+      system.hop(0,walkers.back().second);
+      visited.push_back(walkers.back().second->getIdOfSiteCurrentlyOccupying());
+    }
+    return visited;
+  };
+
+  cout << "Testing: create" << endl;
+  {
+    unordered_map<int,unordered_map<int,double>> rates_with_drain = rates;
+    rates_with_drain[3][4] = 0.1;
+    auto network = RateNetwork::create(rates_with_drain,SamplingMethod::alias);
+    assert(network->getNumberOfSites()==4);
+    assert(network->getSamplingMethod()==SamplingMethod::alias);
+
+    // Every site has a row, the drain has an empty one
+    const vector<int> & siteIds = network->getSiteIds();
+    const RateGraph & graph = *network->getRateGraph();
+    assert(graph.getNumberOfRows()==4);
+    for(int row = 0; row < 4; ++row){
+      const int siteId = siteIds.at(row);
+      if(siteId==4){
+        assert(graph.getRowSize(row)==0);
+      }else{
+        assert(graph.getRowSize(row)==static_cast<int>(rates_with_drain[siteId].size()));
+      }
+      for(int entry = graph.getRowBegin(row); entry < graph.getRowEnd(row); ++entry){
+        const int neigh_row = graph.getNeighborIndex(entry);
+        assert(siteIds.at(neigh_row)==graph.getNeighborId(entry));
+      }
+    }
+  }
+
+  cout << "Testing: create from a rate table" << endl;
+  {
+    // Rows 0 and 1 are joined, row 2 is a drain, the rates of row 1 are not
+    // sorted by neighbor
+    RateTable rate_table;
+    rate_table.row_offsets = {0, 1, 3, 3};
+    rate_table.neighbor_ids = {1, 2, 0};
+    rate_table.rates = {1.0, 0.5, 2.0};
+    auto network = RateNetwork::create(rate_table,SamplingMethod::alias);
+    assert(network->getNumberOfSites()==3);
+    assert(network->getSiteIds()==vector<int>({0, 1, 2}));
+    const RateGraph & graph = *network->getRateGraph();
+    assert(graph.getRowSize(1)==2);
+    assert(graph.getNeighborId(graph.getRowBegin(1))==0);
+    assert(graph.getRate(graph.getRowBegin(1))==2.0);
+    assert(graph.getNeighborIndex(graph.getRowBegin(1))==0);
+    assert(graph.getSumOfRates(1)==2.5);
+    assert(graph.getCumulativeProbability(graph.getRowEnd(1)-1)==1.0);
+    assert(graph.getRowSize(2)==0);
+
+    // Neighbors without a row become drains
+    RateTable outside = rate_table;
+    outside.neighbor_ids.at(0) = 7;
+    outside.neighbor_ids.back() = 7;
+    auto network_with_drain = RateNetwork::create(outside);
+    assert(network_with_drain->getSiteIds()==vector<int>({0, 1, 2, 7}));
+    const RateGraph & drain_graph = *network_with_drain->getRateGraph();
+    assert(drain_graph.getRowSize(3)==0);
+    assert(drain_graph.getNeighborIndex(drain_graph.getRowBegin(0))==3);
+
+    // Rows with their own site ids
+    RateTable with_ids = rate_table;
+    with_ids.site_ids = {10, 11, 12};
+    with_ids.neighbor_ids = {11, 12, 10};
+    auto network_with_ids = RateNetwork::create(with_ids);
+    assert(network_with_ids->getSiteIds()==vector<int>({10, 11, 12}));
+    const RateGraph & ids_graph = *network_with_ids->getRateGraph();
+    assert(ids_graph.getNeighborId(ids_graph.getRowBegin(1))==10);
+    assert(ids_graph.getNeighborIndex(ids_graph.getRowBegin(1))==0);
+
+    bool threw = false;
+    try{
+      RateTable repeated_id = with_ids;
+      repeated_id.site_ids.back() = 10;
+      RateNetwork::create(repeated_id);
+    }catch(invalid_argument & e){
+      threw = true;
+    }
+    assert(threw);
+
+    threw = false;
+    try{
+      RateTable short_offsets = rate_table;
+      short_offsets.row_offsets.back() = 2;
+      RateNetwork::create(short_offsets);
+    }catch(invalid_argument & e){
+      threw = true;
+    }
+    assert(threw);
+
+    threw = false;
+    try{
+      RateTable repeated = rate_table;
+      repeated.neighbor_ids.at(1) = 0;
+      RateNetwork::create(repeated);
+    }catch(invalid_argument & e){
+      threw = true;
+    }
+    assert(threw);
+  }
+
+  cout << "Testing: create from a generator" << endl;
+  {
+    auto network = RateNetwork::create([&rates](const RateSink & add_rate){
+        for(const auto & site_and_rates : rates){
+          for(const auto & neigh_and_rate : site_and_rates.second){
+            add_rate(site_and_rates.first,neigh_and_rate.first,neigh_and_rate.second);
+          }
+        }
+        add_rate(4,5,0.1);
+      });
+    // Site 5 is a drain
+    assert(network->getNumberOfSites()==5);
+    assert(network->getSiteIds().back()==5);
+    const RateGraph & graph = *network->getRateGraph();
+    assert(graph.getRowSize(4)==0);
+    auto map_network = RateNetwork::create(rates);
+    const vector<int> & map_siteIds = map_network->getSiteIds();
+    for(int row = 0; row < 3; ++row){
+      const int map_row = static_cast<int>(find(map_siteIds.begin(),map_siteIds.end(),
+            network->getSiteIds().at(row))-map_siteIds.begin());
+      assert(graph.getSumOfRates(row)==map_network->getRateGraph()->getSumOfRates(map_row));
+    }
+
+    bool threw = false;
+    try{
+      RateNetwork::create([](const RateSink & add_rate){
+          add_rate(1,2,1.0);
+          add_rate(2,1,1.0);
+          add_rate(1,3,1.0);
+        });
+    }catch(invalid_argument & e){
+      threw = true;
+    }
+    assert(threw);
+  }
+
+  cout << "Testing: initializeSystem" << endl;
+  {
+    auto network = RateNetwork::create(rates);
+    CoarseGrainSystem system;
+    system.setTimeResolution(1.0);
+    system.setSamplingMethod(SamplingMethod::binary_search);
+    system.initializeSystem(network);
+    assert(system.getRateNetwork()==network);
+    // The network decides how neighbors are picked
+    assert(system.getSamplingMethod()==SamplingMethod::linear);
+
+    bool threw = false;
+    try{
+      CoarseGrainSystem other_system;
+      other_system.setTimeResolution(1.0);
+      other_system.initializeSystem(shared_ptr<const RateNetwork>());
+    }catch(invalid_argument & e){
+      threw = true;
+    }
+    assert(threw);
+
+    // Drawing per walker the walk does not depend on the order of the rows
+    auto walk = [](CoarseGrainSystem & system_to_walk){
+      vector<pair<int,shared_ptr<Walker>>> walkers;
+      walkers.emplace_back(0,shared_ptr<Walker>(new Walker));
+      walkers.back().second->occupySite(1);
+      system_to_walk.initializeWalkers(walkers);
+      vector<int> visited;
+      for(int hop = 0; hop < 200; ++hop){
+        system_to_walk.hop(0,walkers.back().second);
+        visited.push_back(walkers.back().second->getIdOfSiteCurrentlyOccupying());
+      }
+      return visited;
+    };
+    auto per_walker_system = [](CoarseGrainSystem & new_system){
+      new_system.setRandomSeed(8);
+      new_system.setRandomStreams(CoarseGrainSystem::RandomStreams::per_walker);
+      new_system.setTimeResolution(1.0);
+      new_system.setMinCoarseGrainIterationThreshold(constants::inf_iterations);
+    };
+    CoarseGrainSystem system_from_map;
+    per_walker_system(system_from_map);
+    system_from_map.initializeSystem(rates);
+
+    RateTable rate_table;
+    rate_table.row_offsets = {0, 2, 4, 6};
+    rate_table.neighbor_ids = {2, 3, 1, 3, 1, 2};
+    rate_table.rates = {1.0, 0.5, 1.0, 2.0, 0.5, 2.0};
+    rate_table.site_ids = {1, 2, 3};
+    CoarseGrainSystem system_from_table;
+    per_walker_system(system_from_table);
+    system_from_table.initializeSystem(rate_table);
+
+    CoarseGrainSystem system_from_generator;
+    per_walker_system(system_from_generator);
+    system_from_generator.initializeSystem([&rates](const RateSink & add_rate){
+        for(const auto & site_and_rates : rates){
+          for(const auto & neigh_and_rate : site_and_rates.second){
+            add_rate(site_and_rates.first,neigh_and_rate.first,neigh_and_rate.second);
+          }
+        }
+      });
+
+    vector<int> visited = walk(system_from_map);
+    assert(walk(system_from_table)==visited);
+    assert(walk(system_from_generator)==visited);
+
+    threw = false;
+    try{
+      CoarseGrainSystem system_without_resolution;
+      system_without_resolution.initializeSystem(rate_table);
+    }catch(runtime_error & e){
+      threw = true;
+    }
+    assert(threw);
+
+    // A system initialized from the rates can share its network
+    CoarseGrainSystem system_from_rates;
+    system_from_rates.setTimeResolution(1.0);
+    system_from_rates.initializeSystem(rates);
+    auto shared_network = system_from_rates.getRateNetwork();
+    assert(shared_network->getNumberOfSites()==3);
+    assert(visit_sites(shared_network,3,200)==visit_sites(shared_network,3,200));
+  }
+
+  cout << "Testing: runReplicas" << endl;
+  {
+    auto network = RateNetwork::create(rates);
+
+    // Each replica counts the visits to each site
+    auto count_visits = [&](const int replica){
+      vector<long> visits(3,0);
+      for(const int siteId : visit_sites(network,replica,1000)) ++visits.at(siteId-1);
+      return visits;
+    };
+    auto add_visits = [](vector<long> & total, const vector<long> & visits){
+      for(size_t site = 0; site < total.size(); ++site) total[site] += visits[site];
+    };
+
+    vector<long> serial = runReplicas(6,1,count_visits,add_visits);
+    vector<long> parallel = runReplicas(6,3,count_visits,add_visits);
+    assert(serial==parallel);
+    long total_visits = 0;
+    for(const long & visits : parallel) total_visits += visits;
+    assert(total_visits==6000);
+    // Sites 2 and 3 are joined by the fastest rates
+    assert(parallel.at(1)>parallel.at(0));
+    assert(parallel.at(2)>parallel.at(0));
+
+    // Replicas that coarse grain
+    //
+    // site1 = site2 - site3 = site4 - site5 = site6 - site7 = site8 - site1
+    //
+    // Each = is fast and each - is slow, the pairs are turned into clusters
+    // which are merged as the walker keeps crossing between them
+    unordered_map<int,unordered_map<int,double>> trap_rates;
+    for(int siteId = 1; siteId <= 8; ++siteId){
+      const int next = siteId%8+1;
+      const int previous = (siteId+6)%8+1;
+      trap_rates[siteId][next] = siteId%2 ? 1000.0 : 10.0;
+      trap_rates[siteId][previous] = siteId%2 ? 10.0 : 1000.0;
+    }
+    auto trap_network = RateNetwork::create(trap_rates);
+
+    // The cluster each site ends up in and the visits to each site
+    auto coarse_grain = [&](const int replica){
+      CoarseGrainSystem system;
+      system.setRandomSeed(replica);
+      system.setTimeResolution(100.0);
+      system.setMinCoarseGrainIterationThreshold(20);
+      system.setMaxExplorationCount(8);
+      system.initializeSystem(trap_network);
+      system.addWalker(0,1);
+      system.run(50.0,SampleObserver());
+      vector<long> clusters_and_visits;
+      for(int siteId = 1; siteId <= 8; ++siteId){
+        clusters_and_visits.push_back(system.getClusterIdOfSite(siteId));
+        clusters_and_visits.push_back(system.getVisitFrequencyOfSite(siteId));
+      }
+      return clusters_and_visits;
+    };
+    auto append = [](vector<long> & total, const vector<long> & replica){
+      total.insert(total.end(),replica.begin(),replica.end());
+    };
+    vector<long> serial_clusters = runReplicas(8,1,coarse_grain,append);
+    assert(serial_clusters==runReplicas(8,4,coarse_grain,append));
+    assert(serial_clusters==runReplicas(8,1,coarse_grain,append));
+    bool clustered = false;
+    for(size_t entry = 0; entry < serial_clusters.size(); entry += 2){
+      if(serial_clusters[entry]!=constants::unassignedId) clustered = true;
+    }
+    assert(clustered);
+
+    bool threw = false;
+    try{
+      runReplicas(4,2,[](const int replica){
+            if(replica==2) throw runtime_error("replica failed");
+            return replica;
+          },
+          [](int & total, const int & replica){ total += replica; });
+    }catch(runtime_error & e){
+      threw = true;
+    }
+    assert(threw);
+
+    threw = false;
+    try{
+      runReplicas(0,2,count_visits,add_visits);
+    }catch(invalid_argument & e){
+      threw = true;
+    }
+    assert(threw);
+  }
+}
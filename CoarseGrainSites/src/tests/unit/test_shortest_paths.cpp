@@ -0,0 +1,46 @@
+#include <catch2/catch.hpp>
+
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+#include "../../libmythical/rate_graph.hpp"
+#include "../../libmythical/shortest_paths.hpp"
+
+using namespace std;
+using namespace mythical;
+
+TEST_CASE("Testing: Shortest Paths","[unit]"){
+
+  // Site ids are the rows of the graph
+  //
+  // site0 <-1.0-> site1 <-0.5-> site2 -0.1-> site3
+  //                 |                          |
+  //                 +-----------0.2------------+
+  //
+  // The hop from site3 back to site1 is the only way off of site3
+  RateGraph rate_graph;
+  rate_graph.addRow(unordered_map<int,double>{{1,1.0}});
+  rate_graph.addRow(unordered_map<int,double>{{0,1.0},{2,0.5}});
+  rate_graph.addRow(unordered_map<int,double>{{1,0.5},{3,0.1}});
+  rate_graph.addRow(unordered_map<int,double>{{1,0.2}});
+  rate_graph.resolveNeighborIndices([](const int & siteId){ return siteId; });
+
+  cout << "Testing: maxShortestTime" << endl;
+  {
+    ShortestPaths shortest_paths;
+    // Slowest pair is site0 to site3, 1 + 2 + 10
+    assert(fabs(shortest_paths.maxShortestTime(rate_graph,{0,1,2,3})-13.0)<1E-12);
+    // Without site2 site3 cannot be reached, the slowest pair is site3 to
+    // site0, 5 + 1
+    assert(fabs(shortest_paths.maxShortestTime(rate_graph,{0,1,3})-6.0)<1E-12);
+    assert(fabs(shortest_paths.maxShortestTime(rate_graph,{0,1})-1.0)<1E-12);
+    // Sites that are not connected
+    assert(shortest_paths.maxShortestTime(rate_graph,{0,2})==0.0);
+    assert(shortest_paths.maxShortestTime(rate_graph,{})==0.0);
+    // Memory from the earlier calls does not change the result
+    assert(fabs(shortest_paths.maxShortestTime(rate_graph,{3,2,1,0})-13.0)<1E-12);
+  }
+}
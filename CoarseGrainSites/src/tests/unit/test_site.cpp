@@ -5,6 +5,8 @@
 #include <vector>
 #include <memory>
 
+#include "../../libmythical/random_numbers.hpp"
+#include "../../libmythical/rate_graph.hpp"
 #include "../../libmythical/topologyfeatures/site.hpp"
 
 using namespace std;
@@ -264,4 +266,34 @@ TEST_CASE("Testing: Site","[unit]"){
     cout << site << endl;
 
   }
+
+  cout << "Testing: setFeatureSeeds" << endl;
+  {
+    // Three rows of a graph, each hopping to four neighbors
+    auto rate_graph = make_shared<RateGraph>();
+    for(int row = 0; row < 3; ++row){
+      unordered_map<int,double> neighbors_and_rates;
+      for(int neighId = 1; neighId <= 4; ++neighId){
+        neighbors_and_rates[neighId] = static_cast<double>(neighId);
+      }
+      rate_graph->addRow(neighbors_and_rates);
+    }
+    shared_ptr<const RateGraph> shared_graph = rate_graph;
+
+    // A site seeded from the shared seeds draws the same numbers as a site
+    // given the seed plus its row
+    FeatureSeeds seeds(5);
+    Site site;
+    site.setRateGraph(shared_graph,2);
+    site.setFeatureSeeds(&seeds);
+    Site copy = site;
+    Site reference;
+    reference.setRateGraph(shared_graph,2);
+    reference.setRandomSeed(7);
+    for(int hop = 0; hop < 20; ++hop){
+      const int neighId = reference.pickNewSiteId(0);
+      assert(site.pickNewSiteId(0)==neighId);
+      assert(copy.pickNewSiteId(0)==neighId);
+    }
+  }
 }
@@ -243,4 +243,49 @@ TEST_CASE("Testing: Site Container","[unit]"){
     assert(site_container.getRateToNeighborOfSite(2,1)==rate2_1);
 
   }
+  cout << "Testing: getIndex and buildIndexLookupTable" << endl;
+  {
+    Site_Container site_container;
+    vector<int> siteIds = { 10, 12, 11, 14 };
+    for( const int & siteId : siteIds ){
+      Site site;
+      site.setId(siteId);
+      site_container.addSite(site);
+    }
+
+    // Indices follow the order the sites were added in
+    for( size_t index = 0; index < siteIds.size(); ++index ){
+      assert(site_container.getIndex(siteIds.at(index))==static_cast<int>(index));
+      assert(site_container.getSiteByIndex(index).getId()==siteIds.at(index));
+    }
+
+    bool built = site_container.buildIndexLookupTable();
+    assert(built);
+    for( size_t index = 0; index < siteIds.size(); ++index ){
+      assert(site_container.getIndex(siteIds.at(index))==static_cast<int>(index));
+    }
+
+    // Missing sites must throw both inside and outside of the table range
+    vector<int> missingIds = { 13, 9, 15 };
+    for( const int & missingId : missingIds ){
+      bool throw_error = false;
+      try{
+        site_container.getIndex(missingId);
+      }catch(...){
+        throw_error = true;
+      }
+      assert(throw_error);
+    }
+
+    // Sparse ids should fall back on the hash map
+    Site_Container sparse_container;
+    Site site;
+    site.setId(0);
+    sparse_container.addSite(site);
+    site.setId(1000000);
+    sparse_container.addSite(site);
+    built = sparse_container.buildIndexLookupTable();
+    assert(built==false);
+    assert(sparse_container.getIndex(1000000)==1);
+  }
 }
@@ -0,0 +1,82 @@
+#include <catch2/catch.hpp>
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+
+#include "mythical/constants.hpp"
+#include "../../libmythical/walker_random_streams.hpp"
+
+using namespace std;
+using namespace mythical;
+
+TEST_CASE("Testing: WalkerRandomStreams","[unit]"){
+
+  cout << "Testing: philox" << endl;
+  {
+    // Known answers published with the Random123 library
+    array<uint32_t,4> bits = WalkerRandomStreams::philox({0,0,0,0},{0,0});
+    assert((bits==array<uint32_t,4>{0x6627e8d5,0xe169c58d,0xbc57ac4c,0x9b00dbd8}));
+
+    bits = WalkerRandomStreams::philox(
+        {0xffffffff,0xffffffff,0xffffffff,0xffffffff},{0xffffffff,0xffffffff});
+    assert((bits==array<uint32_t,4>{0x408f276d,0x41c83b0e,0xa20bc7c6,0x6d5451fd}));
+
+    bits = WalkerRandomStreams::philox(
+        {0x243f6a88,0x85a308d3,0x13198a2e,0x03707344},{0xa4093822,0x299f31d0});
+    assert((bits==array<uint32_t,4>{0xd16cfe09,0x94fdcceb,0x5001e420,0x24126ea1}));
+  }
+
+  cout << "Testing: draw" << endl;
+  {
+    WalkerRandomStreams streams(7);
+    assert(streams.getSeed()==7);
+    assert(streams.getDrawCount(3)==0);
+
+    double sum = 0.0;
+    const int draws = 10000;
+    for(int draw = 0; draw < draws; ++draw){
+      const double number = streams.draw(3);
+      assert(number >= 0.0 && number < 1.0);
+      assert(number==WalkerRandomStreams::uniform(7,3,draw));
+      sum += number;
+    }
+    assert(streams.getDrawCount(3)==static_cast<uint64_t>(draws));
+    assert(sum/draws > 0.49 && sum/draws < 0.51);
+
+    // Other walkers and seeds have their own streams
+    assert(streams.getDrawCount(1)==0);
+    assert(streams.draw(1)!=WalkerRandomStreams::uniform(7,3,0));
+    assert(WalkerRandomStreams::uniform(8,3,0)!=WalkerRandomStreams::uniform(7,3,0));
+
+    // A walker reusing the id does not repeat the numbers of the last one
+    assert(streams.getGeneration(3)==0);
+    streams.reset(3);
+    assert(streams.getDrawCount(3)==0);
+    assert(streams.getGeneration(3)==1);
+    const double number = streams.draw(3);
+    assert(number==WalkerRandomStreams::uniform(7,3,0,1));
+    assert(number!=WalkerRandomStreams::uniform(7,3,0));
+
+    // Ids that have not drawn yet keep their first stream
+    streams.reset(5);
+    assert(streams.getGeneration(5)==0);
+    assert(streams.draw(5)==WalkerRandomStreams::uniform(7,5,0));
+
+    // Ids outside of the tables are rejected rather than read past them
+    for(const int walker_id : {-1, constants::max_walker_id+1}){
+      bool throw_error = false;
+      try {
+        streams.draw(walker_id);
+      }catch(const invalid_argument & e){
+        throw_error = true;
+      }
+      assert(throw_error);
+      streams.reset(walker_id);
+      assert(streams.getDrawCount(walker_id)==0);
+      assert(streams.getGeneration(walker_id)==0);
+    }
+  }
+}
@@ -0,0 +1,83 @@
+
+#include <catch2/catch.hpp>
+
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+
+#include "mythical/constants.hpp"
+#include "mythical/walker_store.hpp"
+
+using namespace std;
+using namespace mythical;
+
+TEST_CASE("Testing: walker store","[unit]") {
+
+  cout << "Testing: WalkerStore constructor" << endl;
+  {
+    WalkerStore walkers;
+    assert(walkers.size() == 0);
+    assert(walkers.exist(0) == false);
+  }
+
+  cout << "Testing: WalkerStore add and remove" << endl;
+  {
+    WalkerStore walkers;
+    walkers.add(0,5);
+    walkers.add(3,7);
+    assert(walkers.size() == 2);
+    assert(walkers.capacity() == 4);
+    assert(walkers.exist(0));
+    assert(walkers.exist(1) == false);
+    assert(walkers.exist(3));
+    assert(walkers.getSiteId(3) == 7);
+    assert(walkers.getPotentialSiteId(3) == constants::unassignedId);
+
+    bool throw_error = false;
+    try {
+      walkers.add(3,2);
+    }catch(const invalid_argument & e){
+      throw_error = true;
+    }
+    assert(throw_error);
+
+    walkers.remove(3);
+    assert(walkers.size() == 1);
+    assert(walkers.exist(3) == false);
+    assert(walkers.getSiteIds().at(3) == constants::unassignedId);
+
+    throw_error = false;
+    try {
+      walkers.remove(3);
+    }catch(const invalid_argument & e){
+      throw_error = true;
+    }
+    assert(throw_error);
+
+    // The index can be reused
+    walkers.add(3,1);
+    assert(walkers.getSiteId(3) == 1);
+  }
+
+  cout << "Testing: WalkerStore set and get" << endl;
+  {
+    WalkerStore walkers;
+    walkers.add(1,5);
+    walkers.setSiteId(1,6);
+    walkers.setPotentialSiteId(1,4);
+    walkers.setDwellTime(1,2.5);
+    walkers.setGlobalTime(1,10.5);
+    assert(walkers.getSiteId(1) == 6);
+    assert(walkers.getPotentialSiteId(1) == 4);
+    assert(walkers.getDwellTime(1) == 2.5);
+    assert(walkers.getGlobalTime(1) == 10.5);
+    assert(walkers.getDwellTimes().at(1) == 2.5);
+    assert(walkers.getGlobalTimes().at(1) == 10.5);
+    assert(walkers.getPotentialSiteIds().at(1) == 4);
+
+    Walker walker = walkers.getWalker(1);
+    assert(walker.getIdOfSiteCurrentlyOccupying() == 6);
+    assert(walker.getPotentialSite() == 4);
+    assert(walker.getDwellTime() == 2.5);
+  }
+}